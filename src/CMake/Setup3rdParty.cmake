@@ -89,6 +89,12 @@ endif()
 ################################
 include(CMake/thirdparty/SetupConduit.cmake)
 
+################################
+# Threads
+# (web streaming runs its own thread)
+################################
+find_package(Threads REQUIRED)
+
 
 ################################################################
 ################################################################
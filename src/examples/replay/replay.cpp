@@ -0,0 +1,159 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: replay.cpp
+///
+/// Replays cycles saved by the blueprint_hdf5 pipeline:
+///
+///   replay_ser [--options opts.json] [--actions actions.json]
+///              [--iterations N] [--timings timings.json]
+///              cycle_000010.root cycle_000020.root ...
+///
+//-----------------------------------------------------------------------------
+
+#include <strawman.hpp>
+#include <strawman_replay.hpp>
+
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+
+#ifdef PARALLEL
+#include <mpi.h>
+#endif
+
+using namespace conduit;
+using namespace strawman;
+
+//-----------------------------------------------------------------------------
+void
+usage()
+{
+    std::cout << "usage: replay [--options opts.json] [--actions actions.json]"
+              << " [--iterations N] [--timings timings.json]"
+              << " root_file [root_file ...]" << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+int
+main(int argc, char *argv[])
+{
+    int rank = 0;
+#ifdef PARALLEL
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+
+    Node options;
+    std::string timings_file;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if(arg == "--options" && has_value)
+        {
+            options["strawman_options"].load(argv[++i], "json");
+        }
+        else if(arg == "--actions" && has_value)
+        {
+            options["actions"].load(argv[++i], "json");
+        }
+        else if(arg == "--iterations" && has_value)
+        {
+            options["iterations"] = atoi(argv[++i]);
+        }
+        else if(arg == "--timings" && has_value)
+        {
+            timings_file = argv[++i];
+        }
+        else if(arg.size() > 2 && arg.substr(0, 2) == "--")
+        {
+            usage();
+            return 1;
+        }
+        else
+        {
+            options["root_files"].append() = arg;
+        }
+    }
+
+    if(!options.has_child("root_files"))
+    {
+        usage();
+        return 1;
+    }
+
+#ifdef PARALLEL
+    options["mpi_comm"] = MPI_Comm_c2f(MPI_COMM_WORLD);
+#endif
+
+    Replay replay;
+    replay.Run(options);
+
+    if(rank == 0)
+    {
+        const Node &timings = replay.Timings();
+        std::cout << "open:    " << timings["open"].to_float64()  << std::endl
+                  << "load:    " << timings["total/load"].to_float64() << std::endl
+                  << "publish: " << timings["total/publish"].to_float64() << std::endl
+                  << "execute: " << timings["total/execute"].to_float64() << std::endl
+                  << "close:   " << timings["close"].to_float64() << std::endl;
+
+        if(!timings_file.empty())
+        {
+            timings.save(timings_file, "json");
+        }
+    }
+
+#ifdef PARALLEL
+    MPI_Finalize();
+#endif
+
+    return 0;
+}
+
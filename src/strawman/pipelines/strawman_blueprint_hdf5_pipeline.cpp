@@ -51,224 +51,2366 @@
 
 #include "strawman_blueprint_hdf5_pipeline.hpp"
 #include <strawman_file_system.hpp>
+#include <strawman_hash.hpp>
+#include <strawman_mutex_lock.hpp>
+#include <strawman_lossy_codec.hpp>
+#include <strawman_raw_file.hpp>
 
 // standard lib includes
 #include <iostream>
 #include <string.h>
 #include <limits.h>
 #include <cstdlib>
+#include <deque>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/time.h>
 
 //-----------------------------------------------------------------------------
 // thirdparty includes
 //-----------------------------------------------------------------------------
 
-// conduit includes
-#include <conduit_relay.hpp>
-#include <conduit_blueprint.hpp>
+// conduit includes
+#include <conduit_relay.hpp>
+#include <conduit_relay_hdf5.hpp>
+#include <conduit_blueprint.hpp>
+
+// mpi related includes
+#ifdef PARALLEL
+#include <mpi.h>
+// -- conduit relay mpi
+#include <conduit_relay_mpi.hpp>
+#endif
+
+#include <sstream>
+
+using namespace conduit;
+using namespace conduit::relay;
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+// async saves we let queue up before a save waits on the oldest one
+const int DEFAULT_MAX_PENDING_SAVES = 2;
+
+//-----------------------------------------------------------------------------
+// creates (or truncates) an hdf5 file. the file's directory is only 
+// created if the first attempt fails, so the common case costs no extra
+// metadata operations. returns -1 on failure.
+//-----------------------------------------------------------------------------
+hid_t
+create_hdf5_file(const std::string &file_path)
+{
+    hid_t h5_file_id = -1;
+
+    // a missing directory is expected, don't let hdf5 report it
+    H5E_BEGIN_TRY
+    {
+        h5_file_id = H5Fcreate(file_path.c_str(),
+                               H5F_ACC_TRUNC,
+                               H5P_DEFAULT,
+                               H5P_DEFAULT);
+    }
+    H5E_END_TRY;
+
+    if(h5_file_id < 0 && create_file_directory(file_path))
+    {
+        h5_file_id = H5Fcreate(file_path.c_str(),
+                               H5F_ACC_TRUNC,
+                               H5P_DEFAULT,
+                               H5P_DEFAULT);
+    }
+
+    return h5_file_id;
+}
+
+//-----------------------------------------------------------------------------
+// true if we may call hdf5 from the writer thread while the simulation 
+// makes hdf5 calls of its own
+//-----------------------------------------------------------------------------
+bool
+hdf5_is_thread_safe()
+{
+    hbool_t thread_safe = 0;
+#if H5_VERSION_GE(1, 8, 16)
+    if(H5is_library_threadsafe(&thread_safe) < 0)
+    {
+        return false;
+    }
+#endif
+    return thread_safe > 0;
+}
+
+// elements per chunk of compressed datasets
+const hsize_t DEFAULT_CHUNK_SIZE = 65536;
+
+//-----------------------------------------------------------------------------
+double
+elapsed_seconds(const timeval &start)
+{
+    timeval end;
+    gettimeofday(&end, NULL);
+    return (double)(end.tv_sec - start.tv_sec) + 
+           (double)(end.tv_usec - start.tv_usec) / 1000000.0;
+}
+
+//-----------------------------------------------------------------------------
+// numeric leaf types we write with the hdf5 api, as codes we can send to
+// other ranks. -1 for types we leave to relay.
+//-----------------------------------------------------------------------------
+int
+numeric_dtype_code(const DataType &dtype)
+{
+    if(dtype.is_int8())    return 0;
+    if(dtype.is_int16())   return 1;
+    if(dtype.is_int32())   return 2;
+    if(dtype.is_int64())   return 3;
+    if(dtype.is_uint8())   return 4;
+    if(dtype.is_uint16())  return 5;
+    if(dtype.is_uint32())  return 6;
+    if(dtype.is_uint64())  return 7;
+    if(dtype.is_float32()) return 8;
+    if(dtype.is_float64()) return 9;
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+hid_t
+numeric_hdf5_dtype(int code)
+{
+    switch(code)
+    {
+        case 0: return H5T_NATIVE_INT8;
+        case 1: return H5T_NATIVE_INT16;
+        case 2: return H5T_NATIVE_INT32;
+        case 3: return H5T_NATIVE_INT64;
+        case 4: return H5T_NATIVE_UINT8;
+        case 5: return H5T_NATIVE_UINT16;
+        case 6: return H5T_NATIVE_UINT32;
+        case 7: return H5T_NATIVE_UINT64;
+        case 8: return H5T_NATIVE_FLOAT;
+        case 9: return H5T_NATIVE_DOUBLE;
+        default: return -1;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// native hdf5 type of a numeric leaf, -1 for types we leave to relay
+//-----------------------------------------------------------------------------
+hid_t
+native_hdf5_dtype(const DataType &dtype)
+{
+    return numeric_hdf5_dtype(numeric_dtype_code(dtype));
+}
+
+//-----------------------------------------------------------------------------
+// true if the compression options select the array at path:
+// fields by name (default all), coordsets and topologies unless excluded
+//-----------------------------------------------------------------------------
+bool
+compression_selects(const Node &compression, const std::string &path)
+{
+    std::string top, rest;
+    conduit::utils::split_string(path, "/", top, rest);
+
+    if(top == "coordsets" || top == "topologies")
+    {
+        return !compression.has_child("topology") || 
+               compression["topology"].as_string() != "false";
+    }
+
+    if(top != "fields")
+    {
+        return false;
+    }
+
+    if(!compression.has_child("fields"))
+    {
+        return true;
+    }
+
+    std::string field_name, field_path;
+    conduit::utils::split_string(rest, "/", field_name, field_path);
+
+    const Node &fields = compression["fields"];
+    if(fields.dtype().is_string())
+    {
+        return fields.as_string() == field_name;
+    }
+
+    NodeConstIterator itr = fields.children();
+    while(itr.has_next())
+    {
+        if(itr.next().as_string() == field_name)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// splits data into numeric arrays we write with the hdf5 api and an
+// (external) tree of everything else, which relay writes. with a 
+// compression node only the arrays it selects are split off.
+//-----------------------------------------------------------------------------
+void
+split_arrays(const Node &node,
+             const std::string &path,
+             const Node *compression,
+             Node &plain,
+             std::vector<std::string> &arrays)
+{
+    index_t num_children = node.number_of_children();
+    if(num_children > 0)
+    {
+        NodeConstIterator itr = node.children();
+        while(itr.has_next())
+        {
+            const Node &child = itr.next();
+            std::string child_path = itr.name();
+            if(!path.empty())
+            {
+                child_path = path + "/" + child_path;
+            }
+            split_arrays(child, child_path, compression, plain, arrays);
+        }
+        return;
+    }
+
+    if(path.empty())
+    {
+        return;
+    }
+
+    if(node.dtype().number_of_elements() > 1 &&
+       native_hdf5_dtype(node.dtype()) >= 0 &&
+       (compression == NULL || compression_selects(*compression, path)))
+    {
+        arrays.push_back(path);
+    }
+    else
+    {
+        plain[path].set_external(const_cast<Node&>(node));
+    }
+}
+
+//-----------------------------------------------------------------------------
+// writes one leaf as a chunked dataset with the compression filters and 
+// adds its sizes and write time to stats[path]
+//-----------------------------------------------------------------------------
+void
+write_compressed(const Node &leaf,
+                 hid_t h5_id,
+                 const std::string &path,
+                 const Node &compression,
+                 Node &stats)
+{
+    timeval start;
+    gettimeofday(&start, NULL);
+
+    Node n_compact;
+    const Node *src = &leaf;
+    if(!leaf.dtype().is_compact())
+    {
+        leaf.compact_to(n_compact);
+        src = &n_compact;
+    }
+
+    hid_t   h5_dtype     = native_hdf5_dtype(leaf.dtype());
+    hsize_t num_elements = (hsize_t) leaf.dtype().number_of_elements();
+
+    hsize_t chunk_size = DEFAULT_CHUNK_SIZE;
+    if(compression.has_child("chunk_size") &&
+       compression["chunk_size"].to_int64() > 0)
+    {
+        chunk_size = (hsize_t) compression["chunk_size"].to_int64();
+    }
+    // chunks can't be larger than a fixed size dataset
+    if(chunk_size > num_elements)
+    {
+        chunk_size = num_elements;
+    }
+
+    hid_t h5_dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(h5_dcpl_id, 1, &chunk_size);
+
+    if(compression.has_child("shuffle") &&
+       compression["shuffle"].as_string() == "true")
+    {
+        H5Pset_shuffle(h5_dcpl_id);
+    }
+
+    if(compression.has_child("gzip") &&
+       compression["gzip"].to_int() > 0)
+    {
+        if(H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0)
+        {
+            H5Pset_deflate(h5_dcpl_id, compression["gzip"].to_int());
+        }
+        else
+        {
+            STRAWMAN_INFO("HDF5 was built without gzip, writing " 
+                          << path << " without it");
+        }
+    }
+
+    hid_t h5_lcpl_id = H5Pcreate(H5P_LINK_CREATE);
+    H5Pset_create_intermediate_group(h5_lcpl_id, 1);
+
+    hid_t h5_space_id = H5Screate_simple(1, &num_elements, NULL);
+
+    hid_t h5_dset_id = H5Dcreate2(h5_id,
+                                  path.c_str(),
+                                  h5_dtype,
+                                  h5_space_id,
+                                  h5_lcpl_id,
+                                  h5_dcpl_id,
+                                  H5P_DEFAULT);
+
+    herr_t h5_status = -1;
+    hsize_t stored_bytes = 0;
+    if(h5_dset_id >= 0)
+    {
+        h5_status = H5Dwrite(h5_dset_id,
+                             h5_dtype,
+                             H5S_ALL,
+                             H5S_ALL,
+                             H5P_DEFAULT,
+                             src->element_ptr(0));
+        stored_bytes = H5Dget_storage_size(h5_dset_id);
+        H5Dclose(h5_dset_id);
+    }
+
+    H5Sclose(h5_space_id);
+    H5Pclose(h5_lcpl_id);
+    H5Pclose(h5_dcpl_id);
+
+    if(h5_status < 0)
+    {
+        STRAWMAN_ERROR("Error: failed to write compressed dataset " << path);
+    }
+
+    float64 raw_bytes = (float64) leaf.dtype().bytes_compact();
+    float64 seconds   = elapsed_seconds(start);
+
+    Node &entry = stats[path];
+    if(entry.has_child("raw_bytes"))
+    {
+        raw_bytes += entry["raw_bytes"].to_float64();
+        seconds   += entry["seconds"].to_float64();
+        stored_bytes += (hsize_t) entry["stored_bytes"].to_float64();
+    }
+
+    entry["raw_bytes"]    = raw_bytes;
+    entry["stored_bytes"] = (float64) stored_bytes;
+    entry["seconds"]      = seconds;
+}
+
+//-----------------------------------------------------------------------------
+// writes data under h5_id, compressing the arrays the options select
+//-----------------------------------------------------------------------------
+void
+write_tree(const Node &data,
+           hid_t h5_id,
+           const Node &compression,
+           Node &stats)
+{
+    if(compression.dtype().is_empty())
+    {
+        relay::io::hdf5_write(data, h5_id);
+        return;
+    }
+
+    Node plain;
+    std::vector<std::string> compressed;
+    split_arrays(data, "", &compression, plain, compressed);
+
+    if(plain.number_of_children() > 0)
+    {
+        relay::io::hdf5_write(plain, h5_id);
+    }
+
+    for(size_t i = 0; i < compressed.size(); ++i)
+    {
+        write_compressed(data[compressed[i]],
+                         h5_id,
+                         compressed[i],
+                         compression,
+                         stats);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// adds compression ratio and throughput to each stats entry and logs them
+//-----------------------------------------------------------------------------
+void
+summarize_write_stats(Node &stats, const std::string &file_name)
+{
+    NodeIterator itr = stats.children();
+    while(itr.has_next())
+    {
+        Node &entry = itr.next();
+        if(!entry.has_child("raw_bytes"))
+        {
+            // paths nest, e.g. fields/pressure/values
+            summarize_write_stats(entry, file_name);
+            continue;
+        }
+
+        float64 raw_bytes    = entry["raw_bytes"].to_float64();
+        float64 stored_bytes = entry["stored_bytes"].to_float64();
+        float64 seconds      = entry["seconds"].to_float64();
+
+        float64 ratio = stored_bytes > 0 ? raw_bytes / stored_bytes : 0.0;
+        float64 mb_per_second = seconds > 0 ? 
+                                raw_bytes / (1024.0 * 1024.0) / seconds : 0.0;
+
+        entry["ratio"]         = ratio;
+        entry["mb_per_second"] = mb_per_second;
+
+        STRAWMAN_INFO("Compressed " << entry.path() 
+                      << " in " << file_name
+                      << ": " << raw_bytes << " -> " << stored_bytes 
+                      << " bytes (ratio " << ratio << ", "
+                      << mb_per_second << " MB/s)");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// logs the ratio and max error of each lossy encoded array
+//-----------------------------------------------------------------------------
+void
+log_lossy_stats(const Node &stats, const std::string &path)
+{
+    NodeConstIterator itr = stats.children();
+    while(itr.has_next())
+    {
+        const Node &entry = itr.next();
+        std::string entry_path = path.empty() ? itr.name() 
+                                              : path + "/" + itr.name();
+        if(!entry.has_child("ratio"))
+        {
+            // multi component fields, e.g. velocity/x
+            log_lossy_stats(entry, entry_path);
+            continue;
+        }
+
+        STRAWMAN_INFO("Lossy encoded field " << entry_path
+                      << ": ratio " << entry["ratio"].to_float64()
+                      << ", max error " << entry["max_error"].to_float64()
+                      << " (bound " << entry["error_bound"].to_float64()
+                      << ", " << entry["outliers"].to_int64() 
+                      << " outliers)");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// widens [vmin, vmax] by the values of a numeric leaf, skipping nans
+//-----------------------------------------------------------------------------
+template<typename T>
+void
+update_leaf_range(const Node &leaf, float64 &vmin, float64 &vmax)
+{
+    index_t num_elements = leaf.dtype().number_of_elements();
+    for(index_t i = 0; i < num_elements; ++i)
+    {
+        float64 value = (float64) *(const T*) leaf.element_ptr(i);
+        if(value != value)
+        {
+            continue;
+        }
+        if(value < vmin) vmin = value;
+        if(value > vmax) vmax = value;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// widens [vmin, vmax] by all numeric leaves of node
+//-----------------------------------------------------------------------------
+void
+update_range(const Node &node, float64 &vmin, float64 &vmax)
+{
+    index_t num_children = node.number_of_children();
+    for(index_t i = 0; i < num_children; ++i)
+    {
+        update_range(node.child(i), vmin, vmax);
+    }
+
+    if(num_children > 0)
+    {
+        return;
+    }
+
+    switch(numeric_dtype_code(node.dtype()))
+    {
+        case 0: update_leaf_range<int8>(node, vmin, vmax);    break;
+        case 1: update_leaf_range<int16>(node, vmin, vmax);   break;
+        case 2: update_leaf_range<int32>(node, vmin, vmax);   break;
+        case 3: update_leaf_range<int64>(node, vmin, vmax);   break;
+        case 4: update_leaf_range<uint8>(node, vmin, vmax);   break;
+        case 5: update_leaf_range<uint16>(node, vmin, vmax);  break;
+        case 6: update_leaf_range<uint32>(node, vmin, vmax);  break;
+        case 7: update_leaf_range<uint64>(node, vmin, vmax);  break;
+        case 8: update_leaf_range<float32>(node, vmin, vmax); break;
+        case 9: update_leaf_range<float64>(node, vmin, vmax); break;
+        default: break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// xmin, xmax, ymin, ymax, zmin, zmax of a coordset, nan for missing axes
+//-----------------------------------------------------------------------------
+void
+coordset_bounds(const Node &coords, float64 bounds[6])
+{
+    const float64 nan = std::numeric_limits<float64>::quiet_NaN();
+    const char *axes[3]    = {"x", "y", "z"};
+    const char *dims[3]    = {"i", "j", "k"};
+    const char *spacing[3] = {"dx", "dy", "dz"};
+
+    std::string type = coords.has_child("type") ? 
+                       coords["type"].as_string() : "";
+
+    for(int a = 0; a < 3; ++a)
+    {
+        float64 vmin = std::numeric_limits<float64>::max();
+        float64 vmax = -std::numeric_limits<float64>::max();
+
+        if(type == "uniform")
+        {
+            if(coords.has_path(std::string("dims/") + dims[a]))
+            {
+                float64 origin = 0.0;
+                float64 delta  = 1.0;
+                if(coords.has_path(std::string("origin/") + axes[a]))
+                {
+                    origin = coords["origin"][axes[a]].to_float64();
+                }
+                if(coords.has_path(std::string("spacing/") + spacing[a]))
+                {
+                    delta = coords["spacing"][spacing[a]].to_float64();
+                }
+                float64 end = origin + 
+                              delta * (coords["dims"][dims[a]].to_float64() - 1.0);
+                vmin = origin < end ? origin : end;
+                vmax = origin < end ? end : origin;
+            }
+        }
+        else if(coords.has_path(std::string("values/") + axes[a]))
+        {
+            update_range(coords["values"][axes[a]], vmin, vmax);
+        }
+
+        bounds[2 * a]     = vmin <= vmax ? vmin : nan;
+        bounds[2 * a + 1] = vmin <= vmax ? vmax : nan;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// flattens a node into schema json, a null and its compact data
+//-----------------------------------------------------------------------------
+void
+pack_node(const Node &node, std::vector<char> &buffer)
+{
+    Node n_compact;
+    node.compact_to(n_compact);
+
+    std::string schema = n_compact.schema().to_json();
+    index_t num_bytes  = n_compact.total_bytes_compact();
+
+    buffer.resize(schema.size() + 1 + num_bytes);
+    memcpy(&buffer[0], schema.c_str(), schema.size() + 1);
+    if(num_bytes > 0)
+    {
+        memcpy(&buffer[schema.size() + 1], n_compact.data_ptr(), num_bytes);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// inverse of pack_node
+//-----------------------------------------------------------------------------
+void
+unpack_node(const char *buffer, Node &node)
+{
+    std::string schema(buffer);
+
+    node.reset();
+    node.set(Schema(schema));
+
+    index_t num_bytes = node.total_bytes_compact();
+    if(num_bytes > 0)
+    {
+        memcpy(node.data_ptr(), buffer + schema.size() + 1, num_bytes);
+    }
+}
+
+#ifdef PARALLEL
+//-----------------------------------------------------------------------------
+// name of the tree that holds a domain in an aggregated file
+//-----------------------------------------------------------------------------
+std::string
+domain_tree_name(uint64 domain)
+{
+    char fmt_buff[64];
+    snprintf(fmt_buff, sizeof(fmt_buff), "domain_%06lu", (unsigned long)domain);
+    return std::string(fmt_buff);
+}
+
+//-----------------------------------------------------------------------------
+// sends a node (schema + compacted data) to another rank. if the node
+// can't be sent the receiver is told so, and we return false.
+//-----------------------------------------------------------------------------
+bool
+send_node(const Node &node, int dest, int tag, MPI_Comm comm)
+{
+    Node n_compact;
+    node.compact_to(n_compact);
+
+    std::string schema = n_compact.schema().to_json();
+    index_t num_bytes  = n_compact.total_bytes_compact();
+
+    if(num_bytes > (index_t) INT_MAX)
+    {
+        STRAWMAN_INFO("Domain is too large to aggregate (" 
+                      << num_bytes << " bytes)");
+        int sizes[2] = { -1, -1 };
+        MPI_Send(sizes, 2, MPI_INT, dest, tag, comm);
+        return false;
+    }
+
+    int sizes[2] = { (int) schema.size(), (int) num_bytes };
+
+    MPI_Send(sizes, 2, MPI_INT, dest, tag, comm);
+    MPI_Send(const_cast<char*>(schema.c_str()), sizes[0], MPI_CHAR, dest, tag, comm);
+    MPI_Send(n_compact.data_ptr(), sizes[1], MPI_BYTE, dest, tag, comm);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// receives a node sent with send_node. returns false if the sender could
+// not send it, or we could not rebuild it. either way all of the sender's
+// messages are received, so it never blocks.
+//-----------------------------------------------------------------------------
+bool
+recv_node(Node &node, int src, int tag, MPI_Comm comm)
+{
+    int sizes[2] = {0, 0};
+    MPI_Recv(sizes, 2, MPI_INT, src, tag, comm, MPI_STATUS_IGNORE);
+
+    if(sizes[0] < 0)
+    {
+        return false;
+    }
+
+    std::string schema(sizes[0], ' ');
+    MPI_Recv(&schema[0], sizes[0], MPI_CHAR, src, tag, comm, MPI_STATUS_IGNORE);
+
+    node.reset();
+    bool ok = true;
+    try
+    {
+        node.set(Schema(schema));
+        ok = node.total_bytes_compact() == (index_t) sizes[1];
+    }
+    catch(conduit::Error &e)
+    {
+        STRAWMAN_INFO("Failed to rebuild a node sent by rank " << src
+                      << ": " << e.message());
+        ok = false;
+    }
+
+    if(!ok)
+    {
+        std::vector<char> scratch(sizes[1] > 0 ? sizes[1] : 1);
+        MPI_Recv(&scratch[0], sizes[1], MPI_BYTE, src, tag, comm, MPI_STATUS_IGNORE);
+        node.reset();
+        return false;
+    }
+
+    MPI_Recv(node.data_ptr(), sizes[1], MPI_BYTE, src, tag, comm, MPI_STATUS_IGNORE);
+    return true;
+}
+#endif
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Internal Class that coordinates writing.
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+class BlueprintHDF5Pipeline::IOManager
+{
+public:
+
+    // construction and destruction 
+#ifdef PARALLEL
+     IOManager(MPI_Comm mpi_comm);
+#else
+     IOManager();
+#endif
+    ~IOManager();
+
+    // main call to create hdf5 file set
+    void SaveToHDF5FileSet(const Node &data, const Node &options);
+
+    // blocks until all async saves are written, errors if any failed
+    void WaitForSaves();
+    // saves/pending, saves/completed, saves/failed and the compression
+    // stats of the last save (saves/last_write)
+    void Info(Node &info);
+
+private:
+    // hdf5 external link to a subtree written by an earlier save
+    struct ExternalLink
+    {
+        std::string m_path;
+        // relative to the directory of the file that holds the link
+        std::string m_file;
+    };
+
+    // where we last wrote a coordset or topology
+    struct StaticEntry
+    {
+        uint64      m_hash;
+        std::string m_file;
+    };
+
+    // files one save writes on this rank
+    struct SaveJob
+    {
+        // a copy of the published data, or a reference to it
+        Node        m_data;
+        std::string m_output_file;
+        // subtrees of the published data we link instead of writing
+        std::vector<ExternalLink> m_links;
+        // coordsets and topologies this save writes, later saves of 
+        // the series may only link to them once the write succeeded
+        std::map<std::string, StaticEntry> m_static;
+        std::string m_static_series;
+        // the save's compression options, empty for none
+        Node        m_compression;
+        // write a raw blueprint file (see RawFile) instead of hdf5
+        bool        m_raw;
+        // only set on rank 0
+        Node        m_root;
+        std::string m_root_file;
+
+        SaveJob()
+        : m_raw(false)
+        {}
+    };
+
+    // collective: gathers a summary of each domain to rank 0, which 
+    // fills bp_idx with the merged blueprint index and summary with the
+    // per domain coordset bounds and field ranges
+    void BuildRootIndex(const Node &data,
+                        uint64 domain,
+                        int num_domains,
+                        Node &bp_idx,
+                        Node &summary);
+
+    // fills trimmed with (external) subtrees of data that must be written,
+    // coordsets and topologies unchanged since the last successfully 
+    // written save of the series become links in job. output_file is 
+    // relative to the directory of the series, link_prefix leads there
+    // from the directory of a file.
+    void LinkUnchanged(const Node &data,
+                       const std::string &series,
+                       const std::string &output_file,
+                       const std::string &link_prefix,
+                       Node &trimmed,
+                       SaveJob &job);
+    // records the subtrees a job wrote, call with m_mutex held and 
+    // only after the job's files were written
+    void CommitStatic(const SaveJob &job);
+
+    // encodes the float fields the lossy options select, returns false 
+    // (and leaves encoded alone) if the options are invalid
+    bool EncodeLossy(const Node &data,
+                     const Node &lossy,
+                     Node &encoded);
+
+    // writes the job's files, the only place (besides aggregated 
+    // saves) that calls into hdf5
+    void WriteFiles(const Node &data, const SaveJob &job);
+
+    // background writer for async saves
+    void StartWriter();
+    void StopWriter();
+    static void *WriterMain(void *self);
+    void WriterLoop();
+    // hands a job to the writer, waits while max_pending saves are 
+    // still being written
+    void PostJob(SaveJob *job, int max_pending);
+    // waits until the writer is idle, without checking for failures
+    void WaitForWriter();
+
+#ifdef PARALLEL
+    // N-to-M: each group of ranks sends its domains to an aggregator,
+    // which writes them as separate trees of one file
+    void SaveAggregated(const Node &data,
+                        uint64 domain,
+                        int num_files,
+                        int file_id,
+                        const std::string &output_file,
+                        const Node &compression);
+    // N-to-1: rank 0 lays out every domain's datasets in one file, then
+    // all ranks write their arrays into it with one collective mpi-io call
+    void SaveShared(const Node &data,
+                    uint64 domain,
+                    const std::string &output_file);
+    // communicator of the ranks that share our file
+    MPI_Comm GroupComm(int num_files, int file_id, uint64 domain);
+    // collective: true on all ranks if the domain ids are 0 to 
+    // num_domains - 1, each used once. aggregated saves need this to
+    // map domains to files.
+    bool CheckDomainIds(uint64 domain);
+#endif
+
+//-----------------------------------------------------------------------------
+// private vars 
+//-----------------------------------------------------------------------------
+    int m_rank;
+
+//-----------------------------------------------------------------------------
+// private vars for MPI case
+//-----------------------------------------------------------------------------
+#ifdef PARALLEL
+    MPI_Comm            m_mpi_comm;
+    int                 m_mpi_size;
+    // cached split of m_mpi_comm for aggregated saves
+    MPI_Comm            m_group_comm;
+    int                 m_group_num_files;
+#endif 
+
+    // async save state, guarded by m_mutex
+    pthread_t               m_thread;
+    bool                    m_thread_running;
+    pthread_mutex_t         m_mutex;
+    pthread_cond_t          m_cond;
+    bool                    m_shutdown;
+    std::deque<SaveJob*>    m_jobs;
+    // the writer is busy with a job it took from m_jobs
+    bool                    m_writing;
+    int                     m_completed;
+    int                     m_failed;
+    // failures WaitForSaves() has not reported yet
+    int                     m_unreported_failures;
+    // compression ratio and throughput of the last file we wrote
+    Node                    m_last_write_stats;
+    // ratio and max error of the fields the last save lossy encoded
+    Node                    m_last_lossy_stats;
+
+    // hash of the blueprint index of our domain we last sent to rank 0
+    uint64                  m_index_fingerprint;
+    bool                    m_index_sent;
+    // rank 0: the latest index received from each rank, and their merge
+    std::vector<Node>       m_rank_indexes;
+    Node                    m_merged_index;
+
+    // coordsets and topologies written by earlier saves, by path.
+    // guarded by m_mutex, since the writer adds the entries of async
+    // saves once their files are written
+    std::map<std::string, StaticEntry> m_static;
+    std::string                        m_static_output_path;
+};
+
+#ifdef PARALLEL
+//-----------------------------------------------------------------------------
+BlueprintHDF5Pipeline::IOManager::IOManager(MPI_Comm mpi_comm)
+:m_rank(0),
+ m_mpi_comm(mpi_comm),
+ m_group_comm(MPI_COMM_NULL),
+ m_group_num_files(0),
+ m_thread_running(false),
+ m_shutdown(false),
+ m_writing(false),
+ m_completed(0),
+ m_failed(0),
+ m_unreported_failures(0),
+ m_index_fingerprint(0),
+ m_index_sent(false)
+{
+    MPI_Comm_rank(m_mpi_comm, &m_rank);
+    MPI_Comm_size(m_mpi_comm, &m_mpi_size);
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
+}
+#else
+//-----------------------------------------------------------------------------
+BlueprintHDF5Pipeline::IOManager::IOManager()
+:m_rank(0),
+ m_thread_running(false),
+ m_shutdown(false),
+ m_writing(false),
+ m_completed(0),
+ m_failed(0),
+ m_unreported_failures(0),
+ m_index_fingerprint(0),
+ m_index_sent(false)
+{
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
+}
+#endif
+
+
+//-----------------------------------------------------------------------------
+BlueprintHDF5Pipeline::IOManager::~IOManager()
+{
+    // pending saves are still written
+    StopWriter();
+
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+
+#ifdef PARALLEL
+    if(m_group_comm != MPI_COMM_NULL)
+    {
+        MPI_Comm_free(&m_group_comm);
+    }
+#endif
+}
+
+#ifdef PARALLEL
+//-----------------------------------------------------------------------------
+MPI_Comm
+BlueprintHDF5Pipeline::IOManager::GroupComm(int num_files,
+                                            int file_id,
+                                            uint64 domain)
+{
+    // num_files comes from the save action, so every rank 
+    // agrees on when we need to split again
+    if(m_group_comm != MPI_COMM_NULL && m_group_num_files == num_files)
+    {
+        return m_group_comm;
+    }
+
+    if(m_group_comm != MPI_COMM_NULL)
+    {
+        MPI_Comm_free(&m_group_comm);
+    }
+
+    // order by domain, so the lowest domain of each file aggregates
+    MPI_Comm_split(m_mpi_comm, file_id, (int) domain, &m_group_comm);
+    m_group_num_files = num_files;
+
+    return m_group_comm;
+}
+
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::SaveAggregated(const Node &data,
+                                                 uint64 domain,
+                                                 int num_files,
+                                                 int file_id,
+                                                 const std::string &output_file,
+                                                 const Node &compression)
+{
+    MPI_Comm group_comm = GroupComm(num_files, file_id, domain);
+
+    int group_rank = 0;
+    int group_size = 1;
+    MPI_Comm_rank(group_comm, &group_rank);
+    MPI_Comm_size(group_comm, &group_size);
+
+    // every rank goes through all of its messages even once the save 
+    // failed, and the outcome is agreed on by all ranks at the end, so a
+    // failure on one rank never leaves the others waiting. conduit's 
+    // default warning handler throws, so we only log with STRAWMAN_INFO.
+    int save_ok = 1;
+
+    if(group_rank != 0)
+    {
+        if(!send_node(data, 0, 0, group_comm))
+        {
+            save_ok = 0;
+        }
+    }
+    else
+    {
+        hid_t h5_file_id = create_hdf5_file(output_file);
+        if(h5_file_id < 0)
+        {
+            STRAWMAN_INFO("Failed to create file " << output_file);
+            save_ok = 0;
+        }
+
+        // the other ranks of the group stream their domains to us one at 
+        // a time, so we never hold more than one of them in memory
+        Node n_recv;
+        // compression stats, summed over the domains
+        Node stats;
+        for(int i = 0; i < group_size; ++i)
+        {
+            const Node *n_domain = &data;
+            uint64 tree_domain   = domain;
+
+            if(i > 0)
+            {
+                if(!recv_node(n_recv, i, 0, group_comm))
+                {
+                    save_ok = 0;
+                    continue;
+                }
+                n_domain    = &n_recv;
+                tree_domain = n_recv["state/domain_id"].to_uint64();
+            }
+
+            if(save_ok == 0)
+            {
+                continue;
+            }
+
+            std::string tree_name = domain_tree_name(tree_domain);
+            hid_t h5_group_id = H5Gcreate2(h5_file_id,
+                                           tree_name.c_str(),
+                                           H5P_DEFAULT,
+                                           H5P_DEFAULT,
+                                           H5P_DEFAULT);
+            if(h5_group_id < 0)
+            {
+                STRAWMAN_INFO("Failed to create " << tree_name 
+                              << " in " << output_file);
+                save_ok = 0;
+                continue;
+            }
+
+            try
+            {
+                write_tree(*n_domain, h5_group_id, compression, stats);
+            }
+            catch(conduit::Error &e)
+            {
+                STRAWMAN_INFO("Failed to write " << tree_name 
+                              << " to " << output_file
+                              << ": " << e.message());
+                save_ok = 0;
+            }
+            catch(std::exception &e)
+            {
+                STRAWMAN_INFO("Failed to write " << tree_name 
+                              << " to " << output_file
+                              << ": " << e.what());
+                save_ok = 0;
+            }
+
+            H5Gclose(h5_group_id);
+        }
+
+        if(h5_file_id >= 0)
+        {
+            H5Fclose(h5_file_id);
+        }
+
+        if(save_ok == 1)
+        {
+            summarize_write_stats(stats, output_file);
+
+            MutexLock lock(m_mutex);
+            m_last_write_stats.set(stats);
+        }
+    }
+
+    int all_ok = 0;
+    MPI_Allreduce(&save_ok, &all_ok, 1, MPI_INT, MPI_MIN, m_mpi_comm);
+    if(all_ok != 1)
+    {
+        STRAWMAN_ERROR("Error: failed to write aggregated file " 
+                       << output_file << " or one of its peers");
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+BlueprintHDF5Pipeline::IOManager::CheckDomainIds(uint64 domain)
+{
+    std::vector<uint64> domains;
+    if(m_rank == 0)
+    {
+        domains.resize(m_mpi_size);
+    }
+
+    MPI_Gather(&domain, 1, MPI_UINT64_T,
+               m_rank == 0 ? &domains[0] : NULL, 1, MPI_UINT64_T,
+               0, m_mpi_comm);
+
+    int ok = 1;
+    if(m_rank == 0)
+    {
+        std::vector<bool> used(m_mpi_size, false);
+        for(int i = 0; i < m_mpi_size && ok == 1; ++i)
+        {
+            if(domains[i] >= (uint64) m_mpi_size)
+            {
+                STRAWMAN_INFO("domain id " << domains[i] 
+                              << " of rank " << i 
+                              << " is out of range for " << m_mpi_size 
+                              << " domains");
+                ok = 0;
+            }
+            else if(used[domains[i]])
+            {
+                STRAWMAN_INFO("domain id " << domains[i] 
+                              << " is used by more than one rank");
+                ok = 0;
+            }
+            else
+            {
+                used[domains[i]] = true;
+            }
+        }
+    }
+
+    MPI_Bcast(&ok, 1, MPI_INT, 0, m_mpi_comm);
+    return ok == 1;
+}
+
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::SaveShared(const Node &data,
+                                             uint64 domain,
+                                             const std::string &output_file)
+{
+    // numeric arrays go straight to the file, the (small) rest of the 
+    // tree is sent to rank 0 along with the array layout
+    Node layout;
+    std::vector<std::string> arrays;
+    split_arrays(data, "", NULL, layout["plain"], arrays);
+
+    layout["domain"] = domain;
+    for(size_t i = 0; i < arrays.size(); ++i)
+    {
+        const DataType &dtype = data[arrays[i]].dtype();
+        Node &array = layout["arrays"].append();
+        array["path"]  = arrays[i];
+        array["dtype"] = numeric_dtype_code(dtype);
+        array["count"] = (int64) dtype.number_of_elements();
+    }
+
+    // file offset of each of our arrays
+    std::vector<int64> offsets(arrays.size(), -1);
+
+    // every rank gets its offsets from rank 0, even if something failed,
+    // and the outcome is agreed on by all ranks before anyone opens the
+    // file. conduit's default warning handler throws, so we only log 
+    // with STRAWMAN_INFO.
+    int layout_ok = 1;
+
+    if(m_rank != 0)
+    {
+        if(!send_node(layout, 0, 0, m_mpi_comm))
+        {
+            layout_ok = 0;
+        }
+    }
+    else
+    {
+        // create every domain's groups and datasets, with the space for 
+        // the arrays allocated now and no fill values, so the other
+        // ranks can write the array bytes at fixed offsets
+        hid_t h5_file_id = create_hdf5_file(output_file);
+        if(h5_file_id < 0)
+        {
+            STRAWMAN_INFO("Failed to create file " << output_file);
+            layout_ok = 0;
+        }
+
+        hid_t h5_dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+        H5Pset_layout(h5_dcpl_id, H5D_CONTIGUOUS);
+        H5Pset_alloc_time(h5_dcpl_id, H5D_ALLOC_TIME_EARLY);
+        H5Pset_fill_time(h5_dcpl_id, H5D_FILL_TIME_NEVER);
+
+        hid_t h5_lcpl_id = H5Pcreate(H5P_LINK_CREATE);
+        H5Pset_create_intermediate_group(h5_lcpl_id, 1);
+
+        // the file must be closed before any rank writes to it, so we
+        // hold on to the offsets until then
+        std::vector< std::vector<int64> > all_offsets(m_mpi_size);
+
+        Node n_recv;
+        for(int i = 0; i < m_mpi_size; ++i)
+        {
+            const Node *n_layout = &layout;
+            if(i > 0)
+            {
+                if(!recv_node(n_recv, i, 0, m_mpi_comm))
+                {
+                    layout_ok = 0;
+                    continue;
+                }
+                n_layout = &n_recv;
+            }
+
+            if(layout_ok == 0)
+            {
+                continue;
+            }
+
+            index_t num_arrays = 0;
+            if(n_layout->has_child("arrays"))
+            {
+                num_arrays = (*n_layout)["arrays"].number_of_children();
+            }
+            std::vector<int64> &rank_offsets = all_offsets[i];
+            rank_offsets.resize(num_arrays, -1);
+
+            std::string tree_name = domain_tree_name(
+                                        (*n_layout)["domain"].to_uint64());
+            hid_t h5_group_id = H5Gcreate2(h5_file_id,
+                                           tree_name.c_str(),
+                                           H5P_DEFAULT,
+                                           H5P_DEFAULT,
+                                           H5P_DEFAULT);
+            if(h5_group_id < 0)
+            {
+                STRAWMAN_INFO("Failed to create " << tree_name 
+                              << " in " << output_file);
+                layout_ok = 0;
+                continue;
+            }
+
+            try
+            {
+                const Node &plain = (*n_layout)["plain"];
+                if(plain.number_of_children() > 0)
+                {
+                    relay::io::hdf5_write(plain, h5_group_id);
+                }
+            }
+            catch(conduit::Error &e)
+            {
+                STRAWMAN_INFO("Failed to write " << tree_name 
+                              << " to " << output_file
+                              << ": " << e.message());
+                layout_ok = 0;
+            }
+            catch(std::exception &e)
+            {
+                STRAWMAN_INFO("Failed to write " << tree_name 
+                              << " to " << output_file
+                              << ": " << e.what());
+                layout_ok = 0;
+            }
+
+            for(index_t j = 0; j < num_arrays && layout_ok == 1; ++j)
+            {
+                const Node &array = (*n_layout)["arrays"][j];
+                hsize_t count = (hsize_t) array["count"].to_int64();
+
+                hid_t h5_space_id = H5Screate_simple(1, &count, NULL);
+                hid_t h5_dset_id  = H5Dcreate2(h5_group_id,
+                                               array["path"].as_string().c_str(),
+                                               numeric_hdf5_dtype(array["dtype"].to_int()),
+                                               h5_space_id,
+                                               h5_lcpl_id,
+                                               h5_dcpl_id,
+                                               H5P_DEFAULT);
+                if(h5_dset_id >= 0)
+                {
+                    // empty arrays have no storage, and nothing to write
+                    haddr_t offset = count > 0 ? H5Dget_offset(h5_dset_id) : 0;
+                    if(offset != HADDR_UNDEF)
+                    {
+                        rank_offsets[j] = (int64) offset;
+                    }
+                    H5Dclose(h5_dset_id);
+                }
+                H5Sclose(h5_space_id);
+
+                if(rank_offsets[j] < 0)
+                {
+                    STRAWMAN_INFO("Failed to create " << tree_name << "/"
+                                  << array["path"].as_string()
+                                  << " in " << output_file);
+                    layout_ok = 0;
+                }
+            }
+
+            H5Gclose(h5_group_id);
+        }
+
+        H5Pclose(h5_lcpl_id);
+        H5Pclose(h5_dcpl_id);
+        if(h5_file_id >= 0)
+        {
+            H5Fclose(h5_file_id);
+        }
+
+        // ranks whose layout we could not use get no offsets
+        offsets = all_offsets[0];
+        offsets.resize(arrays.size(), -1);
+        for(int i = 1; i < m_mpi_size; ++i)
+        {
+            MPI_Send(all_offsets[i].empty() ? NULL : &all_offsets[i][0],
+                     (int) all_offsets[i].size(),
+                     MPI_INT64_T, i, 0, m_mpi_comm);
+        }
+    }
+
+    if(m_rank != 0)
+    {
+        // may be shorter than arrays (or empty), the rest stays at -1
+        int64 no_offsets = -1;
+        MPI_Recv(arrays.empty() ? &no_offsets : &offsets[0],
+                 arrays.empty() ? 1 : (int) arrays.size(),
+                 MPI_INT64_T,
+                 0, 0, m_mpi_comm, MPI_STATUS_IGNORE);
+    }
+
+    // describe where our arrays live in memory and in the file, sorted 
+    // by file offset as mpi file views require. empty arrays only need
+    // their dataset, which rank 0 created.
+    std::map<int64, size_t> by_offset;
+    for(size_t i = 0; i < arrays.size(); ++i)
+    {
+        index_t num_bytes = data[arrays[i]].dtype().bytes_compact();
+        if(num_bytes == 0)
+        {
+            continue;
+        }
+
+        if(offsets[i] < 0 || num_bytes > (index_t) INT_MAX)
+        {
+            layout_ok = 0;
+        }
+        by_offset[offsets[i]] = i;
+    }
+
+    int all_ok = 0;
+    MPI_Allreduce(&layout_ok, &all_ok, 1, MPI_INT, MPI_MIN, m_mpi_comm);
+    if(all_ok != 1)
+    {
+        STRAWMAN_ERROR("Error: failed to lay out shared file " << output_file);
+    }
+
+    int num_blocks = (int) by_offset.size();
+    std::vector<int>      block_lengths(num_blocks);
+    std::vector<MPI_Aint> file_displs(num_blocks);
+    std::vector<MPI_Aint> mem_displs(num_blocks);
+    // strided arrays need a compact copy
+    std::vector<Node>     compact(num_blocks);
+
+    int block = 0;
+    std::map<int64, size_t>::iterator itr;
+    for(itr = by_offset.begin(); itr != by_offset.end(); ++itr, ++block)
+    {
+        const Node &leaf = data[arrays[itr->second]];
+        const void *ptr  = leaf.element_ptr(0);
+        if(!leaf.dtype().is_compact())
+        {
+            leaf.compact_to(compact[block]);
+            ptr = compact[block].element_ptr(0);
+        }
+
+        block_lengths[block] = (int) leaf.dtype().bytes_compact();
+        file_displs[block]   = (MPI_Aint) itr->first;
+        MPI_Get_address(const_cast<void*>(ptr), &mem_displs[block]);
+    }
+
+    MPI_Datatype file_type, mem_type;
+    MPI_Type_create_hindexed(num_blocks,
+                             num_blocks > 0 ? &block_lengths[0] : NULL,
+                             num_blocks > 0 ? &file_displs[0] : NULL,
+                             MPI_BYTE,
+                             &file_type);
+    MPI_Type_create_hindexed(num_blocks,
+                             num_blocks > 0 ? &block_lengths[0] : NULL,
+                             num_blocks > 0 ? &mem_displs[0] : NULL,
+                             MPI_BYTE,
+                             &mem_type);
+    MPI_Type_commit(&file_type);
+    MPI_Type_commit(&mem_type);
+
+    MPI_File fh;
+    int mpi_status = MPI_File_open(m_mpi_comm,
+                                   const_cast<char*>(output_file.c_str()),
+                                   MPI_MODE_WRONLY,
+                                   MPI_INFO_NULL,
+                                   &fh);
+    if(mpi_status == MPI_SUCCESS)
+    {
+        MPI_File_set_view(fh, 
+                          0,
+                          MPI_BYTE,
+                          file_type,
+                          const_cast<char*>("native"),
+                          MPI_INFO_NULL);
+        mpi_status = MPI_File_write_all(fh,
+                                        MPI_BOTTOM,
+                                        num_blocks > 0 ? 1 : 0,
+                                        mem_type,
+                                        MPI_STATUS_IGNORE);
+        MPI_File_close(&fh);
+    }
+
+    MPI_Type_free(&file_type);
+    MPI_Type_free(&mem_type);
+
+    if(mpi_status != MPI_SUCCESS)
+    {
+        STRAWMAN_ERROR("Error: failed to write shared file " << output_file);
+    }
+}
+#endif
+
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::SaveToHDF5FileSet(const Node &data,
+                                                    const Node &options)
+{
+    // get cycle and domain id from the mesh
+
+    uint64 domain = data["state/domain_id"].to_value();
+    uint64 cycle  = data["state/cycle"].to_value();
+
+    STRAWMAN_INFO("rank: "   << m_rank << 
+                  " cycle: " << cycle << 
+                  " domain:" << domain);
+
+    char fmt_buff[64];
+    snprintf(fmt_buff, sizeof(fmt_buff), "%06lu",cycle);
+    
+    std::string output_base_path = options["output_path"].as_string();
+
+    // by default each cycle gets its own directory, the flat layout
+    // puts every file next to the root files instead
+    bool flat = options.has_path("layout") &&
+                options["layout"].as_string() == "flat";
+
+    string output_path_name, output_path_dir;
+
+    // TODO: Fix for windows
+    conduit::utils::rsplit_string(output_base_path,
+                                  "/",
+                                  output_path_name,
+                                  output_path_dir);
+    
+    ostringstream oss;
+    oss << output_path_name << ".cycle_" << fmt_buff;
+    // leads from the directory of output_path to this cycle's files
+    string cycle_prefix = oss.str() + (flat ? "." : "/");
+
+    int num_domains = 1;
+#ifdef PARALLEL
+    num_domains = m_mpi_size;
+#endif
+
+    // optional N-to-M output: num_files files, each holding the
+    // domains of a contiguous range of domain ids
+    int num_files = num_domains;
+    if(options.has_path("num_files"))
+    {
+        num_files = options["num_files"].to_int();
+        if(num_files <= 0 || num_files > num_domains)
+        {
+            num_files = num_domains;
+        }
+    }
+
+    // one file written by all ranks, without aggregating the arrays
+    bool shared = options.has_path("shared_file") &&
+                  options["shared_file"].as_string() == "true";
+    if(shared)
+    {
+        num_files = 1;
+    }
+
+    // optional chunking and compression of the written arrays
+    Node compression;
+    if(options.has_path("compression"))
+    {
+        compression.set(options["compression"]);
+    }
+
+    // optional error bounded lossy encoding of float fields, which
+    // happens before the data is written by any of the save modes
+    Node lossy_data;
+    const Node *save_data = &data;
+    if(compression.has_child("lossy"))
+    {
+        if(EncodeLossy(data, compression["lossy"], lossy_data))
+        {
+            save_data = &lossy_data;
+        }
+        compression.remove("lossy");
+        if(compression.number_of_children() == 0)
+        {
+            compression.reset();
+        }
+    }
+
+    // raw files are memory mapped by readers, one per domain
+    bool raw = options.has_path("protocol") &&
+               options["protocol"].as_string() == "raw";
+    if(raw && num_files != num_domains)
+    {
+        STRAWMAN_INFO("Raw saves write one file per domain,"
+                      " ignoring num_files and shared_file");
+        num_files = num_domains;
+        shared    = false;
+    }
+
+    bool aggregate = num_files < num_domains;
+
+    // the file that holds our domain
+    int file_id = (int) domain;
+#ifdef PARALLEL
+    if(aggregate)
+    {
+        // checked on all ranks together, so they all fail the same way
+        if(!CheckDomainIds(domain))
+        {
+            STRAWMAN_ERROR("Error: aggregated saves need domain ids 0 to "
+                           << num_domains - 1 << ", one per rank");
+        }
+
+        file_id = (int) ((domain * (uint64) num_files) / 
+                         (uint64) num_domains);
+    }
+#endif
+
+    oss.str("");
+    if(aggregate)
+    {
+        snprintf(fmt_buff, sizeof(fmt_buff), "%06d", file_id);
+        oss << "file_" << fmt_buff << ".hdf5";
+    }
+    else
+    {
+        snprintf(fmt_buff, sizeof(fmt_buff), "%06lu",domain);
+        oss << "domain_" << fmt_buff << (raw ? ".raw" : ".hdf5");
+    }
+    // relative to the directory of output_path
+    string output_file_rel = cycle_prefix + oss.str();
+    string output_file     = output_file_rel;
+    if(!output_path_dir.empty())
+    {
+        output_file = conduit::utils::join_file_path(output_path_dir,
+                                                     output_file_rel);
+    }
+
+    // there is no collective check of the cycle directory, the ranks
+    // that write a file only create it when creating the file fails
+    // without it, and a failure shows up as a failed write
+
+    // async saves hand the file writes to a background thread, 
+    // everything that needs mpi still happens here
+    bool async = options.has_path("async") && 
+                 options["async"].as_string() == "true";
+
+    if(async && !hdf5_is_thread_safe())
+    {
+        STRAWMAN_INFO("HDF5 is not thread safe, writing async saves"
+                      " synchronously");
+        async = false;
+    }
+
+    if(raw && !compression.dtype().is_empty())
+    {
+        STRAWMAN_INFO("Raw saves write uncompressed arrays,"
+                      " ignoring compression options");
+        compression.reset();
+    }
+
+#ifdef PARALLEL
+    if(aggregate)
+    {
+        if(async)
+        {
+            STRAWMAN_INFO("Aggregated saves exchange data with mpi,"
+                          " writing them synchronously");
+        }
+        // let pending async saves finish before we write here
+        WaitForWriter();
+        if(shared)
+        {
+            if(!compression.dtype().is_empty())
+            {
+                STRAWMAN_INFO("Shared file saves write raw arrays,"
+                              " ignoring compression options");
+            }
+            SaveShared(*save_data, domain, output_file);
+        }
+        else
+        {
+            SaveAggregated(*save_data, 
+                           domain,
+                           num_files,
+                           file_id,
+                           output_file,
+                           compression);
+        }
+    }
+#endif
+
+    // aggregated saves already wrote the domains, the job only 
+    // holds the root file for them
+    SaveJob *job = new SaveJob();
+    job->m_compression.set(compression);
+    job->m_raw = raw;
+    if(!aggregate)
+    {
+        job->m_output_file = output_file;
+    }
+
+    // the subset of data this save writes, and links for the rest
+    Node trimmed;
+    const Node *write_data = save_data;
+
+    // raw files have no links, readers map each file on its own
+    if(!job->m_output_file.empty() &&
+       !raw &&
+       options.has_path("link_unchanged") &&
+       options["link_unchanged"].as_string() == "true")
+    {
+        // a flat series shares one directory, otherwise the earlier
+        // cycle's directory is next to ours
+        LinkUnchanged(*save_data,
+                      output_base_path + (flat ? " (flat)" : ""),
+                      output_file_rel,
+                      flat ? "" : "../",
+                      trimmed,
+                      *job);
+        write_data = &trimmed;
+    }
+
+    // collective, so every rank calls it
+    Node bp_idx_mesh, domain_summary;
+    BuildRootIndex(data, domain, num_domains, bp_idx_mesh, domain_summary);
+
+    // let rank zero write out the root file
+    if(m_rank == 0)
+    {
+        snprintf(fmt_buff, sizeof(fmt_buff), "%06lu",cycle);
+
+        oss.str("");
+        oss << options["output_path"].as_string() 
+            << ".cycle_" 
+            << fmt_buff 
+            << ".root";
+
+        job->m_root_file = oss.str();
+
+        Node &root = job->m_root;
+        root["blueprint_index/mesh"].set(bp_idx_mesh);
+        // lets readers cull domains without opening their files
+        root["domain_summary"].set(domain_summary);
+            
+        if(raw)
+        {
+            root["protocol/name"]    = "strawman_raw";
+            root["protocol/version"] = "1";
+        }
+        else
+        {
+            root["protocol/name"]    = "conduit_hdf5";
+            root["protocol/version"] = "0.2.1";
+        }
+
+        root["number_of_files"]  = num_files;
+        root["number_of_trees"]  = num_domains;
+
+        // TODO: make sure this is relative 
+        if(aggregate)
+        {
+            // domain d lives in file (d * number_of_files) / number_of_trees
+            root["file_pattern"] = cycle_prefix + "file_%06d.hdf5";
+            root["tree_pattern"] = "domain_%06d";
+        }
+        else
+        {
+            root["file_pattern"] = cycle_prefix + 
+                                   (raw ? "domain_%06d.raw" 
+                                        : "domain_%06d.hdf5");
+            root["tree_pattern"] = "/";
+        }
+    }
+
+    if(!async)
+    {
+        WaitForWriter();
+        try
+        {
+            WriteFiles(*write_data, *job);
+        }
+        catch(...)
+        {
+            {
+                MutexLock lock(m_mutex);
+                m_failed++;
+            }
+            delete job;
+            throw;
+        }
+
+        {
+            MutexLock lock(m_mutex);
+            m_completed++;
+            CommitStatic(*job);
+        }
+        delete job;
+        return;
+    }
+
+    if(!job->m_output_file.empty())
+    {
+        // lossy encoded arrays only live as long as this call
+        if(save_data == &data &&
+           options.has_path("reference") && 
+           options["reference"].as_string() == "true")
+        {
+            // the caller promised not to modify the published data
+            // until the save is written
+            job->m_data.set_external(const_cast<Node&>(*write_data));
+        }
+        else
+        {
+            // stage a copy, so the simulation can move on right away
+            job->m_data.set(*write_data);
+        }
+    }
+
+    int max_pending = DEFAULT_MAX_PENDING_SAVES;
+    if(options.has_path("max_pending"))
+    {
+        max_pending = options["max_pending"].to_int();
+        if(max_pending < 1)
+        {
+            max_pending = 1;
+        }
+    }
+
+    PostJob(job, max_pending);
+}
+
+//-----------------------------------------------------------------------------
+bool
+BlueprintHDF5Pipeline::IOManager::EncodeLossy(const Node &data,
+                                              const Node &lossy,
+                                              Node &encoded)
+{
+    float64 error_bound = 0.0;
+    if(lossy.has_child("error_bound"))
+    {
+        error_bound = lossy["error_bound"].to_float64();
+    }
+
+    if(!(error_bound > 0.0))
+    {
+        STRAWMAN_INFO("compression/lossy needs a positive error_bound,"
+                      " writing fields without lossy encoding");
+        return false;
+    }
+
+    bool relative = lossy.has_child("mode") &&
+                    lossy["mode"].as_string() == "relative";
+
+    std::vector<std::string> field_names;
+    if(lossy.has_child("fields"))
+    {
+        const Node &fields = lossy["fields"];
+        if(fields.dtype().is_string())
+        {
+            field_names.push_back(fields.as_string());
+        }
+        else
+        {
+            NodeConstIterator itr = fields.children();
+            while(itr.has_next())
+            {
+                field_names.push_back(itr.next().as_string());
+            }
+        }
+    }
+
+    Node stats;
+    lossy_encode_fields(data, 
+                        error_bound,
+                        relative,
+                        field_names,
+                        encoded,
+                        stats);
+    log_lossy_stats(stats, "");
+
+    MutexLock lock(m_mutex);
+    m_last_lossy_stats.set(stats);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::WriteFiles(const Node &data,
+                                             const SaveJob &job)
+{
+    if(!job.m_output_file.empty() && job.m_raw)
+    {
+        RawFile::Write(data, job.m_output_file);
+    }
+    else if(!job.m_output_file.empty() && 
+            job.m_links.empty() &&
+       job.m_compression.dtype().is_empty())
+    {
+        hid_t h5_file_id = create_hdf5_file(job.m_output_file);
+        if(h5_file_id < 0)
+        {
+            STRAWMAN_ERROR("Error: failed to create file " << job.m_output_file);
+        }
+
+        try
+        {
+            relay::io::hdf5_write(data, h5_file_id);
+        }
+        catch(...)
+        {
+            H5Fclose(h5_file_id);
+            throw;
+        }
+
+        H5Fclose(h5_file_id);
+    }
+    else if(!job.m_output_file.empty())
+    {
+        hid_t h5_file_id = create_hdf5_file(job.m_output_file);
+        if(h5_file_id < 0)
+        {
+            STRAWMAN_ERROR("Error: failed to create file " << job.m_output_file);
+        }
+
+        Node stats;
+        try
+        {
+            write_tree(data, h5_file_id, job.m_compression, stats);
+        }
+        catch(...)
+        {
+            H5Fclose(h5_file_id);
+            throw;
+        }
+
+        // readers follow these like regular groups, relative file names 
+        // are resolved against the directory of this file
+        hid_t h5_lcpl_id = H5Pcreate(H5P_LINK_CREATE);
+        H5Pset_create_intermediate_group(h5_lcpl_id, 1);
 
-// mpi related includes
-#ifdef PARALLEL
-#include <mpi.h>
-// -- conduit relay mpi
-#include <conduit_relay_mpi.hpp>
-#endif
+        bool links_ok = true;
+        for(size_t i = 0; i < job.m_links.size(); ++i)
+        {
+            const ExternalLink &link = job.m_links[i];
+            if(H5Lcreate_external(link.m_file.c_str(),
+                                  link.m_path.c_str(),
+                                  h5_file_id,
+                                  link.m_path.c_str(),
+                                  h5_lcpl_id,
+                                  H5P_DEFAULT) < 0)
+            {
+                links_ok = false;
+            }
+        }
 
-#include <sstream>
+        H5Pclose(h5_lcpl_id);
+        H5Fclose(h5_file_id);
 
-using namespace conduit;
-using namespace conduit::relay;
+        if(!links_ok)
+        {
+            STRAWMAN_ERROR("Error: failed to link unchanged mesh data in "
+                           << job.m_output_file);
+        }
 
-using namespace std;
+        summarize_write_stats(stats, job.m_output_file);
 
+        MutexLock lock(m_mutex);
+        m_last_write_stats.set(stats);
+    }
 
-//-----------------------------------------------------------------------------
-// -- begin strawman:: --
-//-----------------------------------------------------------------------------
-namespace strawman
-{
+    if(!job.m_root_file.empty())
+    {
+        CONDUIT_INFO("Creating: " << job.m_root_file);
+        relay::io::save(job.m_root, job.m_root_file, "hdf5");
+    }
+}
 
 //-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-// Internal Class that coordinates writing.
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-class BlueprintHDF5Pipeline::IOManager
+void
+BlueprintHDF5Pipeline::IOManager::BuildRootIndex(const Node &data,
+                                                 uint64 domain,
+                                                 int num_domains,
+                                                 Node &bp_idx,
+                                                 Node &summary)
 {
-public:
+    // our part of the summary: the index only when it changed, since it 
+    // usually stays the same for the whole run, the bounds and ranges
+    // every time
+    Node msg;
+    msg["domain_id"] = domain;
+
+    Node local_idx;
+    blueprint::mesh::generate_index(data, "", 1, local_idx);
+
+    // the state (cycle, time) changes every save, it comes from rank 0
+    Node local_state;
+    if(local_idx.has_child("state"))
+    {
+        local_state.set(local_idx["state"]);
+        local_idx.remove("state");
+    }
 
-    // construction and destruction 
-#ifdef PARALLEL
-     IOManager(MPI_Comm mpi_comm);
-#else
-     IOManager();
-#endif
-    ~IOManager();
+    std::string idx_json = local_idx.to_json();
+    uint64 fingerprint = FNV_OFFSET_BASIS;
+    hash_bytes(idx_json.c_str(), idx_json.size(), fingerprint);
 
-    // main call to create hdf5 file set
-    void SaveToHDF5FileSet(const Node &data, const Node &options);
+    if(!m_index_sent || fingerprint != m_index_fingerprint)
+    {
+        msg["index"].set(local_idx);
+        m_index_fingerprint = fingerprint;
+        m_index_sent = true;
+    }
 
-//-----------------------------------------------------------------------------
-// private vars for MPI case
-//-----------------------------------------------------------------------------
-private:
-    int m_rank;
+    if(data.has_child("coordsets"))
+    {
+        NodeConstIterator itr = data["coordsets"].children();
+        while(itr.has_next())
+        {
+            const Node &coords = itr.next();
+            float64 bounds[6];
+            coordset_bounds(coords, bounds);
+            msg["coordsets"][itr.name()]["bounds"].set(bounds, 6);
+        }
+    }
 
-//-----------------------------------------------------------------------------
-// private vars for MPI case
-//-----------------------------------------------------------------------------
-#ifdef PARALLEL
-    MPI_Comm            m_mpi_comm;
-    int                 m_mpi_size;
-#endif 
+    if(data.has_child("fields"))
+    {
+        NodeConstIterator itr = data["fields"].children();
+        while(itr.has_next())
+        {
+            const Node &field = itr.next();
+            if(!field.has_child("values"))
+            {
+                continue;
+            }
+
+            float64 range[2] = { std::numeric_limits<float64>::max(),
+                                -std::numeric_limits<float64>::max() };
+            update_range(field["values"], range[0], range[1]);
+            if(range[0] > range[1])
+            {
+                range[0] = range[1] = std::numeric_limits<float64>::quiet_NaN();
+            }
+            msg["fields"][itr.name()]["range"].set(range, 2);
+        }
+    }
 
-};
+    std::vector<char> buffer;
+    pack_node(msg, buffer);
+
+    int num_ranks = 1;
+    std::vector<int>  sizes(1, (int) buffer.size());
+    std::vector<int>  displs(1, 0);
+    std::vector<char> all_buffers;
 
 #ifdef PARALLEL
-//-----------------------------------------------------------------------------
-BlueprintHDF5Pipeline::IOManager::IOManager(MPI_Comm mpi_comm)
-:m_rank(0),
- m_mpi_comm(mpi_comm)
-{
-    MPI_Comm_rank(m_mpi_comm, &m_rank);
-    MPI_Comm_size(m_mpi_comm, &m_mpi_size);
-}
+    num_ranks = m_mpi_size;
+    int size = (int) buffer.size();
+    sizes.resize(num_ranks);
+    displs.resize(num_ranks);
+
+    MPI_Gather(&size, 1, MPI_INT, &sizes[0], 1, MPI_INT, 0, m_mpi_comm);
+
+    if(m_rank == 0)
+    {
+        int total = 0;
+        for(int i = 0; i < num_ranks; ++i)
+        {
+            displs[i] = total;
+            total += sizes[i];
+        }
+        all_buffers.resize(total);
+    }
+
+    MPI_Gatherv(&buffer[0], size, MPI_CHAR,
+                m_rank == 0 ? &all_buffers[0] : NULL,
+                &sizes[0], &displs[0], MPI_CHAR,
+                0, m_mpi_comm);
 #else
-//-----------------------------------------------------------------------------
-BlueprintHDF5Pipeline::IOManager::IOManager()
-:m_rank(0)
-{
-    
-}
+    all_buffers.swap(buffer);
 #endif
 
+    if(m_rank != 0)
+    {
+        return;
+    }
 
-//-----------------------------------------------------------------------------
-BlueprintHDF5Pipeline::IOManager::~IOManager()
-{
-    // empty
+    if((int) m_rank_indexes.size() != num_ranks)
+    {
+        m_rank_indexes.clear();
+        m_rank_indexes.resize(num_ranks);
+    }
+
+    std::vector<Node> msgs(num_ranks);
+    bool index_changed = false;
+    for(int i = 0; i < num_ranks; ++i)
+    {
+        unpack_node(&all_buffers[displs[i]], msgs[i]);
+        if(msgs[i].has_child("index"))
+        {
+            m_rank_indexes[i].set(msgs[i]["index"]);
+            index_changed = true;
+        }
+    }
+
+    if(index_changed)
+    {
+        // union of the domains' coordsets, topologies and fields
+        m_merged_index.reset();
+        for(int i = 0; i < num_ranks; ++i)
+        {
+            m_merged_index.update(m_rank_indexes[i]);
+        }
+    }
+
+    bp_idx.set(m_merged_index);
+    bp_idx["state"].set(local_state);
+    bp_idx["state/number_of_domains"] = num_domains;
+
+    // one array per coordset and field with an entry for each domain,
+    // nan where a domain does not have it
+    const float64 nan = std::numeric_limits<float64>::quiet_NaN();
+
+    summary.reset();
+    summary["domain_id"].set(DataType::int64(num_ranks));
+    int64 *domain_ids = summary["domain_id"].as_int64_ptr();
+
+    for(int i = 0; i < num_ranks; ++i)
+    {
+        const Node &n_msg = msgs[i];
+        domain_ids[i] = (int64) n_msg["domain_id"].to_int64();
+
+        const char *groups[2] = {"coordsets", "fields"};
+        const char *values[2] = {"bounds", "range"};
+        const int   widths[2] = {6, 2};
+
+        for(int g = 0; g < 2; ++g)
+        {
+            if(!n_msg.has_child(groups[g]))
+            {
+                continue;
+            }
+
+            NodeConstIterator itr = n_msg[groups[g]].children();
+            while(itr.has_next())
+            {
+                const Node &src = itr.next()[values[g]];
+                Node &dest = summary[groups[g]][itr.name()][values[g]];
+                if(dest.dtype().is_empty())
+                {
+                    dest.set(DataType::float64(num_ranks * widths[g]));
+                    float64 *vals = dest.as_float64_ptr();
+                    for(int j = 0; j < num_ranks * widths[g]; ++j)
+                    {
+                        vals[j] = nan;
+                    }
+                }
+
+                float64 *vals = dest.as_float64_ptr() + i * widths[g];
+                const float64 *src_vals = src.as_float64_ptr();
+                for(int j = 0; j < widths[g]; ++j)
+                {
+                    vals[j] = src_vals[j];
+                }
+            }
+        }
+    }
 }
 
 //-----------------------------------------------------------------------------
 void
-BlueprintHDF5Pipeline::IOManager::SaveToHDF5FileSet(const Node &data,
-                                                    const Node &options)
+BlueprintHDF5Pipeline::IOManager::LinkUnchanged(const Node &data,
+                                                const std::string &series,
+                                                const std::string &output_file,
+                                                const std::string &link_prefix,
+                                                Node &trimmed,
+                                                SaveJob &job)
 {
-    // get cycle and domain id from the mesh
-
-    uint64 domain = data["state/domain_id"].to_value();
-    uint64 cycle  = data["state/cycle"].to_value();
+    job.m_static_series = series;
+    trimmed.reset();
 
-    STRAWMAN_INFO("rank: "   << m_rank << 
-                  " cycle: " << cycle << 
-                  " domain:" << domain);
+    MutexLock lock(m_mutex);
 
-    char fmt_buff[64];
-    snprintf(fmt_buff, sizeof(fmt_buff), "%06lu",cycle);
-    
-    std::string output_base_path = options["output_path"].as_string();
-    
-        
-    ostringstream oss;
-    oss << output_base_path << ".cycle_" << fmt_buff;
-    string output_dir  =  oss.str();
-    
-    snprintf(fmt_buff, sizeof(fmt_buff), "%06lu",domain);
-    oss.str("");
-    oss << "domain_" << fmt_buff << ".hdf5";
-    string output_file  = conduit::utils::join_file_path(output_dir,oss.str());
+    // links only make sense within one series of saves
+    if(series != m_static_output_path)
+    {
+        m_static.clear();
+        m_static_output_path = series;
+    }
 
+    NodeConstIterator itr = data.children();
+    while(itr.has_next())
+    {
+        const Node &child = itr.next();
+        std::string name  = itr.name();
 
-    bool dir_ok = false;
+        if(name != "coordsets" && name != "topologies")
+        {
+            trimmed[name].set_external(const_cast<Node&>(child));
+            continue;
+        }
 
-    // let rank zero handle dir creation
-    if(m_rank == 0)
-    {
-        // check of the dir exists
-        dir_ok = directory_exists(output_dir);
-        if(!dir_ok)
+        NodeConstIterator sub_itr = child.children();
+        while(sub_itr.has_next())
         {
-            // if not try to let rank zero create it
-            dir_ok = create_directory(output_dir);
+            const Node &sub = sub_itr.next();
+            std::string path = name + "/" + sub_itr.name();
+
+            uint64 hash = FNV_OFFSET_BASIS;
+            hash_node(sub, hash);
+
+            // only saves that were written (not just posted) are in 
+            // m_static, so a failed async save never leaves links 
+            // to data that isn't there
+            std::map<std::string, StaticEntry>::iterator entry;
+            entry = m_static.find(path);
+
+            if(entry != m_static.end() && entry->second.m_hash == hash)
+            {
+                ExternalLink link;
+                link.m_path = path;
+                link.m_file = link_prefix + entry->second.m_file;
+                job.m_links.push_back(link);
+            }
+            else
+            {
+                trimmed[path].set_external(const_cast<Node&>(sub));
+                job.m_static[path].m_hash = hash;
+                job.m_static[path].m_file = output_file;
+            }
         }
     }
-    
-    int num_domains = 1;
-#ifdef PARALLEL
-    num_domains = m_mpi_size;
-    
-    // use an mpi sum to check if the dir exists
-    Node n_src, n_reduce;
-    
-    if(dir_ok)
-        n_src = (int)1;
-    else
-        n_src = (int)0;
+}
 
-    mpi::all_reduce(n_src,
-                    n_reduce,
-                    MPI_INT,
-                    MPI_MAX,
-                    m_mpi_comm);
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::CommitStatic(const SaveJob &job)
+{
+    // a later save may have started a new series
+    if(job.m_static.empty() || job.m_static_series != m_static_output_path)
+    {
+        return;
+    }
 
-    // error out if something went wrong.
-    if(n_reduce.as_int() != 1)
+    std::map<std::string, StaticEntry>::const_iterator itr;
+    for(itr = job.m_static.begin(); itr != job.m_static.end(); ++itr)
     {
-        STRAWMAN_ERROR("Error: failed to create directory " << output_dir);
-    } 
-#else
-    if(!dir_ok)
+        m_static[itr->first] = itr->second;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::StartWriter()
+{
+    if(m_thread_running)
     {
-        STRAWMAN_ERROR("Error: failed to create directory " << output_dir);
+        return;
     }
-#endif
 
-    relay::io::save(data,output_file);
+    m_shutdown = false;
+    if(pthread_create(&m_thread, 
+                      NULL,
+                      BlueprintHDF5Pipeline::IOManager::WriterMain,
+                      this) != 0)
+    {
+        STRAWMAN_ERROR("Failed to start the async save thread");
+    }
 
-    // let rank zero write out the root file
-    if(m_rank == 0)
+    m_thread_running = true;
+}
+
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::StopWriter()
+{
+    if(!m_thread_running)
     {
-        snprintf(fmt_buff, sizeof(fmt_buff), "%06lu",cycle);
+        return;
+    }
 
-        oss.str("");
-        oss << options["output_path"].as_string() 
-            << ".cycle_" 
-            << fmt_buff 
-            << ".root";
+    {
+        MutexLock lock(m_mutex);
+        m_shutdown = true;
+        pthread_cond_broadcast(&m_cond);
+    }
+
+    pthread_join(m_thread, NULL);
+    m_thread_running = false;
+}
+
+//-----------------------------------------------------------------------------
+void *
+BlueprintHDF5Pipeline::IOManager::WriterMain(void *self)
+{
+    ((BlueprintHDF5Pipeline::IOManager*)self)->WriterLoop();
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// runs on the writer thread. conduit's default warning handler throws,
+// so we only log with STRAWMAN_INFO here.
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::WriterLoop()
+{
+    while(true)
+    {
+        SaveJob *job = NULL;
+        {
+            MutexLock lock(m_mutex);
+            while(m_jobs.empty() && !m_shutdown)
+            {
+                pthread_cond_wait(&m_cond, &m_mutex);
+            }
+
+            // drain the queue before we shut down
+            if(m_jobs.empty())
+            {
+                break;
+            }
+
+            job = m_jobs.front();
+            m_jobs.pop_front();
+            m_writing = true;
+        }
+
+        bool ok = true;
+        try
+        {
+            WriteFiles(job->m_data, *job);
+        }
+        catch(conduit::Error &e)
+        {
+            STRAWMAN_INFO("Async save of " << job->m_output_file 
+                          << " failed: " << e.message());
+            ok = false;
+        }
+        catch(std::exception &e)
+        {
+            // for example bad_alloc, which must not terminate the 
+            // simulation from this thread
+            STRAWMAN_INFO("Async save of " << job->m_output_file 
+                          << " failed: " << e.what());
+            ok = false;
+        }
+        catch(...)
+        {
+            STRAWMAN_INFO("Async save of " << job->m_output_file 
+                          << " failed with an unknown exception");
+            ok = false;
+        }
 
-        string root_file = oss.str();
+        {
+            MutexLock lock(m_mutex);
+            m_writing = false;
+            if(ok)
+            {
+                m_completed++;
+                CommitStatic(*job);
+            }
+            else
+            {
+                m_failed++;
+                m_unreported_failures++;
+            }
+            pthread_cond_broadcast(&m_cond);
+        }
 
-        string output_dir_base, output_dir_path;
+        delete job;
+    }
+}
 
-        // TODO: Fix for windows
-        conduit::utils::rsplit_string(output_dir,
-                                      "/",
-                                      output_dir_base,
-                                      output_dir_path);
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::PostJob(SaveJob *job, int max_pending)
+{
+    StartWriter();
 
-        string output_file_pattern = conduit::utils::join_file_path(output_dir_base,
-                                                                    "domain_%06d.hdf5");
+    MutexLock lock(m_mutex);
 
+    // bound how far we run ahead of the file system, each pending
+    // save may hold a full copy of the data
+    while((int) m_jobs.size() + (m_writing ? 1 : 0) >= max_pending)
+    {
+        pthread_cond_wait(&m_cond, &m_mutex);
+    }
 
-        Node root;
-        Node &bp_idx = root["blueprint_index"];
+    m_jobs.push_back(job);
+    pthread_cond_broadcast(&m_cond);
+}
 
-        blueprint::mesh::generate_index(data,
-                                        "",
-                                        num_domains,
-                                        bp_idx["mesh"]);
-            
-        root["protocol/name"]    = "conduit_hdf5";
-        root["protocol/version"] = "0.2.1";
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::WaitForWriter()
+{
+    MutexLock lock(m_mutex);
+    while(!m_jobs.empty() || m_writing)
+    {
+        pthread_cond_wait(&m_cond, &m_mutex);
+    }
+}
 
-        root["number_of_files"]  = num_domains;
-        root["number_of_trees"]  = num_domains;
-        // TODO: make sure this is relative 
-        root["file_pattern"]     = output_file_pattern;
-        root["tree_pattern"]     = "/";
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::WaitForSaves()
+{
+    WaitForWriter();
+
+    int failed = 0;
+    {
+        MutexLock lock(m_mutex);
+        failed = m_unreported_failures;
+        m_unreported_failures = 0;
+    }
 
-        CONDUIT_INFO("Creating: " << root_file);
-        relay::io::save(root,root_file,"hdf5");
+    if(failed > 0)
+    {
+        STRAWMAN_ERROR(failed << " async save(s) failed on rank " << m_rank);
+    }
+}
 
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::IOManager::Info(Node &info)
+{
+    MutexLock lock(m_mutex);
+    info["saves/pending"]   = (int) m_jobs.size() + (m_writing ? 1 : 0);
+    info["saves/completed"] = m_completed;
+    info["saves/failed"]    = m_failed;
+    if(!m_last_write_stats.dtype().is_empty())
+    {
+        info["saves/last_write"].set(m_last_write_stats);
+    }
+    if(!m_last_lossy_stats.dtype().is_empty())
+    {
+        info["saves/lossy"].set(m_last_lossy_stats);
     }
 }
 
@@ -344,26 +2486,54 @@ BlueprintHDF5Pipeline::Publish(const conduit::Node &data)
     m_data.set_external(data);
 }
 
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::Info(conduit::Node &info)
+{
+    if(m_io != NULL)
+    {
+        m_io->Info(info);
+    }
+}
+
 //-----------------------------------------------------------------------------
 void
 BlueprintHDF5Pipeline::Execute(const conduit::Node &actions)
 {
+    Execute(actions, std::vector<bool>());
+}
+
+//-----------------------------------------------------------------------------
+// one plan for all the actions, the ones that don't run are skipped
+//-----------------------------------------------------------------------------
+void
+BlueprintHDF5Pipeline::Execute(const conduit::Node &actions,
+                                       const std::vector<bool> &run)
+{
+    m_plan.Update(actions, m_data);
     //
     // Loop over the actions
     //
-    for (int i = 0; i < actions.number_of_children(); ++i)
+    for (size_t i = 0; i < m_plan.NumSteps(); ++i)
     {
-        const Node &action = actions.child(i);
-        STRAWMAN_INFO("Executing " << action["action"].as_string());
-        
-        if (action["action"].as_string() == "save")
+        const ActionPlan::Step &step = m_plan.GetStep(i);
+        if(!ActionPlan::Runs(step, run))
         {
-            m_io->SaveToHDF5FileSet(m_data,action);
+            continue;
         }
-        else
+        STRAWMAN_INFO("Executing " << step.m_name);
+        
+        switch(step.m_type)
         {
-            STRAWMAN_INFO("Warning : unknown action "
-                          << action["action"].as_string());
+            case ActionPlan::SAVE:
+                m_io->SaveToHDF5FileSet(m_data, *step.m_action);
+                break;
+            case ActionPlan::WAIT_FOR_SAVES:
+                m_io->WaitForSaves();
+                break;
+            default:
+                STRAWMAN_INFO("Warning : unknown action " << step.m_name);
+                break;
         }
     }
 }
@@ -77,15 +77,22 @@ public:
 
     void  Publish(const conduit::Node &data);
     void  Execute(const conduit::Node &actions);
+    void  Execute(const conduit::Node &actions,
+                  const std::vector<bool> &run);
     
     void  Cleanup();
 
+    // saves/pending, saves/completed and saves/failed on this rank
+    void  Info(conduit::Node &info);
+
 private:
     class IOManager;
     IOManager  *m_io;
 
     // conduit node that (externally) holds the data from the simulation
     conduit::Node     m_data; 
+    // the compiled actions, reused while they don't change
+    ActionPlan        m_plan;
 };
 
 //-----------------------------------------------------------------------------
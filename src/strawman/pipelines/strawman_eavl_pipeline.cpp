@@ -116,6 +116,7 @@
 
 // other strawman includes
 #include <strawman_block_timer.hpp>
+#include <strawman_metrics.hpp>
 #include <strawman_png_encoder.hpp>
 #include <strawman_web_interface.hpp>
 
@@ -140,7 +141,7 @@ struct EAVLPipeline::Plot
     bool               m_hidden;
     eavlDataSet       *m_eavl_dataset;
     eavlPlot          *m_eavl_plot;
-    Node               m_render_options;
+    ActionPlan::RenderOptions m_render_options;
 };
 
 
@@ -256,7 +257,9 @@ public:
                   int dims,
                   const char *image_file_name);
  
-      void WebSocketPush(PNGEncoder &png);
+      void WebSocketPush(const unsigned char *color_buffer,
+                         int image_width,
+                         int image_height);
       void WebSocketPush(const std::string &img_file_path);
   
   
@@ -378,6 +381,11 @@ EAVLPipeline::DataAdapter::BlueprintToEAVLDataSet(Node &node,
     string coords_name   = n_topo["coordset"].as_string();
     const Node &n_coords = node["coordsets"][coords_name];
 
+    Metrics::Add("bytes_converted",
+                 (double)(n_coords.total_bytes_compact() +
+                          n_topo.total_bytes_compact() +
+                          n_field.total_bytes_compact()));
+
     int neles  = 0;
     int nverts = 0;
 
@@ -862,7 +870,8 @@ EAVLPipeline::Renderer::SetOptions(const Node &options)
         m_web_stream_enabled = true;
     }
     
-    
+    // streaming policy: web/format, web/max_fps, web/max_bandwidth
+    m_web_interface.SetOptions(options);
 }
 
 //-----------------------------------------------------------------------------
@@ -918,7 +927,9 @@ EAVLPipeline::Renderer::ClearScene()
  
 //-----------------------------------------------------------------------------
 void
-EAVLPipeline::Renderer::WebSocketPush(PNGEncoder &png)
+EAVLPipeline::Renderer::WebSocketPush(const unsigned char *color_buffer,
+                                      int image_width,
+                                      int image_height)
 {
     // no op if web streaming isn't enabled
     if( !m_web_stream_enabled )
@@ -959,7 +970,10 @@ EAVLPipeline::Renderer::WebSocketPush(PNGEncoder &png)
     msg.print();
     
     m_web_interface.PushMessage(msg);
-    m_web_interface.PushImage(png);
+    m_web_interface.PushImage(color_buffer,
+                              image_width,
+                              image_height,
+                              msg["data"]);
  }
 
 
@@ -1009,7 +1023,7 @@ EAVLPipeline::Renderer::WebSocketPush(const std::string &img_file_path)
     std::string img_file_path_full(img_file_path);
     img_file_path_full = img_file_path_full + ".png";
 
-    m_web_interface.PushImage(img_file_path_full);
+    m_web_interface.PushImage(img_file_path_full, msg["data"]);
  }
 
 
@@ -1218,6 +1232,9 @@ EAVLPipeline::Renderer::Render(eavlPlot *plot,
                 free(vis_order);
             }
 
+            Metrics::Add("pixels_composited",
+                         (double) image_width * image_height);
+
     
         //---------------------------------------------------------------------
         }// close block for RENDER_COMPOSITE Timer
@@ -1241,33 +1258,31 @@ EAVLPipeline::Renderer::Render(eavlPlot *plot,
 #endif
         //
         // If we have a file name, write to disk, otherwise stream
+        // (streamed images are encoded by the web interface)
         //
-        bool encode_image = true;
-#ifdef PARALLEL
-        if(m_rank != 0) encode_image = false;
-#endif
-        if(encode_image)
-        {
-            m_png_data.Encode(result_color_buffer,
-                              image_width,
-                              image_height);
-        }
         if(image_file_name != NULL)
         {
             bool save_image = true;
 #ifdef PARALLEL
             if(m_rank != 0) save_image = false;
 #endif
-            string ofname(image_file_name);
-            ofname +=  ".png";
             if(save_image)
             {
+                m_png_data.Encode(result_color_buffer,
+                                  image_width,
+                                  image_height);
+                Metrics::Add("image_bytes",
+                             (double) m_png_data.PngBufferSize());
+                string ofname(image_file_name);
+                ofname +=  ".png";
                 m_png_data.Save(ofname);
             }
         }
         else
-        // png will be null if rank !=0, thats fine
-            WebSocketPush(m_png_data);
+        // color buffer will be null if rank !=0, thats fine
+            WebSocketPush(result_color_buffer,
+                          image_width,
+                          image_height);
     }// end try
 
     catch(const eavlException &e)
@@ -2149,29 +2164,43 @@ EAVLPipeline::Publish(const conduit::Node &data)
 void
 EAVLPipeline::Execute(const conduit::Node &actions)
 {
+    Execute(actions, std::vector<bool>());
+}
+
+//-----------------------------------------------------------------------------
+// one plan for all the actions, the ones that don't run are skipped
+//-----------------------------------------------------------------------------
+void
+EAVLPipeline::Execute(const conduit::Node &actions,
+                              const std::vector<bool> &run)
+{
+    m_plan.Update(actions, m_data);
     //
     // Loop over the actions
     //
-    for (int i = 0; i < actions.number_of_children(); ++i)
+    for (size_t i = 0; i < m_plan.NumSteps(); ++i)
     {
-        const Node &action = actions.child(i);
-        STRAWMAN_INFO("Executing " << action["action"].as_string());
-        
-        if (action["action"].as_string() == "add_plot")
-        {
-            AddPlot(action);
-        }
-        else if (action["action"].as_string() == "add_filter")
+        const ActionPlan::Step &step = m_plan.GetStep(i);
+        if(!ActionPlan::Runs(step, run))
         {
-            AddFilter(action);
+            continue;
         }
-        else if (action["action"].as_string() == "draw_plots")
-        {
-            DrawPlots();
-        }
-        else
+        STRAWMAN_INFO("Executing " << step.m_name);
+        
+        switch(step.m_type)
         {
-            STRAWMAN_INFO("Warning : unknown action "<<action["action"].as_string());
+            case ActionPlan::ADD_PLOT:
+                AddPlot(step);
+                break;
+            case ActionPlan::ADD_FILTER:
+                AddFilter(*step.m_action);
+                break;
+            case ActionPlan::DRAW_PLOTS:
+                DrawPlots();
+                break;
+            default:
+                STRAWMAN_INFO("Warning : unknown action "<<step.m_name);
+                break;
         }
     }
 }
@@ -2551,9 +2580,9 @@ EAVLPipeline::CellToNodeFilter(const conduit::Node &node)
 
 //-----------------------------------------------------------------------------
 void
-EAVLPipeline::AddPlot(const conduit::Node &action)
+EAVLPipeline::AddPlot(const ActionPlan::Step &step)
 {
-    const std::string field_name = action["field_name"].as_string();
+    const std::string &field_name = step.m_field_name;
 
     //
     // Create the plot.
@@ -2579,14 +2608,7 @@ EAVLPipeline::AddPlot(const conduit::Node &action)
     plot.m_eavl_plot->SetField(field_name.c_str());
     plot.m_eavl_plot->SetColorTableByName("Spectral");
    
-    if(action.has_path("render_options"))
-    {
-      plot.m_render_options = action.fetch("render_options"); 
-    }
-    else 
-    {
-        plot.m_render_options = conduit::Node(); 
-    }
+    plot.m_render_options = step.m_render;
     
     if(DEBUG) 
     {
@@ -2620,27 +2642,14 @@ EAVLPipeline::DrawPlots()
 
 //-----------------------------------------------------------------------------
 void
-EAVLPipeline::RenderPlot(const int plot_id, conduit::Node &render_options)
+EAVLPipeline::RenderPlot(const int plot_id, 
+                         ActionPlan::RenderOptions &render_options)
 { 
     
     STRAWMAN_BLOCK_TIMER(SAVE_WINDOW);
 
-    //
-    // Extract the save image attributes.
-    //
-
-    int image_width  = 1024;
-    int image_height = 1024;
-    
-    if(render_options.has_path("width"))
-    {
-        image_width = render_options["width"].to_int();
-    }
-    
-    if(render_options.has_path("height"))
-    {
-        image_height = render_options["height"].to_int();
-    }
+    int image_width  = render_options.m_width;
+    int image_height = render_options.m_height;
 
     Renderer::RenderMode m_render_mode;
 
@@ -2656,27 +2665,13 @@ EAVLPipeline::RenderPlot(const int plot_id, conduit::Node &render_options)
     int topo_dims = m_plots[0].m_eavl_dataset->GetCellSet(m_plots[0].m_cell_set_name)->GetDimensionality();
     const int render_dims = m_plots[0].m_eavl_dataset->GetCoordinateSystem(0)->GetDimension();
 
-    if(render_options.has_path("renderer"))
+    if(render_options.m_renderer == ActionPlan::RENDERER_VOLUME)
     {
-        if(render_options["renderer"].as_string() == "opengl")
-        {
-            m_render_mode = Renderer::OPENGL;
-        }
-        else if(render_options["renderer"].as_string() == "volume")
-        {
-            m_render_mode = Renderer::VOLUME;
-        }
-        else if(render_options["renderer"].as_string() == "raytracer")
-        {
-            m_render_mode = Renderer::RAYTRACER;
-        }
-        else
-        {
-            STRAWMAN_INFO( "EAVL Pipeline: unknown renderer "
-                           << render_options["Renderer"].as_string() << endl
-                           << "Defaulting to OpenGl");
-            m_render_mode = Renderer::OPENGL;
-        }
+        m_render_mode = Renderer::VOLUME;
+    }
+    else if(render_options.m_renderer == ActionPlan::RENDERER_RAYTRACER)
+    {
+        m_render_mode = Renderer::RAYTRACER;
     }
     else
     {
@@ -2688,14 +2683,14 @@ EAVLPipeline::RenderPlot(const int plot_id, conduit::Node &render_options)
         STRAWMAN_ERROR("Volume rendering is only supported for 3D data sets.");
     }
 
-    char *image_file_name = NULL;
+    const char *image_file_name = NULL;
     
     //
     // If a file name is provided, then save the image, otherwise start a web server
     //
-    if(render_options.has_path("file_name"))
+    if(!render_options.m_file_name.empty())
     {
-       image_file_name = render_options["file_name"].as_char8_str();
+       image_file_name = render_options.m_file_name.c_str();
     }
     else 
     {   
@@ -2722,18 +2717,18 @@ EAVLPipeline::RenderPlot(const int plot_id, conduit::Node &render_options)
     //
     //    Check for camera attributes
     //
-    if(render_options.has_path("camera")) 
+    if(!render_options.m_camera.dtype().is_empty()) 
     {
-        m_renderer->SetCameraParams(render_options.fetch("camera"));
+        m_renderer->SetCameraParams(render_options.m_camera);
     }
         
     //
     // Check for Color Map
     //
     
-    if(render_options.has_path("color_map"))
+    if(!render_options.m_color_map.dtype().is_empty())
     {
-        m_renderer->SetTransferFunctionParams(render_options.fetch("color_map"));
+        m_renderer->SetTransferFunctionParams(render_options.m_color_map);
     }
   
 
@@ -77,6 +77,8 @@ public:
 
     void  Publish(const conduit::Node &data);
     void  Execute(const conduit::Node &actions);
+    void  Execute(const conduit::Node &actions,
+                  const std::vector<bool> &run);
     
     void  Cleanup();
 
@@ -88,9 +90,10 @@ private:
     
     
     // actions
-    void            AddPlot(const conduit::Node &options);
+    void            AddPlot(const ActionPlan::Step &step);
     void            DrawPlots();
-    void            RenderPlot(const int plot_id, conduit::Node &options);
+    void            RenderPlot(const int plot_id, 
+                               ActionPlan::RenderOptions &options);
 
 
     //filters and mutators
@@ -111,6 +114,9 @@ private:
     // rendering
     Renderer          *m_renderer;
 
+    // the compiled actions, reused while they don't change
+    ActionPlan        m_plan;
+
 };
 
 //-----------------------------------------------------------------------------
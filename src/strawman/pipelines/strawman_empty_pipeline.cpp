@@ -188,18 +188,41 @@ EmptyPipeline::Publish(const conduit::Node &data)
 void
 EmptyPipeline::Execute(const conduit::Node &actions)
 {
+    Execute(actions, std::vector<bool>());
+}
+
+//-----------------------------------------------------------------------------
+// one plan for all the actions, the ones that don't run are skipped
+//-----------------------------------------------------------------------------
+void
+EmptyPipeline::Execute(const conduit::Node &actions,
+                               const std::vector<bool> &run)
+{
+    m_plan.Update(actions, m_data);
+
     // Loop over the actions
-    for (int i = 0; i < actions.number_of_children(); ++i)
+    for (size_t i = 0; i < m_plan.NumSteps(); ++i)
     {
-        const Node &action = actions.child(i);
-        string action_name = action["action"].as_string();
+        const ActionPlan::Step &step = m_plan.GetStep(i);
+        if(!ActionPlan::Runs(step, run))
+        {
+            continue;
+        }
 
-        STRAWMAN_INFO("Executing " << action_name);
+        STRAWMAN_INFO("Executing " << step.m_name);
 
         // implement action
     }
 }
 
+//-----------------------------------------------------------------------------
+void
+EmptyPipeline::Info(conduit::Node &info)
+{
+    info["action_plan/compiles"] = m_plan.Compiles();
+    info["action_plan/steps"]    = (int) m_plan.NumSteps();
+}
+
 
 
 
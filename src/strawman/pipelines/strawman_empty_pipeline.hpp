@@ -75,14 +75,21 @@ public:
 
     void  Publish(const conduit::Node &data);
     void  Execute(const conduit::Node &actions);
+    void  Execute(const conduit::Node &actions,
+                  const std::vector<bool> &run);
     
     void  Cleanup();
 
+    // how often the actions were compiled
+    void  Info(conduit::Node &info);
+
 private:
     // holds options passed to initialize
     conduit::Node     m_pipeline_options;
     // conduit node that (externally) holds the data from the simulation
     conduit::Node     m_data; 
+    // the compiled actions, reused while they don't change
+    ActionPlan        m_plan;
 };
 
 //-----------------------------------------------------------------------------
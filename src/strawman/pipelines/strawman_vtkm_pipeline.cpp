@@ -176,6 +176,14 @@ VTKMPipeline::Execute(const conduit::Node &actions)
     m_backend->Execute(actions);
 }
 
+//-----------------------------------------------------------------------------
+void
+VTKMPipeline::Execute(const conduit::Node &actions,
+                      const std::vector<bool> &run)
+{
+    m_backend->Execute(actions, run);
+}
+
 
 
 //-----------------------------------------------------------------------------
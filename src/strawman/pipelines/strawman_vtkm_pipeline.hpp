@@ -78,6 +78,8 @@ public:
 
     void  Publish(const conduit::Node &data);
     void  Execute(const conduit::Node &actions);
+    void  Execute(const conduit::Node &actions,
+                  const std::vector<bool> &run);
     
     void  Cleanup();
 
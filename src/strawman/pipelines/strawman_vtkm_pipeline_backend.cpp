@@ -72,6 +72,8 @@
 
 // other strawman includes
 #include <strawman_block_timer.hpp>
+#include <strawman_memory_tracker.hpp>
+#include <strawman_metrics.hpp>
 
 using namespace std;
 using namespace conduit;
@@ -87,6 +89,9 @@ namespace strawman
 typedef vtkm::cont::DataSet                vtkmDataSet;
 typedef vtkm::rendering::Actor             vtkmActor;
 
+// smallest image a render budget scales down to
+const int MIN_IMAGE_SIZE = 128;
+
 template <class DEVICE_ADAPTOR>
 struct VTKMPipelineBackend<DEVICE_ADAPTOR>::Plot
 {
@@ -96,7 +101,9 @@ struct VTKMPipelineBackend<DEVICE_ADAPTOR>::Plot
     bool               m_hidden;
     vtkmDataSet       *m_data_set;     //typedefs are in renderer TODO: move to typedefs file
     vtkmActor         *m_plot;
-    Node               m_render_options;
+    ActionPlan::RenderOptions m_render_options;
+    // counted with the memory tracker until the data set is deleted
+    int64              m_converted_bytes;
 };
 
 
@@ -110,7 +117,8 @@ template <class DEVICE_ADAPTOR>
 vtkm::cont::DataSet *
 VTKMPipelineBackend<DEVICE_ADAPTOR>::DataAdapter::BlueprintToVTKmDataSet
     (const Node &node, 
-     const std::string &field_name)
+     const std::string &field_name,
+     int64 &converted_bytes)
 {   
     STRAWMAN_BLOCK_TIMER(PIPELINE_GET_DATA);
     
@@ -132,6 +140,11 @@ VTKMPipelineBackend<DEVICE_ADAPTOR>::DataAdapter::BlueprintToVTKmDataSet
     string coords_name   = n_topo["coordset"].as_string();
     const Node &n_coords = node["coordsets"][coords_name];
 
+    Metrics::Add("bytes_converted",
+                 (double)(n_coords.total_bytes_compact() +
+                          n_topo.total_bytes_compact() +
+                          n_field.total_bytes_compact()));
+
     int neles  = 0;
     int nverts = 0;
 
@@ -177,6 +190,19 @@ VTKMPipelineBackend<DEVICE_ADAPTOR>::DataAdapter::BlueprintToVTKmDataSet
         STRAWMAN_ERROR("Unsupported topology/type:" << mesh_type);
     }
     
+    // unstructured meshes get their cell shapes and counts, and 2d 
+    // coordinates a zero z array
+    converted_bytes = 0;
+    if(mesh_type == "unstructured")
+    {
+        converted_bytes = (int64) neles * (sizeof(vtkm::UInt8) + 
+                                           sizeof(vtkm::IdComponent));
+        if(!n_coords.has_path("values/z"))
+        {
+            converted_bytes += (int64) nverts * sizeof(vtkm::Float64);
+        }
+    }
+
     // add var
     AddVariableField(field_name,
                      n_field,
@@ -712,6 +738,7 @@ VTKMPipelineBackend<DEVICE_ADAPTOR>::Initialize(const conduit::Node &options)
     int mpi_handle = options["mpi_comm"].value();
     MPI_Comm comm = MPI_Comm_f2c(mpi_handle);
     m_renderer = new Renderer<DEVICE_ADAPTOR>(comm);
+    m_budget.SetMPICommHandle(mpi_handle);
 #ifdef VTKM_CUDA
     //
     //  If we are using cuda, figure out how many devices we have and
@@ -754,7 +781,13 @@ VTKMPipelineBackend<DEVICE_ADAPTOR>::Initialize(const conduit::Node &options)
     m_renderer = new Renderer<DEVICE_ADAPTOR>;
 
 #endif
-    
+    // pass along any web streaming options (web/stream, web/format, ...)
+    m_renderer->SetOptions(options);
+
+    if(options.has_child("budget"))
+    {
+        m_budget.Enable(options["budget"]);
+    }
 }
 
 
@@ -778,9 +811,11 @@ VTKMPipelineBackend<DEVICE_ADAPTOR>::Publish(const conduit::Node &data)
     {
      delete m_plots[i].m_data_set;
      delete m_plots[i].m_plot; 
+     MemoryTracker::Track(-m_plots[i].m_converted_bytes);
     }
     m_plots.clear();
     m_data.set_external(data);
+    m_renderer->SetData(&m_data);
 }
 
 //-----------------------------------------------------------------------------
@@ -788,45 +823,55 @@ template <class DEVICE_ADAPTOR>
 void
 VTKMPipelineBackend<DEVICE_ADAPTOR>::Execute(const conduit::Node &actions)
 {
+    Execute(actions, std::vector<bool>());
+}
+
+//-----------------------------------------------------------------------------
+// one plan for all the actions, the ones that don't run are skipped
+//-----------------------------------------------------------------------------
+template <class DEVICE_ADAPTOR>
+void
+VTKMPipelineBackend<DEVICE_ADAPTOR>::Execute(const conduit::Node &actions,
+                                             const std::vector<bool> &run)
+{
+    m_budget.BeginExecute();
+    m_plan.Update(actions, m_data);
     //
     // Loop over the actions
     //
-    for (int i = 0; i < actions.number_of_children(); ++i)
+    for (size_t i = 0; i < m_plan.NumSteps(); ++i)
     {
-        const Node &action = actions.child(i);
-        if(!action.has_path("action"))
+        const ActionPlan::Step &step = m_plan.GetStep(i);
+        if(!ActionPlan::Runs(step, run))
         {
-            STRAWMAN_INFO("Warning : action malformed");
-            action.print();
-            std::cout<<"\n";
             continue;
         }
-        STRAWMAN_INFO("Executing " << action["action"].as_string());
+        STRAWMAN_INFO("Executing " << step.m_name);
        
-        if (action["action"].as_string() == "add_plot")
+        switch(step.m_type)
         {
-            AddPlot(action);
-        }
-        else if (action["action"].as_string() == "add_filter")
-        {
-            STRAWMAN_INFO("VTKm add_filter not implemented");
-        }
-        else if (action["action"].as_string() == "draw_plots")
-        {
-            DrawPlots();
-        }
-        else
-        {
-            STRAWMAN_INFO("Warning : unknown action "<<action["action"].as_string());
+            case ActionPlan::ADD_PLOT:
+                AddPlot(step);
+                break;
+            case ActionPlan::ADD_FILTER:
+                STRAWMAN_INFO("VTKm add_filter not implemented");
+                break;
+            case ActionPlan::DRAW_PLOTS:
+                DrawPlots();
+                break;
+            default:
+                STRAWMAN_INFO("Warning : unknown action "<<step.m_name);
+                break;
         }
    }
+   m_budget.EndExecute();
 }
 //-----------------------------------------------------------------------------
 template <class DEVICE_ADAPTOR>
 void
-VTKMPipelineBackend<DEVICE_ADAPTOR>::AddPlot(const conduit::Node &action)
+VTKMPipelineBackend<DEVICE_ADAPTOR>::AddPlot(const ActionPlan::Step &step)
 {
-    const std::string field_name = action["field_name"].as_string();
+    const std::string &field_name = step.m_field_name;
 
     vtkm::rendering::ColorTable color_table("Spectral");
     //
@@ -836,13 +881,13 @@ VTKMPipelineBackend<DEVICE_ADAPTOR>::AddPlot(const conduit::Node &action)
     plot.m_var_name = field_name;
     plot.m_drawn = false;
     plot.m_hidden = false;
-    plot.m_data_set = DataAdapter::BlueprintToVTKmDataSet(m_data,field_name);
-    
-    // we need the topo name ...
-    const Node &n_field  = m_data["fields"][field_name];
-    string topo_name     = n_field["topology"].as_string();
+    plot.m_data_set = DataAdapter::BlueprintToVTKmDataSet(m_data,
+                                                          field_name,
+                                                          plot.m_converted_bytes);
+    MemoryTracker::Track(plot.m_converted_bytes);
     
-    plot.m_cell_set_name = topo_name;
+    // resolved when the plan was compiled
+    plot.m_cell_set_name = step.m_topology;
     try
     {
         STRAWMAN_BLOCK_TIMER(PLOT)
@@ -854,14 +899,7 @@ VTKMPipelineBackend<DEVICE_ADAPTOR>::AddPlot(const conduit::Node &action)
                                     plot.m_data_set->GetCoordinateSystem(),
                                     plot.m_data_set->GetField(field_name),
                                     color_table);
-        if(action.has_path("render_options"))
-        {
-            plot.m_render_options = action.fetch("render_options"); 
-        }
-        else 
-        {
-            plot.m_render_options = conduit::Node(); 
-        }
+        plot.m_render_options = step.m_render;
     }
     catch (vtkm::cont::Error error) 
     {
@@ -876,100 +914,85 @@ template <class DEVICE_ADAPTOR>
 void 
 VTKMPipelineBackend<DEVICE_ADAPTOR>::DrawPlots()
 {
+    m_budget.BeginRender();
+    m_renderer->SetVolumeSampleScale((float) m_budget.Scale());
+
+    bool volume = false;
     for (int i = 0; i < m_plots.size(); ++i)
     {
         if(!m_plots[i].m_hidden)
         {
             RenderPlot(i, m_plots[i].m_render_options);
             m_plots[i].m_drawn = true;
+            volume = volume || m_plots[i].m_render_options.m_renderer == 
+                               ActionPlan::RENDERER_VOLUME;
         }
         else m_plots[i].m_drawn = false;
     }
+    m_budget.EndRender(volume);
 }
 
 //-----------------------------------------------------------------------------
 template <class DEVICE_ADAPTOR>
 void
 VTKMPipelineBackend<DEVICE_ADAPTOR>::RenderPlot(const int plot_id,
-                                                const conduit::Node &render_options)
+                                                const ActionPlan::RenderOptions &render_options)
 { 
-    render_options.print();
-    
     STRAWMAN_BLOCK_TIMER(RENDER_PLOTS);
 
-    //
-    // Extract the save image attributes.
-    //
-
-    int image_width  = 1024;
-    int image_height = 1024;
-    
-    if(render_options.has_path("width"))
-    {
-        image_width = render_options["width"].to_int();
-    }
-    if(render_options.has_path("height"))
-    {
-        image_height = render_options["height"].to_int();
-    }
+    // smaller than asked for when over the budget
+    int image_width  = m_budget.Scale(render_options.m_width, MIN_IMAGE_SIZE);
+    int image_height = m_budget.Scale(render_options.m_height, MIN_IMAGE_SIZE);
 
-    RendererType m_render_mode;
     //
-    // Determine the render mode, default is opengl.
+    // Determine the render mode, default is the ray tracer.
     //
-
-    if(render_options.has_path("renderer"))
+    RendererType m_render_mode = RAYTRACER;
+    if(render_options.m_renderer == ActionPlan::RENDERER_VOLUME)
     {
-        if(render_options["renderer"].as_string() == "volume")
-        {
-            m_render_mode = VOLUME;
-        }
-        else if(render_options["renderer"].as_string() == "raytracer")
-        {
-            m_render_mode = RAYTRACER;
-        }
-        else
-        {
-            STRAWMAN_INFO( "VTK-m Pipeline: unknown renderer "
-                           << render_options["Renderer"].as_string() << endl
-                           << "Defaulting to ray tracer");
-            m_render_mode = RAYTRACER;
-        }
+        m_render_mode = VOLUME;
     }
-    else
+    else if(render_options.m_renderer == ActionPlan::RENDERER_OPENGL)
     {
-        m_render_mode = RAYTRACER;
+        STRAWMAN_INFO( "VTK-m Pipeline: unsupported renderer opengl" << endl
+                       << "Defaulting to ray tracer");
     }
     
     const char *image_file_name = NULL;
     //
     // If a file name is provided, then save the image, otherwise start a web server
     //
-    if(render_options.has_path("file_name"))
+    if(!render_options.m_file_name.empty())
     {
-       image_file_name = render_options["file_name"].as_char8_str();
+       image_file_name = render_options.m_file_name.c_str();
     }
     else 
     {
         conduit::Node options;
         options["web/stream"] = "true";
         m_renderer->SetOptions(options);
+
+        // nothing to save and no client waiting for a frame
+        if(!m_renderer->WebFrameWanted())
+        {
+            return;
+        }
     }
     
     //
     //    Check for camera attributes
     //
-    if(render_options.has_path("camera")) 
+    if(!render_options.m_camera.dtype().is_empty()) 
     {
-        m_renderer->SetCamera(render_options.fetch("camera"));
+        m_renderer->SetCamera(render_options.m_camera);
     }
     
     //
     // Check for Color Map
     //
-    if(render_options.has_path("color_map"))
+    if(!render_options.m_color_map.dtype().is_empty())
     {
-        m_renderer->SetTransferFunction(render_options.fetch("color_map"));
+        m_renderer->SetTransferFunction(render_options.m_color_map);
     }
     int dims = 3;
     
@@ -53,6 +53,7 @@
 #define STRAWMAN_VTKM_PIPELINE_BACKEND_HPP
 
 #include "strawman_pipeline.hpp"
+#include "strawman_render_budget.hpp"
 
 
 // thirdparty includes
@@ -95,6 +96,8 @@ public:
 
     void  Publish(const conduit::Node &data);
     void  Execute(const conduit::Node &actions);
+    void  Execute(const conduit::Node &actions,
+                  const std::vector<bool> &run);
     
     void  Cleanup();
 
@@ -112,8 +115,11 @@ public:
     //
     //  conduit::blueprint::mesh::verify(n,info) == true
     //
+    // converted_bytes is the size of the arrays the conversion had to 
+    // allocate, the rest of the data set points at the blueprint data
     static vtkm::cont::DataSet  *BlueprintToVTKmDataSet(const conduit::Node &n,
-                                                        const std::string &field_name);
+                                                        const std::string &field_name,
+                                                        conduit::int64 &converted_bytes);
 
 
 private:
@@ -165,7 +171,7 @@ private:
     // Actions
     void            DrawPlots();
     void            RenderPlot(const int plot_id,
-                               const conduit::Node &render_options);
+                               const ActionPlan::RenderOptions &render_options);
     // conduit node that (externally) holds the data from the simulation 
     conduit::Node     m_data; 
 
@@ -175,8 +181,12 @@ private:
     Renderer<DEVICE_ADAPTOR> *m_renderer;
 
     int cuda_device;
+    // the compiled actions, reused while they don't change
+    ActionPlan        m_plan;
+    // lowers the render quality to keep Execute in the budget option
+    RenderBudget      m_budget;
     // actions
-    void            AddPlot(const conduit::Node &action);
+    void            AddPlot(const ActionPlan::Step &step);
 };
 
 //-----------------------------------------------------------------------------
@@ -54,16 +54,64 @@
 #include <string.h>
 #include <limits.h>
 #include <cstdlib>
+#include <cmath>
 #include <sstream>
 
 // other strawman includes
 #include <strawman_block_timer.hpp>
+#include <strawman_memory_tracker.hpp>
+#include <strawman_metrics.hpp>
 #include <strawman_png_encoder.hpp>
 #include <strawman_web_interface.hpp>
 
 using namespace std;
 using namespace conduit;
 namespace strawman {
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+typedef vtkm::Vec<vtkm::Float32,3> vtkmVec3f;
+
+//-----------------------------------------------------------------------------
+vtkmVec3f
+cross(const vtkmVec3f &a, const vtkmVec3f &b)
+{
+    return vtkmVec3f(a[1] * b[2] - a[2] * b[1],
+                     a[2] * b[0] - a[0] * b[2],
+                     a[0] * b[1] - a[1] * b[0]);
+}
+
+//-----------------------------------------------------------------------------
+// rotates v around the unit vector axis (Rodrigues' formula)
+//-----------------------------------------------------------------------------
+vtkmVec3f
+rotate(const vtkmVec3f &v, const vtkmVec3f &axis, vtkm::Float32 degrees)
+{
+    const vtkm::Float32 pi = 3.14159265f;
+    vtkm::Float32 theta = degrees * (pi / 180.f);
+    vtkm::Float32 c = std::cos(theta);
+    vtkm::Float32 s = std::sin(theta);
+
+    vtkmVec3f     axv = cross(axis, v);
+    vtkm::Float32 dot = axis[0] * v[0] + axis[1] * v[1] + axis[2] * v[2];
+
+    vtkmVec3f res;
+    for(int i = 0; i < 3; ++i)
+    {
+        res[i] = v[i] * c + axv[i] * s + axis[i] * dot * (1.f - c);
+    }
+    return res;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
 //-----------------------------------------------------------------------------
 // Renderer public methods
 //-----------------------------------------------------------------------------
@@ -101,6 +149,7 @@ void
 Renderer<DeviceAdapter>::Init()
 {
     m_camera.reset();
+    m_web_camera.reset();
     m_transfer_function.reset();
 
     m_bg_color.Components[0] = 1.0f;
@@ -109,6 +158,9 @@ Renderer<DeviceAdapter>::Init()
     m_bg_color.Components[3] = 1.0f;
 
     m_web_stream_enabled = false;
+    m_data               = NULL;
+    m_canvas_bytes       = 0;
+    m_volume_sample_scale = 1.0f;
 }
 
 //-----------------------------------------------------------------------------
@@ -130,6 +182,7 @@ Renderer<DeviceAdapter>::Cleanup()
     if(m_canvas)
     {
         delete m_canvas;
+        TrackCanvas(0, 0);
     }
 
     if(m_renderer)
@@ -145,6 +198,18 @@ Renderer<DeviceAdapter>::Cleanup()
     NullRendering();
 }
 
+//-----------------------------------------------------------------------------
+template<typename DeviceAdapter>
+void
+Renderer<DeviceAdapter>::TrackCanvas(int width, int height)
+{
+    // rgba color and depth, all floats
+    conduit::int64 canvas_bytes = (conduit::int64) width * height * 5 * 
+                                  sizeof(vtkm::Float32);
+    MemoryTracker::Track(canvas_bytes - m_canvas_bytes);
+    m_canvas_bytes = canvas_bytes;
+}
+
 //-----------------------------------------------------------------------------
 template<typename DeviceAdapter>
 void
@@ -182,6 +247,7 @@ Renderer<DeviceAdapter>::InitRendering(int plot_dims)
     }
     m_renderer->SetBackgroundColor(m_bg_color);
     m_canvas = new vtkmCanvasRayTracer(1024,1024, m_bg_color);
+    TrackCanvas(1024, 1024);
 
     if(m_canvas == NULL)
     {
@@ -514,7 +580,8 @@ Renderer<DeviceAdapter>::SetOptions(const Node &options)
         m_web_stream_enabled = true;
     }
     
-    
+    // streaming policy: web/format, web/max_fps, web/max_bandwidth
+    m_web_interface.SetOptions(options);
 }
 //-----------------------------------------------------------------------------
 template<typename DeviceAdapter>
@@ -685,12 +752,22 @@ Renderer<DeviceAdapter>::SetCamera(const Node &camera_params)
     m_camera.set(camera_params);
 }
 
+//-----------------------------------------------------------------------------
+template<typename DeviceAdapter>
+void
+Renderer<DeviceAdapter>::SetVolumeSampleScale(float scale)
+{
+    m_volume_sample_scale = scale;
+}
+
 //-----------------------------------------------------------------------------
 //
 //-----------------------------------------------------------------------------
 template<typename DeviceAdapter>
 void
-Renderer<DeviceAdapter>::WebSocketPush(PNGEncoder &png)
+Renderer<DeviceAdapter>::WebSocketPush(const float *color_buffer,
+                                       int image_width,
+                                       int image_height)
 {
     // no op if web streaming isn't enabled
     if( !m_web_stream_enabled )
@@ -722,18 +799,48 @@ Renderer<DeviceAdapter>::WebSocketPush(PNGEncoder &png)
     
     Node status;
     status["type"] = "status";
-    status["state"] = 1;
-    status["domain"] = 1;
-    //status = m_data->fetch("state");
-    //status.remove("domain");
+    if(m_data != NULL && m_data->has_path("state"))
+    {
+        status["data"] = m_data->fetch("state");
+        if(status["data"].has_child("domain"))
+        {
+            status["data"].remove("domain");
+        }
+    }
     status["data/ndomains"] = ndomains;
     
     m_web_interface.PushMessage(status);
-    m_web_interface.PushImage(png);
-     
-
+    m_web_interface.PushImage(color_buffer,
+                              image_width,
+                              image_height,
+                              status["data"]);
  }
 
+//-----------------------------------------------------------------------------
+template<typename DeviceAdapter>
+bool
+Renderer<DeviceAdapter>::WebFrameWanted()
+{
+    if( !m_web_stream_enabled )
+    {
+        return false;
+    }
+
+    // only the root proc talks to the web client, but the answer
+    // decides if we render at all, so every proc needs it
+    int wanted = 0;
+    if(m_rank == 0)
+    {
+        wanted = m_web_interface.FrameWanted() ? 1 : 0;
+    }
+
+#ifdef PARALLEL
+    MPI_Bcast(&wanted, 1, MPI_INT, 0, m_mpi_comm);
+#endif
+
+    return wanted != 0;
+}
+
  //-----------------------------------------------------------------------------
 template<typename DeviceAdapter>
 void
@@ -770,14 +877,19 @@ Renderer<DeviceAdapter>::WebSocketPush(const std::string &img_file_path)
 
     Node status;
     status["type"] = "status";
-    status = m_data->fetch("state");
-    status.remove("domain");
+    if(m_data != NULL && m_data->has_path("state"))
+    {
+        status["data"] = m_data->fetch("state");
+        if(status["data"].has_child("domain"))
+        {
+            status["data"].remove("domain");
+        }
+    }
     status["data/ndomains"] = ndomains;
-    status.print();
     std::string img_file_path_full(img_file_path);
     img_file_path_full = img_file_path_full + ".png";
     m_web_interface.PushMessage(status);
-    m_web_interface.PushImage(img_file_path_full);
+    m_web_interface.PushImage(img_file_path_full, status["data"]);
 
  }
 
@@ -858,6 +970,7 @@ Renderer<DeviceAdapter>::Render(vtkmActor *plot,
         {
             delete m_canvas;
             m_canvas = new vtkmCanvasRayTracer(image_width,image_height, m_bg_color);
+            TrackCanvas(image_width, image_height);
         }
         
         
@@ -871,6 +984,18 @@ Renderer<DeviceAdapter>::Render(vtkmActor *plot,
         {
             SetupCamera();
         } 
+
+        //
+        // Streamed images follow the view picked in the web client
+        //
+        if(image_file_name == NULL)
+        {
+            UpdateWebCamera();
+            if(!m_web_camera.dtype().is_empty())
+            {
+                SetupWebCamera();
+            }
+        }
        
         //
         // Check for transfer function / color table
@@ -897,8 +1022,12 @@ Renderer<DeviceAdapter>::Render(vtkmActor *plot,
         if(m_render_type == VOLUME)
         {
 
-              //set sample distance
-              const vtkm::Float32 num_samples = 200.f;
+              //set sample distance, a budget may take fewer samples
+              vtkm::Float32 num_samples = 200.f * m_volume_sample_scale;
+              if(num_samples < 50.f)
+              {
+                  num_samples = 50.f;
+              }
               vtkm::Vec<vtkm::Float32,3> totalExtent;
               totalExtent[0] = vtkm::Float32(plot->SpatialBounds.X.Max - plot->SpatialBounds.X.Min);
               totalExtent[1] = vtkm::Float32(plot->SpatialBounds.Y.Max - plot->SpatialBounds.Y.Min);
@@ -1001,46 +1130,43 @@ Renderer<DeviceAdapter>::Render(vtkmActor *plot,
                 // leak?
                 free(vis_order);
             }
+
+            Metrics::Add("pixels_composited",
+                         (double) image_width * image_height);
         
         //---------------------------------------------------------------------
         }// close block for RENDER_COMPOSITE Timer
         //---------------------------------------------------------------------
           
                 
+#else
+        const float *result_color_buffer = &(m_canvas->ColorBuffer[0]);
+#endif
+        
         //---------------------------------------------------------------------
         {// open block for RENDER_ENCODE Timer
         //---------------------------------------------------------------------
-          
-        
         STRAWMAN_BLOCK_TIMER(RENDER_ENCODE);
         //
-        // encode the composited image
+        // encode the composited image when saving, streamed 
+        // images are encoded by the web interface
         //
-        if(m_rank == 0)
+        if(m_rank == 0 && image_file_name != NULL)
         {   
             m_png_data.Encode(result_color_buffer,
                               image_width,
                               image_height);
+            Metrics::Add("image_bytes", (double) m_png_data.PngBufferSize());
         }
         
         //---------------------------------------------------------------------
         }// close block for RENDER_ENCODE Timer
         //---------------------------------------------------------------------
-          
 
-#else
-        m_png_data.Encode(&(m_canvas->ColorBuffer[0]),
-                          image_width,
-                          image_height);
-#endif
-    
-
-#if PARALLEL
-        // png will be null if rank !=0, thats fine
-        WebSocketPush(m_png_data);
-#else
-        WebSocketPush(m_png_data);
-#endif
+        // color buffer is only valid on rank 0, thats fine
+        WebSocketPush(result_color_buffer,
+                      image_width,
+                      image_height);
 
         if(image_file_name != NULL) SaveImage(image_file_name);
     }// end try
@@ -1112,5 +1238,103 @@ Renderer<DeviceAdapter>::SetupCamera()
     }
 }
 
+//-----------------------------------------------------------------------------
+template<typename DeviceAdapter>
+void
+Renderer<DeviceAdapter>::UpdateWebCamera()
+{
+    if( !m_web_stream_enabled )
+    {
+        return;
+    }
+
+    // changed, azimuth, elevation, zoom, xpan, ypan
+    double view[6] = {0.0, 0.0, 0.0, 1.0, 0.0, 0.0};
+
+    // only the root proc talks to the web client
+    Node camera;
+    if(m_rank == 0 && m_web_interface.PopCamera(camera))
+    {
+        view[0] = 1.0;
+        if(camera.has_child("azimuth"))
+        {
+            view[1] = camera["azimuth"].to_float64();
+        }
+        if(camera.has_child("elevation"))
+        {
+            view[2] = camera["elevation"].to_float64();
+        }
+        if(camera.has_child("zoom"))
+        {
+            view[3] = camera["zoom"].to_float64();
+        }
+        if(camera.has_child("xpan"))
+        {
+            view[4] = camera["xpan"].to_float64();
+        }
+        if(camera.has_child("ypan"))
+        {
+            view[5] = camera["ypan"].to_float64();
+        }
+    }
+
+#ifdef PARALLEL
+    // every proc has to render the same view
+    MPI_Bcast(view, 6, MPI_DOUBLE, 0, m_mpi_comm);
+#endif
+
+    if(view[0] == 0.0)
+    {
+        return;
+    }
+
+    m_web_camera["azimuth"]   = view[1];
+    m_web_camera["elevation"] = view[2];
+    m_web_camera["zoom"]      = view[3];
+    m_web_camera["xpan"]      = view[4];
+    m_web_camera["ypan"]      = view[5];
+}
+
+//-----------------------------------------------------------------------------
+template<typename DeviceAdapter>
+void
+Renderer<DeviceAdapter>::SetupWebCamera()
+{
+    vtkm::Float32 azimuth   = m_web_camera["azimuth"].to_float32();
+    vtkm::Float32 elevation = m_web_camera["elevation"].to_float32();
+
+    vtkmVec3f look_at = m_vtkm_camera->Camera3d.LookAt;
+    vtkmVec3f up      = m_vtkm_camera->Camera3d.Up;
+    vtkmVec3f view;
+    for(int i = 0; i < 3; ++i)
+    {
+        view[i] = m_vtkm_camera->Camera3d.Position[i] - look_at[i];
+    }
+
+    //
+    // orbit around the look at point: azimuth turns around the up 
+    // vector, elevation tilts towards it
+    //
+    view = rotate(view, up, azimuth);
+
+    vtkmVec3f right = cross(view, up);
+    if(vtkm::Magnitude(right) > 0.f)
+    {
+        vtkm::Normalize(right);
+        view = rotate(view, right, elevation);
+        up   = rotate(up, right, elevation);
+    }
+
+    for(int i = 0; i < 3; ++i)
+    {
+        m_vtkm_camera->Camera3d.Position[i] = look_at[i] + view[i];
+    }
+    m_vtkm_camera->Camera3d.Up = up;
+
+    m_vtkm_camera->Camera3d.Zoom *= m_web_camera["zoom"].to_float32();
+    m_vtkm_camera->Camera3d.XPan += m_web_camera["xpan"].to_float32();
+    m_vtkm_camera->Camera3d.YPan += m_web_camera["ypan"].to_float32();
+}
+
 }; //namespace strawman
 
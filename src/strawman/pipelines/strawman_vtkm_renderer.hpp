@@ -133,6 +133,8 @@ public:
       void SetTransferFunction(const conduit::Node &tFunction);
       void CreateDefaultTransferFunction(vtkmColorTable &color_table);
       void SetCamera(const conduit::Node &_camera);
+      // fraction of the default volume samples to take, for budgets
+      void SetVolumeSampleScale(float scale);
       void AddPlot(vtkmActor *plot);
       void SetData(conduit::Node *data_ptr);
   
@@ -146,8 +148,13 @@ public:
                   const char *image_file_name = NULL);
  
       // TODO: Move to pipeline?
-      void WebSocketPush(PNGEncoder &png);
+      void WebSocketPush(const float *color_buffer,
+                         int image_width,
+                         int image_height);
       void WebSocketPush(const std::string &img_file_path);
+      // true if a streamed frame would be sent right now,
+      // collective in the MPI case
+      bool WebFrameWanted();
       void SaveImage(const char *image_file_name);  
 private:
 
@@ -184,7 +191,14 @@ private:
     void SetCameraAttributes(conduit::Node &node);
     void SetDefaultCameraView(vtkmActor *plot);
     void SetupCamera();
+    // picks up camera changes sent by the web client, collective
+    void UpdateWebCamera();
+    // orbits / zooms / pans the camera by the web client's view
+    void SetupWebCamera();
     vtkmColorTable  SetColorMapFromNode();
+    // counts the buffers of a width x height canvas with the memory 
+    // tracker in place of the last canvas', 0 x 0 when it is deleted
+    void TrackCanvas(int width, int height);
 //-----------------------------------------------------------------------------
 // private methods for MPI case
 //-----------------------------------------------------------------------------
@@ -202,6 +216,8 @@ private:
     vtkmCanvas         *m_canvas;
     vtkmMapper         *m_renderer;
     vtkmCamera         *m_vtkm_camera;
+    conduit::int64      m_canvas_bytes;
+    float               m_volume_sample_scale;
 
     vtkmColor           m_bg_color;
   
@@ -210,6 +226,8 @@ private:
   
     conduit::Node       m_transfer_function;
     conduit::Node       m_camera;
+    // relative to m_camera, only used for streamed images
+    conduit::Node       m_web_camera;
   
     conduit::Node      *m_data;
 
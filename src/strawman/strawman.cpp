@@ -51,6 +51,8 @@
 
 #include <strawman.hpp>
 #include <strawman_pipeline.hpp>
+#include <strawman_memory_tracker.hpp>
+#include <strawman_perf_counters.hpp>
 
 #include <pipelines/strawman_empty_pipeline.hpp>
 
@@ -66,6 +68,10 @@
     #include <pipelines/strawman_blueprint_hdf5_pipeline.hpp>
 #endif
 
+#ifdef PARALLEL
+    #include <mpi.h>
+#endif
+
 
 using namespace conduit;
 //-----------------------------------------------------------------------------
@@ -75,9 +81,16 @@ namespace strawman
 {
 //-----------------------------------------------------------------------------
 
+// trace events each rank keeps by default
+const int DEFAULT_TRACE_EVENTS = 100000;
+
 //-----------------------------------------------------------------------------
 Strawman::Strawman()
-: m_pipeline(NULL)
+: m_pipeline(NULL),
+  m_cycle(0),
+  m_time(0.0),
+  m_publish_pending(false),
+  m_actions_file("strawman_actions.json")
 {
 }
 
@@ -169,12 +182,85 @@ Strawman::Open(const conduit::Node &options)
     }
     
     m_pipeline->Initialize(processed_opts);
+
+    int rank = 0;
+#ifdef PARALLEL
+    MPI_Comm mpi_comm = MPI_COMM_WORLD;
+    if(processed_opts.has_child("mpi_comm"))
+    {
+        int mpi_handle = processed_opts["mpi_comm"].to_int();
+        mpi_comm = MPI_Comm_f2c(mpi_handle);
+        // field triggers reduce over the simulation's communicator
+        m_triggers.SetMPICommHandle(mpi_handle);
+    }
+    MPI_Comm_rank(mpi_comm, &rank);
+#endif
+
+    // optional timeline of the timed blocks
+    if(processed_opts.has_path("timers/trace") &&
+       processed_opts["timers/trace"].as_string() == "true")
+    {
+        m_trace_file = "strawman_trace.json";
+        if(processed_opts.has_path("timers/trace_file"))
+        {
+            m_trace_file = processed_opts["timers/trace_file"].as_string();
+        }
+
+        int trace_events = DEFAULT_TRACE_EVENTS;
+        if(processed_opts.has_path("timers/trace_events"))
+        {
+            trace_events = processed_opts["timers/trace_events"].to_int();
+        }
+        BlockTimer::EnableTrace(trace_events);
+    }
+
+    // how often the timers read the resident memory, default every stop
+    if(processed_opts.has_path("timers/memory_interval"))
+    {
+        MemoryTracker::SetSampleInterval(
+            processed_opts["timers/memory_interval"].to_float64());
+    }
+
+    // optional hardware counters around the timed blocks
+    if(processed_opts.has_path("timers/counters") &&
+       processed_opts["timers/counters"].as_string() == "true")
+    {
+        PerfCounters::Enable();
+    }
+
+    // optional per Execute metric snapshots
+    if(processed_opts.has_path("metrics/enabled") &&
+       processed_opts["metrics/enabled"].as_string() == "true")
+    {
+        m_metrics.Enable(processed_opts["metrics"], rank);
+    }
 }
 
 //-----------------------------------------------------------------------------
 void
 Strawman::Publish(const conduit::Node &data)
 {
+    if(data.has_path("state/cycle"))
+    {
+        m_cycle = data["state/cycle"].to_int64();
+    }
+
+    if(data.has_path("state/time"))
+    {
+        m_time = data["state/time"].to_float64();
+    }
+
+    // like the pipelines, we only reference the published arrays, so 
+    // the caller's node itself doesn't have to outlive this call
+    m_published.set_external(const_cast<Node&>(data));
+    // with triggers the pipeline only sees the data when one fires
+    if(m_triggers.Active())
+    {
+        m_publish_pending = true;
+        return;
+    }
+
+    m_publish_pending = false;
     m_pipeline->Publish(data);
 }
 
@@ -182,9 +268,60 @@ Strawman::Publish(const conduit::Node &data)
 void
 Strawman::Execute(const conduit::Node &actions)
 {
-    Node processed_actions(actions);
-    CheckForJSONFile("strawman_actions.json", processed_actions);
-    m_pipeline->Execute(processed_actions);
+    const Node &processed_actions = m_actions_file.Merge(actions);
+
+    m_triggers.Update(processed_actions);
+    if(m_triggers.Active())
+    {
+        const Node *published = NULL;
+        if(!m_published.dtype().is_empty())
+        {
+            published = &m_published;
+        }
+
+        if(!m_triggers.Evaluate(published, m_cycle, m_time))
+        {
+            return;
+        }
+    }
+
+    if(m_publish_pending)
+    {
+        m_pipeline->Publish(m_published);
+        m_publish_pending = false;
+    }
+
+    m_metrics.BeginExecute(m_cycle);
+    if(m_triggers.Active())
+    {
+        m_pipeline->Execute(processed_actions, m_triggers.Fired());
+    }
+    else
+    {
+        m_pipeline->Execute(processed_actions);
+    }
+    m_metrics.EndExecute();
+}
+
+//-----------------------------------------------------------------------------
+void
+Strawman::Info(conduit::Node &info)
+{
+    info.reset();
+    if(m_pipeline != NULL)
+    {
+        m_pipeline->Info(info);
+    }
+
+    if(m_metrics.Enabled())
+    {
+        m_metrics.Last(info["metrics/last"]);
+    }
+
+    if(m_triggers.Active())
+    {
+        info["triggers/skipped"] = m_triggers.Skipped();
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -197,6 +334,23 @@ Strawman::Close()
         delete m_pipeline;
         m_pipeline = NULL;
     }
+
+    m_published.reset();
+    m_publish_pending = false;
+
+    if(!m_trace_file.empty())
+    {
+        BlockTimer::WriteTrace(m_trace_file);
+        BlockTimer::DisableTrace();
+        m_trace_file.clear();
+    }
+
+    m_metrics.Disable();
+
+    if(PerfCounters::Enabled())
+    {
+        PerfCounters::Disable();
+    }
 }
 
 //---------------------------------------------------------------------------//
@@ -60,6 +60,9 @@
 #include <strawman_logging.hpp>
 #include <strawman_file_system.hpp>
 #include <strawman_block_timer.hpp>
+#include <strawman_metrics.hpp>
+#include <strawman_action_plan.hpp>
+#include <strawman_triggers.hpp>
 
 #include <conduit.hpp>
 #include <conduit_blueprint.hpp>
@@ -85,13 +88,32 @@ public:
 
     void   Open(); // open with default options
     void   Open(const conduit::Node &options);
+    // the published arrays are referenced, not copied. they must stay
+    // valid and unchanged until the following Execute returns.
     void   Publish(const conduit::Node &data);
     void   Execute(const conduit::Node &actions);
+    // status of the active pipeline (for example pending async saves)
+    void   Info(conduit::Node &info);
     void   Close();
 
 private:
     
-    Pipeline *m_pipeline;
+    Pipeline    *m_pipeline;
+    // written at Close() when the timers/trace option is set
+    std::string  m_trace_file;
+    // per Execute snapshots, enabled by the metrics option
+    Metrics      m_metrics;
+    // state/cycle and state/time of the last published data
+    conduit::int64 m_cycle;
+    double       m_time;
+    // references the arrays of the last published data. when the 
+    // actions have triggers, it is only handed to the pipeline on 
+    // cycles they fire.
+    conduit::Node m_published;
+    bool         m_publish_pending;
+    Triggers     m_triggers;
+    // strawman_actions.json, parsed again only when it changes
+    ActionsFile  m_actions_file;
 };
 
 
@@ -69,6 +69,30 @@ Pipeline::~Pipeline()
 
 }
 
+//-----------------------------------------------------------------------------
+void
+Pipeline::Execute(const conduit::Node &actions,
+                  const std::vector<bool> &run)
+{
+    conduit::Node run_actions;
+    for(conduit::index_t i = 0; i < actions.number_of_children(); ++i)
+    {
+        if(run.empty() || run[i])
+        {
+            conduit::Node &action = const_cast<conduit::Node&>(actions.child(i));
+            run_actions.append().set_external(action);
+        }
+    }
+    Execute(run_actions);
+}
+
+//-----------------------------------------------------------------------------
+void
+Pipeline::Info(conduit::Node &)
+{
+
+}
+
 //-----------------------------------------------------------------------------
 };
 //-----------------------------------------------------------------------------
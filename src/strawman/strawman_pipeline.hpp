@@ -54,6 +54,8 @@
 
 #include <strawman.hpp>
 
+#include <vector>
+
 //-----------------------------------------------------------------------------
 // -- begin strawman:: --
 //-----------------------------------------------------------------------------
@@ -72,8 +74,16 @@ public:
 
     virtual void  Publish(const conduit::Node &data)=0;
     virtual void  Execute(const conduit::Node &actions)=0;
+    // runs only the actions whose entry in run is true, one entry per 
+    // action. the default executes a list of those actions, pipelines 
+    // that compile their actions override it to keep one plan for all.
+    virtual void  Execute(const conduit::Node &actions,
+                          const std::vector<bool> &run);
     
     virtual void  Cleanup()=0;
+
+    // optional pipeline specific status, the default adds nothing
+    virtual void  Info(conduit::Node &info);
 };
 
 //-----------------------------------------------------------------------------
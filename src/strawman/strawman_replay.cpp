@@ -0,0 +1,400 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_replay.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include <strawman_replay.hpp>
+#include <strawman_lossy_codec.hpp>
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <conduit_relay.hpp>
+#include <conduit_relay_hdf5.hpp>
+
+#ifdef PARALLEL
+#include <mpi.h>
+#endif
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+//-----------------------------------------------------------------------------
+double
+elapsed_seconds(const timeval &start)
+{
+    timeval end;
+    gettimeofday(&end, NULL);
+    return (double)(end.tv_sec - start.tv_sec) + 
+           (double)(end.tv_usec - start.tv_usec) / 1000000.0;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+Replay::Replay()
+: m_rank(0),
+  m_size(1),
+  m_mpi_comm(-1)
+{
+}
+
+//-----------------------------------------------------------------------------
+Replay::~Replay()
+{
+}
+
+//-----------------------------------------------------------------------------
+const Node &
+Replay::Timings() const
+{
+    return m_timings;
+}
+
+//-----------------------------------------------------------------------------
+double
+Replay::ReduceMax(double value)
+{
+#ifdef PARALLEL
+    double res = value;
+    MPI_Allreduce(&value, &res, 1, MPI_DOUBLE, MPI_MAX, 
+                  MPI_Comm_f2c(m_mpi_comm));
+    return res;
+#else
+    return value;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+bool
+Replay::AllRanksOk(bool ok)
+{
+#ifdef PARALLEL
+    int local_ok = ok ? 1 : 0;
+    int all_ok   = 0;
+    MPI_Allreduce(&local_ok, &all_ok, 1, MPI_INT, MPI_MIN, 
+                  MPI_Comm_f2c(m_mpi_comm));
+    return all_ok == 1;
+#else
+    return ok;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// read errors are only logged where they happen, then every rank throws
+// together, so no rank is left waiting in a collective
+//-----------------------------------------------------------------------------
+void
+Replay::LoadDomain(const std::string &root_file, Node &data)
+{
+    // rank 0 reads the root file, the other ranks only need its layout
+    std::string layout_json;
+    int root_ok = 1;
+    if(m_rank == 0)
+    {
+        try
+        {
+            Node root;
+            relay::io::load(root_file, "hdf5", root);
+
+            Node layout;
+            layout["protocol"]        = root["protocol/name"].as_string();
+            layout["number_of_files"] = root["number_of_files"].to_int();
+            layout["number_of_trees"] = root["number_of_trees"].to_int();
+            layout["file_pattern"]    = root["file_pattern"].as_string();
+            layout["tree_pattern"]    = root["tree_pattern"].as_string();
+            layout_json = layout.to_json();
+        }
+        catch(conduit::Error &e)
+        {
+            STRAWMAN_INFO("Failed to read " << root_file 
+                          << ": " << e.message());
+            root_ok = 0;
+        }
+        catch(std::exception &e)
+        {
+            STRAWMAN_INFO("Failed to read " << root_file 
+                          << ": " << e.what());
+            root_ok = 0;
+        }
+    }
+
+#ifdef PARALLEL
+    MPI_Comm comm = MPI_Comm_f2c(m_mpi_comm);
+    MPI_Bcast(&root_ok, 1, MPI_INT, 0, comm);
+#endif
+
+    if(root_ok != 1)
+    {
+        STRAWMAN_ERROR("Error: failed to read root file " << root_file);
+    }
+
+#ifdef PARALLEL
+    int json_size = (int) layout_json.size();
+    MPI_Bcast(&json_size, 1, MPI_INT, 0, comm);
+    layout_json.resize(json_size);
+    MPI_Bcast(&layout_json[0], json_size, MPI_CHAR, 0, comm);
+#endif
+
+    Node layout;
+    Generator(layout_json, "json").walk(layout);
+
+    int num_files = layout["number_of_files"].to_int();
+    int num_trees = layout["number_of_trees"].to_int();
+
+    if(num_trees != m_size)
+    {
+        STRAWMAN_ERROR("Replay of " << root_file << " needs one rank per"
+                       " domain (" << num_trees << " domains, "
+                       << m_size << " ranks)");
+    }
+
+    // the patterns are relative to the directory of the root file
+    std::string root_name, root_dir;
+    conduit::utils::rsplit_string(root_file, "/", root_name, root_dir);
+
+    int domain  = m_rank;
+    int file_id = (int) (((long) domain * num_files) / num_trees);
+
+    char buff[1024];
+    snprintf(buff, sizeof(buff), 
+             layout["file_pattern"].as_string().c_str(),
+             file_id);
+    std::string file_path = buff;
+    if(!root_dir.empty())
+    {
+        file_path = conduit::utils::join_file_path(root_dir, file_path);
+    }
+
+    data.reset();
+    m_raw_file.Close();
+
+    bool load_ok = true;
+    try
+    {
+        std::string tree_pattern = layout["tree_pattern"].as_string();
+        if(layout["protocol"].as_string() == "strawman_raw")
+        {
+            // zero copy, data points into the mapping
+            m_raw_file.Open(file_path);
+            data.set_external(m_raw_file.Data());
+        }
+        else if(tree_pattern == "/")
+        {
+            relay::io::load(file_path, "hdf5", data);
+        }
+        else
+        {
+            snprintf(buff, sizeof(buff), tree_pattern.c_str(), domain);
+            relay::io::hdf5_read(file_path, std::string(buff), data);
+        }
+
+        // fields saved with compression/lossy
+        lossy_decode_fields(data);
+    }
+    catch(conduit::Error &e)
+    {
+        STRAWMAN_INFO("Failed to load domain " << domain 
+                      << " from " << file_path << ": " << e.message());
+        load_ok = false;
+    }
+    catch(std::exception &e)
+    {
+        STRAWMAN_INFO("Failed to load domain " << domain 
+                      << " from " << file_path << ": " << e.what());
+        load_ok = false;
+    }
+
+    if(!AllRanksOk(load_ok))
+    {
+        STRAWMAN_ERROR("Error: failed to load the domains of " << root_file);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+Replay::Run(const Node &options)
+{
+    m_timings.reset();
+
+    Node sman_opts;
+    if(options.has_child("strawman_options"))
+    {
+        sman_opts.set(options["strawman_options"]);
+    }
+
+#ifdef PARALLEL
+    if(!options.has_child("mpi_comm"))
+    {
+        STRAWMAN_ERROR("Replay needs an mpi_comm option");
+    }
+    m_mpi_comm = options["mpi_comm"].to_int();
+    MPI_Comm comm = MPI_Comm_f2c(m_mpi_comm);
+    MPI_Comm_rank(comm, &m_rank);
+    MPI_Comm_size(comm, &m_size);
+
+    if(!sman_opts.has_child("mpi_comm"))
+    {
+        sman_opts["mpi_comm"] = m_mpi_comm;
+    }
+#endif
+
+    Node actions;
+    if(options.has_child("actions"))
+    {
+        actions.set(options["actions"]);
+    }
+
+    int iterations = 1;
+    if(options.has_child("iterations"))
+    {
+        iterations = options["iterations"].to_int();
+    }
+
+    std::vector<std::string> root_files;
+    if(options.has_child("root_files"))
+    {
+        const Node &n_files = options["root_files"];
+        if(n_files.dtype().is_string())
+        {
+            root_files.push_back(n_files.as_string());
+        }
+        else
+        {
+            NodeConstIterator itr = n_files.children();
+            while(itr.has_next())
+            {
+                root_files.push_back(itr.next().as_string());
+            }
+        }
+    }
+
+    if(root_files.empty())
+    {
+        STRAWMAN_ERROR("Replay needs at least one root file");
+    }
+
+    // the pipeline may hold on to the published data until it is closed
+    Node data;
+    Strawman sman;
+
+    timeval start;
+    gettimeofday(&start, NULL);
+    sman.Open(sman_opts);
+    m_timings["open"] = ReduceMax(elapsed_seconds(start));
+
+    double total_load    = 0.0;
+    double total_publish = 0.0;
+    double total_execute = 0.0;
+
+    for(int it = 0; it < iterations; ++it)
+    {
+        for(size_t i = 0; i < root_files.size(); ++i)
+        {
+            Node &cycle = m_timings["cycles"].append();
+            cycle["root_file"] = root_files[i];
+
+            gettimeofday(&start, NULL);
+            LoadDomain(root_files[i], data);
+            double load = ReduceMax(elapsed_seconds(start));
+
+            gettimeofday(&start, NULL);
+            sman.Publish(data);
+            double publish = ReduceMax(elapsed_seconds(start));
+
+            gettimeofday(&start, NULL);
+            sman.Execute(actions);
+            double execute = ReduceMax(elapsed_seconds(start));
+
+            cycle["load"]    = load;
+            cycle["publish"] = publish;
+            cycle["execute"] = execute;
+
+            total_load    += load;
+            total_publish += publish;
+            total_execute += execute;
+
+            if(m_rank == 0)
+            {
+                STRAWMAN_INFO("Replayed " << root_files[i] 
+                              << " load: "    << load 
+                              << " publish: " << publish
+                              << " execute: " << execute);
+            }
+        }
+    }
+
+    gettimeofday(&start, NULL);
+    sman.Close();
+    m_raw_file.Close();
+    m_timings["close"] = ReduceMax(elapsed_seconds(start));
+
+    m_timings["total/load"]    = total_load;
+    m_timings["total/publish"] = total_publish;
+    m_timings["total/execute"] = total_execute;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
@@ -0,0 +1,126 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_replay.hpp
+///
+//-----------------------------------------------------------------------------
+
+#ifndef STRAWMAN_REPLAY_HPP
+#define STRAWMAN_REPLAY_HPP
+
+#include <strawman.hpp>
+#include <strawman_raw_file.hpp>
+
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+/// Replays a series of cycles saved by the blueprint_hdf5 pipeline through 
+/// any pipeline, for benchmarking and tuning without the simulation.
+///
+/// Options:
+///   root_files:       list of the .root files of the saved cycles, 
+///                     replayed in order
+///   strawman_options: options passed to Strawman::Open
+///   actions:          actions executed for every cycle
+///   iterations:       how many times to replay the series (default: 1)
+///   mpi_comm:         (MPI builds) fortran handle of the communicator
+///
+/// Each rank loads one domain of each cycle. The pipelines take one 
+/// domain per rank, so MPI runs need as many ranks as there are domains.
+/// Cycles saved with the raw protocol are memory mapped instead of read,
+/// so their load time is mostly independent of their size.
+/// Fields saved with lossy compression are decoded after loading.
+/// A file that can't be read on any rank makes Run() throw on all ranks.
+///
+/// Timings (seconds, max over ranks):
+///   open, close
+///   cycles/<i>/{root_file, load, publish, execute}
+///   total/{load, publish, execute}
+//-----------------------------------------------------------------------------
+class STRAWMAN_API Replay
+{
+public:
+           Replay();
+          ~Replay();
+
+    void   Run(const conduit::Node &options);
+
+    const conduit::Node &Timings() const;
+
+private:
+    // loads our domain of the cycle described by root_file
+    void   LoadDomain(const std::string &root_file, conduit::Node &data);
+    // max of the value over all ranks
+    double ReduceMax(double value);
+    // true if ok is true on all ranks
+    bool   AllRanksOk(bool ok);
+
+    int             m_rank;
+    int             m_size;
+    // fortran handle of the communicator, -1 for serial
+    int             m_mpi_comm;
+    conduit::Node   m_timings;
+    // the mapped file of the current cycle, for raw saves
+    RawFile         m_raw_file;
+};
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
+
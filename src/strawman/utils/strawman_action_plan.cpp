@@ -0,0 +1,474 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_action_plan.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_action_plan.hpp"
+
+#include "strawman_hash.hpp"
+#include "strawman_logging.hpp"
+
+// standard includes
+#include <stdio.h>
+// unix only
+#include <sys/stat.h>
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+const int DEFAULT_IMAGE_SIZE = 1024;
+
+//-----------------------------------------------------------------------------
+// the field to topology mapping a plan resolved its plots with
+//-----------------------------------------------------------------------------
+uint64
+fields_hash(const Node &data)
+{
+    uint64 hash = FNV_OFFSET_BASIS;
+    if(!data.has_child("fields"))
+    {
+        return hash;
+    }
+
+    NodeConstIterator itr = data["fields"].children();
+    while(itr.has_next())
+    {
+        const Node &field = itr.next();
+        hash_string(itr.name(), hash);
+        if(field.has_child("topology"))
+        {
+            hash_string(field["topology"].as_string(), hash);
+        }
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+struct ActionName
+{
+    const char             *m_name;
+    ActionPlan::ActionType  m_type;
+};
+
+const ActionName ACTION_NAMES[] = 
+{
+    {"add_plot",       ActionPlan::ADD_PLOT},
+    {"add_filter",     ActionPlan::ADD_FILTER},
+    {"draw_plots",     ActionPlan::DRAW_PLOTS},
+    {"save",           ActionPlan::SAVE},
+    {"wait_for_saves", ActionPlan::WAIT_FOR_SAVES}
+};
+
+const int NUM_ACTION_NAMES = sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]);
+
+//-----------------------------------------------------------------------------
+ActionPlan::ActionType
+action_type(const std::string &name)
+{
+    for(int i = 0; i < NUM_ACTION_NAMES; ++i)
+    {
+        if(name == ACTION_NAMES[i].m_name)
+        {
+            return ACTION_NAMES[i].m_type;
+        }
+    }
+    return ActionPlan::UNKNOWN;
+}
+
+//-----------------------------------------------------------------------------
+bool
+read_file(const std::string &file_name, std::string &contents)
+{
+    FILE *file = fopen(file_name.c_str(), "rb");
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    contents.clear();
+    char buffer[4096];
+    size_t num_read = 0;
+    while((num_read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        contents.append(buffer, num_read);
+    }
+
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+ActionPlan::ActionPlan()
+: m_compiled(false),
+  m_actions_hash(0),
+  m_fields_hash(0),
+  m_compiles(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+ActionPlan::~ActionPlan()
+{
+}
+
+//-----------------------------------------------------------------------------
+bool
+ActionPlan::Update(const Node &actions,
+                   const Node &data)
+{
+    uint64 actions_hash = Hash(actions);
+    uint64 data_hash    = fields_hash(data);
+
+    if(m_compiled && 
+       actions_hash == m_actions_hash && 
+       data_hash == m_fields_hash)
+    {
+        return false;
+    }
+
+    // stays uncompiled if the actions don't validate
+    m_compiled = false;
+    m_actions.reset();
+    m_actions.set(actions);
+    Compile(data);
+
+    m_actions_hash = actions_hash;
+    m_fields_hash  = data_hash;
+    m_compiled     = true;
+    m_compiles++;
+
+    STRAWMAN_INFO("Compiled " << m_steps.size() << " actions");
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+ActionPlan::Reset()
+{
+    m_compiled = false;
+}
+
+//-----------------------------------------------------------------------------
+size_t
+ActionPlan::NumSteps() const
+{
+    return m_steps.size();
+}
+
+//-----------------------------------------------------------------------------
+const ActionPlan::Step &
+ActionPlan::GetStep(size_t index) const
+{
+    return m_steps[index];
+}
+
+//-----------------------------------------------------------------------------
+int
+ActionPlan::Compiles() const
+{
+    return m_compiles;
+}
+
+//-----------------------------------------------------------------------------
+bool
+ActionPlan::Runs(const Step &step, const std::vector<bool> &run)
+{
+    return run.empty() || run[step.m_action_index];
+}
+
+//-----------------------------------------------------------------------------
+uint64
+ActionPlan::Hash(const Node &node)
+{
+    uint64 hash = FNV_OFFSET_BASIS;
+    hash_node(node, hash);
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+void
+ActionPlan::Compile(const Node &data)
+{
+    m_steps.clear();
+
+    for(index_t i = 0; i < m_actions.number_of_children(); ++i)
+    {
+        const Node &action = m_actions.child(i);
+        if(!action.has_child("action"))
+        {
+            STRAWMAN_INFO("Warning : action " << i << " malformed, skipped");
+            continue;
+        }
+
+        Step step;
+        step.m_name   = action["action"].as_string();
+        step.m_type   = action_type(step.m_name);
+        step.m_action = &action;
+        step.m_action_index = (size_t) i;
+
+        // unknown actions are left to the pipeline to report
+        if(step.m_type == ADD_PLOT)
+        {
+            if(!action.has_child("field_name"))
+            {
+                STRAWMAN_ERROR("add_plot action missing field_name");
+            }
+            step.m_field_name = action["field_name"].as_string();
+
+            // nothing to resolve against before the first Publish
+            if(data.has_child("fields"))
+            {
+                const Node &fields = data["fields"];
+                if(!fields.has_child(step.m_field_name))
+                {
+                    STRAWMAN_ERROR("add_plot: no field named \""
+                                   << step.m_field_name << "\"");
+                }
+
+                const Node &field = fields[step.m_field_name];
+                if(field.has_child("topology"))
+                {
+                    step.m_topology = field["topology"].as_string();
+                }
+            }
+        }
+
+        CompileRenderOptions(action, step.m_render);
+        m_steps.push_back(step);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+ActionPlan::CompileRenderOptions(const Node &action,
+                                 RenderOptions &render)
+{
+    render.m_width    = DEFAULT_IMAGE_SIZE;
+    render.m_height   = DEFAULT_IMAGE_SIZE;
+    render.m_renderer = RENDERER_DEFAULT;
+
+    if(!action.has_child("render_options"))
+    {
+        return;
+    }
+
+    const Node &options = action["render_options"];
+
+    if(options.has_child("width"))
+    {
+        render.m_width = options["width"].to_int();
+    }
+
+    if(options.has_child("height"))
+    {
+        render.m_height = options["height"].to_int();
+    }
+
+    if(render.m_width < 1 || render.m_height < 1)
+    {
+        STRAWMAN_ERROR("render_options: invalid image size " 
+                       << render.m_width << " x " << render.m_height);
+    }
+
+    if(options.has_child("renderer"))
+    {
+        std::string renderer = options["renderer"].as_string();
+        if(renderer == "opengl")
+        {
+            render.m_renderer = RENDERER_OPENGL;
+        }
+        else if(renderer == "raytracer")
+        {
+            render.m_renderer = RENDERER_RAYTRACER;
+        }
+        else if(renderer == "volume")
+        {
+            render.m_renderer = RENDERER_VOLUME;
+        }
+        else
+        {
+            STRAWMAN_INFO("Unknown renderer " << renderer 
+                          << ", using the pipeline's default");
+        }
+    }
+
+    if(options.has_child("file_name"))
+    {
+        render.m_file_name = options["file_name"].as_string();
+    }
+
+    if(options.has_child("camera"))
+    {
+        render.m_camera.set(options["camera"]);
+    }
+
+    if(options.has_child("color_map"))
+    {
+        render.m_color_map.set(options["color_map"]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+ActionsFile::ActionsFile(const std::string &file_name)
+: m_file_name(file_name),
+  m_loaded(false),
+  m_loaded_at(0),
+  m_mtime(0),
+  m_size(0),
+  m_contents_hash(0),
+  m_merged(false),
+  m_actions_hash(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+ActionsFile::~ActionsFile()
+{
+}
+
+//-----------------------------------------------------------------------------
+const Node &
+ActionsFile::Merge(const Node &actions)
+{
+    struct stat file_stat;
+    if(stat(m_file_name.c_str(), &file_stat) != 0)
+    {
+        if(m_loaded)
+        {
+            m_loaded = false;
+            m_merged = false;
+            m_file_actions.reset();
+            m_merged_actions.reset();
+        }
+        return actions;
+    }
+
+    bool changed = false;
+    // a write in the second we loaded it in may not change the mtime
+    if(!m_loaded ||
+       file_stat.st_mtime != m_mtime ||
+       (int64) file_stat.st_size != m_size ||
+       file_stat.st_mtime >= m_loaded_at)
+    {
+        changed = Load(file_stat.st_mtime, (int64) file_stat.st_size);
+    }
+
+    if(!m_loaded)
+    {
+        return actions;
+    }
+
+    uint64 actions_hash = ActionPlan::Hash(actions);
+    if(changed || !m_merged || actions_hash != m_actions_hash)
+    {
+        m_merged_actions.reset();
+        m_merged_actions.set(actions);
+        m_merged_actions.update(m_file_actions);
+        m_actions_hash = actions_hash;
+        m_merged = true;
+    }
+
+    return m_merged_actions;
+}
+
+//-----------------------------------------------------------------------------
+bool
+ActionsFile::Load(time_t mtime, int64 size)
+{
+    std::string contents;
+    if(!read_file(m_file_name, contents))
+    {
+        STRAWMAN_INFO("Cannot read \"" << m_file_name << "\"");
+        return false;
+    }
+
+    uint64 hash = FNV_OFFSET_BASIS;
+    hash_bytes(contents.c_str(), contents.size(), hash);
+
+    bool changed = !m_loaded || hash != m_contents_hash;
+    if(changed)
+    {
+        Node file_actions;
+        Generator generator(contents, "json");
+        generator.walk(file_actions);
+
+        m_file_actions.reset();
+        m_file_actions.set(file_actions);
+        m_contents_hash = hash;
+        m_loaded = true;
+    }
+
+    m_mtime     = mtime;
+    m_size      = size;
+    m_loaded_at = time(NULL);
+    return changed;
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
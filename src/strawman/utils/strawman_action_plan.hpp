@@ -0,0 +1,206 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_action_plan.hpp
+///
+//-----------------------------------------------------------------------------
+#ifndef STRAWMAN_ACTION_PLAN_HPP
+#define STRAWMAN_ACTION_PLAN_HPP
+
+#include <conduit.hpp>
+#include <time.h>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+/// The actions passed to Execute compiled into typed steps. A simulation
+/// usually passes the same actions every cycle, so a pipeline keeps its
+/// plan and only compiles it again when the actions change or the 
+/// published fields point at other topologies. Until then each Execute 
+/// costs a hash of the actions instead of string compares and lookups of 
+/// the render options.
+//-----------------------------------------------------------------------------
+class ActionPlan
+{
+public:
+    enum ActionType
+    {
+        ADD_PLOT,
+        ADD_FILTER,
+        DRAW_PLOTS,
+        SAVE,
+        WAIT_FOR_SAVES,
+        UNKNOWN
+    };
+
+    enum RendererType
+    {
+        // whatever the pipeline renders with when none is given
+        RENDERER_DEFAULT,
+        RENDERER_OPENGL,
+        RENDERER_RAYTRACER,
+        RENDERER_VOLUME
+    };
+
+    struct RenderOptions
+    {
+        int                  m_width;
+        int                  m_height;
+        RendererType         m_renderer;
+        // empty when the image is streamed instead of saved
+        std::string          m_file_name;
+        // empty nodes when not given. copies, so a plot can keep its
+        // options when the plan is compiled again.
+        conduit::Node        m_camera;
+        conduit::Node        m_color_map;
+    };
+
+    struct Step
+    {
+        ActionType           m_type;
+        std::string          m_name;
+        // the action in the plan's copy of the actions, valid until the
+        // next Update()
+        const conduit::Node *m_action;
+        // index of the action in the actions passed to Update
+        size_t               m_action_index;
+        // add_plot only
+        std::string          m_field_name;
+        std::string          m_topology;
+        RenderOptions        m_render;
+    };
+
+    ActionPlan();
+    ~ActionPlan();
+
+    // compiles the actions if they, or the topologies of the fields in 
+    // data, changed since the last call. returns true if it compiled.
+    bool         Update(const conduit::Node &actions,
+                        const conduit::Node &data);
+    // the next Update compiles
+    void         Reset();
+
+    size_t       NumSteps() const;
+    const Step  &GetStep(size_t index) const;
+    // how often the plan was compiled
+    int          Compiles() const;
+
+    // true if the step runs. run has one entry per action, an empty run
+    // runs every step.
+    static bool  Runs(const Step &step, const std::vector<bool> &run);
+
+    // hash of the names and values of a tree
+    static conduit::uint64 Hash(const conduit::Node &node);
+
+private:
+    ActionPlan(const ActionPlan &);
+    ActionPlan &operator=(const ActionPlan &);
+
+    void         Compile(const conduit::Node &data);
+    void         CompileRenderOptions(const conduit::Node &action,
+                                      RenderOptions &render);
+
+    conduit::Node      m_actions;
+    std::vector<Step>  m_steps;
+    bool               m_compiled;
+    conduit::uint64    m_actions_hash;
+    conduit::uint64    m_fields_hash;
+    int                m_compiles;
+};
+
+//-----------------------------------------------------------------------------
+/// strawman_actions.json, merged over the actions passed to Execute. The
+/// file is only parsed again when its modification time or size changes,
+/// or when it was written so recently that an edit in the same second 
+/// would not change either, in which case its contents are hashed. The
+/// merge is redone when the file or the passed actions change.
+//-----------------------------------------------------------------------------
+class ActionsFile
+{
+public:
+    ActionsFile(const std::string &file_name);
+    ~ActionsFile();
+
+    // actions if the file doesn't exist, else the cached merge
+    const conduit::Node &Merge(const conduit::Node &actions);
+
+private:
+    ActionsFile(const ActionsFile &);
+    ActionsFile &operator=(const ActionsFile &);
+
+    // true if the file's contents changed since the last load
+    bool          Load(time_t mtime, conduit::int64 size);
+
+    std::string        m_file_name;
+    bool               m_loaded;
+    time_t             m_loaded_at;
+    time_t             m_mtime;
+    conduit::int64     m_size;
+    conduit::uint64    m_contents_hash;
+    conduit::Node      m_file_actions;
+
+    bool               m_merged;
+    conduit::uint64    m_actions_hash;
+    conduit::Node      m_merged_actions;
+};
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
+
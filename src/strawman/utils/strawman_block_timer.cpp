@@ -49,7 +49,11 @@
 //-----------------------------------------------------------------------------
 
 #include "strawman_block_timer.hpp"
+#include "strawman_logging.hpp"
+#include "strawman_memory_tracker.hpp"
+#include "strawman_mutex_lock.hpp"
 #include <climits>
+#include <float.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -59,21 +63,19 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
 #include <set>
 #include <map>
 #include <fstream>
-#ifdef STRAWMAN_PLATFORM_UNIX
-#include <sys/sysinfo.h>
-#endif
+#include <sstream>
 
 
 
 using namespace conduit;
 
 #ifdef PARALLEL
-#include "conduit_relay_mpi.hpp"
 #include <mpi.h>
-using namespace conduit::relay::mpi;
 #endif
 
 
@@ -84,162 +86,613 @@ using namespace conduit::relay::mpi;
 namespace strawman
 {
 
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// stats of one scope's average time per call over the ranks. all doubles,
+// so an array of them reduces as one mpi type.
+//-----------------------------------------------------------------------------
+struct ScopeStats
+{
+    double m_ranks;    // ranks that ran the scope
+    double m_calls;
+    double m_min;
+    double m_min_rank;
+    double m_max;
+    double m_max_rank;
+    double m_sum;
+    double m_sum_sq;
+    double m_mem_peak;
+    // sums over the ranks of the average growth per call
+    double m_mem_delta;
+    double m_tracked_delta;
+    // sums over the ranks of the average count per call, and the ranks
+    // that could count
+    double m_counters[PerfCounters::NUM_COUNTERS];
+    double m_counter_ranks[PerfCounters::NUM_COUNTERS];
+    // the most threads and the worst thread imbalance of the ranks
+    double m_threads;
+    double m_imbalance;
+};
+
+//-----------------------------------------------------------------------------
+void
+init_stats(ScopeStats &stats)
+{
+    memset(&stats, 0, sizeof(ScopeStats));
+    stats.m_min      =  DBL_MAX;
+    stats.m_min_rank = -1;
+    stats.m_max      = -DBL_MAX;
+    stats.m_max_rank = -1;
+}
+
+//-----------------------------------------------------------------------------
+int64
+to_nanoseconds(const timespec &time)
+{
+    return (int64) time.tv_sec * 1000000000 + (int64) time.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------
+int
+current_thread_id()
+{
+    static __thread int thread_id = 0;
+    if(thread_id == 0)
+    {
+        thread_id = (int) syscall(SYS_gettid);
+    }
+    return thread_id;
+}
+
+//-----------------------------------------------------------------------------
+// FNV-1a, for the name table
+//-----------------------------------------------------------------------------
+unsigned int
+hash_name(const char *name)
+{
+    unsigned int hash = 2166136261u;
+    for(const char *c = name; *c != '\0'; ++c)
+    {
+        hash ^= (unsigned char) *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+// serializes adding names, lookups don't take it
+pthread_mutex_t names_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//-----------------------------------------------------------------------------
+// scope "A/B" lives at children/A/children/B of the timer tree
+//-----------------------------------------------------------------------------
+std::string
+scope_tree_path(const std::string &path)
+{
+    std::string res = "children/";
+    for(size_t i = 0; i < path.size(); ++i)
+    {
+        if(path[i] == '/')
+        {
+            res += "/children/";
+        }
+        else
+        {
+            res += path[i];
+        }
+    }
+    return res;
+}
+
+#ifdef PARALLEL
+//-----------------------------------------------------------------------------
+// ties go to the lower rank, so the result doesn't depend on the order
+// in which ranks are merged
+//-----------------------------------------------------------------------------
+void
+merge_stats(const ScopeStats &in, ScopeStats &inout)
+{
+    if(in.m_ranks == 0)
+    {
+        return;
+    }
+
+    if(in.m_min < inout.m_min ||
+       (in.m_min == inout.m_min && in.m_min_rank < inout.m_min_rank))
+    {
+        inout.m_min      = in.m_min;
+        inout.m_min_rank = in.m_min_rank;
+    }
+
+    if(in.m_max > inout.m_max ||
+       (in.m_max == inout.m_max && in.m_max_rank < inout.m_max_rank))
+    {
+        inout.m_max      = in.m_max;
+        inout.m_max_rank = in.m_max_rank;
+    }
+
+    inout.m_ranks   += in.m_ranks;
+    inout.m_calls   += in.m_calls;
+    inout.m_sum     += in.m_sum;
+    inout.m_sum_sq  += in.m_sum_sq;
+    inout.m_mem_peak = in.m_mem_peak > inout.m_mem_peak ? in.m_mem_peak 
+                                                        : inout.m_mem_peak;
+    inout.m_mem_delta     += in.m_mem_delta;
+    inout.m_tracked_delta += in.m_tracked_delta;
+    for(int i = 0; i < PerfCounters::NUM_COUNTERS; ++i)
+    {
+        inout.m_counters[i]      += in.m_counters[i];
+        inout.m_counter_ranks[i] += in.m_counter_ranks[i];
+    }
+    inout.m_threads   = in.m_threads   > inout.m_threads   ? in.m_threads
+                                                           : inout.m_threads;
+    inout.m_imbalance = in.m_imbalance > inout.m_imbalance ? in.m_imbalance
+                                                           : inout.m_imbalance;
+}
+
+//-----------------------------------------------------------------------------
+void
+reduce_scope_stats(void *in, void *inout, int *len, MPI_Datatype *)
+{
+    const ScopeStats *in_stats    = (const ScopeStats *) in;
+    ScopeStats       *inout_stats = (ScopeStats *) inout;
+    for(int i = 0; i < *len; ++i)
+    {
+        merge_stats(in_stats[i], inout_stats[i]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+std::string
+join_paths(const std::set<std::string> &paths)
+{
+    std::string res;
+    std::set<std::string>::const_iterator itr;
+    for(itr = paths.begin(); itr != paths.end(); ++itr)
+    {
+        res += *itr;
+        res += "\n";
+    }
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+void
+split_paths(const std::string &joined, std::set<std::string> &paths)
+{
+    size_t start = 0;
+    size_t end   = joined.find('\n');
+    while(end != std::string::npos)
+    {
+        paths.insert(joined.substr(start, end - start));
+        start = end + 1;
+        end   = joined.find('\n', start);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// leaves the union of the scope paths of all ranks on every rank. the
+// union is merged up a binomial tree to rank 0 and broadcast back, so 
+// no rank handles more than log(P) messages.
+//-----------------------------------------------------------------------------
+void
+merge_paths(std::set<std::string> &paths, MPI_Comm comm)
+{
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    for(int mask = 1; mask < size; mask <<= 1)
+    {
+        if(rank & mask)
+        {
+            std::string joined = join_paths(paths);
+            int num_bytes = (int) joined.size();
+            MPI_Send(&num_bytes, 1, MPI_INT, rank - mask, 0, comm);
+            MPI_Send(&joined[0], num_bytes, MPI_CHAR, rank - mask, 1, comm);
+            break;
+        }
+        else if(rank + mask < size)
+        {
+            int num_bytes = 0;
+            MPI_Recv(&num_bytes, 1, MPI_INT, rank + mask, 0, comm, 
+                     MPI_STATUS_IGNORE);
+            std::string joined(num_bytes, '\0');
+            MPI_Recv(&joined[0], num_bytes, MPI_CHAR, rank + mask, 1, comm,
+                     MPI_STATUS_IGNORE);
+            split_paths(joined, paths);
+        }
+    }
+
+    std::string joined;
+    if(rank == 0)
+    {
+        joined = join_paths(paths);
+    }
+    int num_bytes = (int) joined.size();
+    MPI_Bcast(&num_bytes, 1, MPI_INT, 0, comm);
+    joined.resize(num_bytes);
+    MPI_Bcast(&joined[0], num_bytes, MPI_CHAR, 0, comm);
+
+    paths.clear();
+    split_paths(joined, paths);
+}
+#endif
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
 // Initialize BlockTimer static data members.
-int                             BlockTimer::s_global_depth = 0;
 conduit::Node                   BlockTimer::s_global_root;
-std::string                     BlockTimer::s_current_path = "";
-std::map<std::string, timeval>  BlockTimer::s_timers;
-std::set<std::string>           BlockTimer::s_visited;
+const char                     *BlockTimer::s_names[BlockTimer::MAX_NAMES];
+int                             BlockTimer::s_num_names = 0;
+int                             BlockTimer::s_name_slots[BlockTimer::NAME_SLOTS];
+BlockTimer::ThreadTimers * volatile BlockTimer::s_threads = NULL;
+BlockTimer::TraceEvent         *BlockTimer::s_trace = NULL;
+unsigned long                   BlockTimer::s_trace_capacity = 0;
+volatile unsigned long          BlockTimer::s_trace_next = 0;
 int                             BlockTimer::s_rank = 0;
 
 //-----------------------------------------------------------------------------
 BlockTimer::BlockTimer(std::string const &name)
-: m_name(name)
+: m_name_id(InternName(name.c_str()))
+{
+  Start(m_name_id);
+}
+
+//-----------------------------------------------------------------------------
+BlockTimer::BlockTimer(int name_id)
+: m_name_id(name_id)
+{
+  Start(m_name_id);
+}
+
+//-----------------------------------------------------------------------------
+int
+BlockTimer::FindName(const char *name, unsigned int hash)
+{
+    for(unsigned int i = hash % NAME_SLOTS; ; i = (i + 1) % NAME_SLOTS)
+    {
+        // slots are published after their names, so a slot we see 
+        // leads to a complete name
+        int slot = __atomic_load_n(&s_name_slots[i], __ATOMIC_ACQUIRE);
+        if(slot == 0)
+        {
+            return -1;
+        }
+
+        if(strcmp(s_names[slot - 1], name) == 0)
+        {
+            return slot - 1;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+const char *
+BlockTimer::Name(int name_id)
+{
+    if(name_id < 0 || 
+       name_id >= __atomic_load_n(&s_num_names, __ATOMIC_ACQUIRE))
+    {
+        return "";
+    }
+    return s_names[name_id];
+}
+
+//-----------------------------------------------------------------------------
+int
+BlockTimer::InternName(const char *name)
 {
-  Start(name);
+    unsigned int hash = hash_name(name);
+    int id = FindName(name, hash);
+    if(id >= 0)
+    {
+        return id;
+    }
+
+    MutexLock lock(names_mutex);
+
+    // another thread may have added it since we looked
+    id = FindName(name, hash);
+    if(id >= 0)
+    {
+        return id;
+    }
+
+    id = s_num_names;
+    if(id == MAX_NAMES)
+    {
+        STRAWMAN_INFO("BlockTimer: out of timer names, not timing " << name);
+        return -1;
+    }
+
+    unsigned int i = hash % NAME_SLOTS;
+    while(s_name_slots[i] != 0)
+    {
+        i = (i + 1) % NAME_SLOTS;
+    }
+
+    // names live as long as the process
+    s_names[id] = strdup(name);
+    __atomic_store_n(&s_num_names, id + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&s_name_slots[i], id + 1, __ATOMIC_RELEASE);
+    return id;
 }
 
 //-----------------------------------------------------------------------------
 void
 BlockTimer::StartTimer(const char *name)
 {
-  std::string s_name(name);
-  Start(s_name);
+  Start(InternName(name));
 }
 //-----------------------------------------------------------------------------
 void
 BlockTimer::StopTimer(const char *name)
 {
-  std::string s_name(name);
-  Stop(s_name);
+  Stop(InternName(name));
+}
+//-----------------------------------------------------------------------------
+void
+BlockTimer::StartTimer(int name_id)
+{
+  Start(name_id);
 }
+//-----------------------------------------------------------------------------
+void
+BlockTimer::StopTimer(int name_id)
+{
+  Stop(name_id);
+}
+//-----------------------------------------------------------------------------
+BlockTimer::ThreadTimers &
+BlockTimer::Thread()
+{
+    static __thread ThreadTimers *thread = NULL;
+    if(thread != NULL)
+    {
+        return *thread;
+    }
+
+    thread = new ThreadTimers;
+    memset(thread, 0, sizeof(ThreadTimers));
+    thread->m_thread_id = current_thread_id();
+
+    // most threads only see a few scopes
+    thread->m_chunks[0] = new Record[RECORD_CHUNK];
+    Record &root = thread->m_chunks[0][0];
+    memset(&root, 0, sizeof(Record));
+    root.m_name_id      = -1;
+    root.m_parent       = -1;
+    root.m_first_child  = -1;
+    root.m_next_sibling = -1;
+    thread->m_num_records = 1;
+
+    // push, guessing the list is empty until the swap tells us the head
+    thread->m_next = NULL;
+    ThreadTimers *head = __sync_val_compare_and_swap(&s_threads, 
+                                                     (ThreadTimers *) NULL,
+                                                     thread);
+    while(head != thread->m_next)
+    {
+        thread->m_next = head;
+        head = __sync_val_compare_and_swap(&s_threads, head, thread);
+    }
+
+    return *thread;
+}
+
 //-----------------------------------------------------------------------------
 int
-parseLine(char *line)
+BlockTimer::FindRecord(ThreadTimers &thread, int parent, int name_id)
 {
-    int i = strlen(line);
-    while (*line < '0' || *line > '9')
+    int child = GetRecord(thread, parent).m_first_child;
+    while(child >= 0)
+    {
+        const Record &record = GetRecord(thread, child);
+        if(record.m_name_id == name_id)
+        {
+            return child;
+        }
+        child = record.m_next_sibling;
+    }
+
+    if(thread.m_num_records == MAX_RECORDS)
     {
-        line++;
+        return -1;
     }
-    
-    line[i-3] = '\0';
-    i = atoi(line);
-    
-    return i;
+
+    child = thread.m_num_records++;
+    if(child % RECORD_CHUNK == 0)
+    {
+        thread.m_chunks[child / RECORD_CHUNK] = new Record[RECORD_CHUNK];
+    }
+
+    Record &record = GetRecord(thread, child);
+    memset(&record, 0, sizeof(Record));
+    record.m_name_id      = name_id;
+    record.m_parent       = parent;
+    record.m_first_child  = -1;
+    record.m_next_sibling = GetRecord(thread, parent).m_first_child;
+
+    // ScopeTotals() may be walking the tree from another thread, 
+    // it finds the new record only once it is complete
+    __atomic_store_n(&GetRecord(thread, parent).m_first_child, 
+                     child,
+                     __ATOMIC_RELEASE);
+    return child;
 }
 
 //-----------------------------------------------------------------------------
 void
-BlockTimer::Start(const std::string &name)
+BlockTimer::Start(int name_id)
 {
-#ifdef PARALLEL
-    MPI_Comm_rank(MPI_COMM_WORLD, &s_rank);
-    MPI_Barrier(MPI_COMM_WORLD);
-#else
-    s_rank = 0;
-#endif
-    
-    ++s_global_depth;
+    ThreadTimers &thread = Thread();
+    int depth = ++thread.m_depth;
+
+    if (depth <= MAX_CHECKED_DEPTH)
+    {
+        thread.m_name_stack[depth - 1] = name_id;
+    }
 
-    if (s_global_depth <= MAX_DEPTH)
+    if (depth <= MAX_DEPTH)
     {
-        s_current_path += "children/" + name + "/";
-        Precheck();
+        Frame &frame = thread.m_stack[depth - 1];
+        frame.m_name_id = name_id;
+        frame.m_record  = -1;
 
-        // Start timing.
-        if (s_timers.count(name) == 0)
+        // a scope under an untimed one isn't timed either
+        int parent = 0;
+        if(depth > 1)
+        {
+            parent = thread.m_stack[depth - 2].m_record;
+        }
+
+        if(parent >= 0 && name_id >= 0)
         {
-            timeval timer;
-            s_timers.insert(std::pair<std::string, timeval>(name, timer));
+            frame.m_record = FindRecord(thread, parent, name_id);
         }
-        gettimeofday(&s_timers[name], NULL);
+
+        if(frame.m_record >= 0)
+        {
+            frame.m_start_mem     = MemoryTracker::SampleResidentBytes();
+            frame.m_start_tracked = MemoryTracker::TrackedBytes();
+            frame.m_counter_mask  = 0;
+            if(PerfCounters::Enabled())
+            {
+                frame.m_counter_mask = PerfCounters::Read(frame.m_start_counters);
+            }
+        }
+
+        // Start timing.
+        clock_gettime(CLOCK_MONOTONIC, &frame.m_start);
     }
 
 }
 //-----------------------------------------------------------------------------
 void
-BlockTimer::Stop(const std::string &name)
+BlockTimer::Stop(int name_id)
 {
-#ifdef PARALLEL
-    //MPI_Barrier(MPI_COMM_WORLD);
-#endif
-    if (s_global_depth <= MAX_DEPTH)
+    ThreadTimers &thread = Thread();
+    int depth = thread.m_depth;
+
+    if (depth <= 0)
+    {
+        // unbalanced stop
+        STRAWMAN_INFO("BlockTimer: ignoring stop of " << Name(name_id) 
+                      << ", no timer is running");
+        return;
+    }
+
+    if (depth <= MAX_CHECKED_DEPTH && 
+        thread.m_name_stack[depth - 1] != name_id)
+    {
+        int match = depth - 2;
+        while(match >= 0 && thread.m_name_stack[match] != name_id)
+        {
+            --match;
+        }
+
+        if(match < 0)
+        {
+            STRAWMAN_INFO("BlockTimer: ignoring stop of " << Name(name_id)
+                          << ", it isn't running");
+            return;
+        }
+
+        // the timers started after it were never stopped
+        STRAWMAN_INFO("BlockTimer: stop of " << Name(name_id) 
+                      << " closes " << depth - match - 1
+                      << " timer(s) that were not stopped");
+        depth = match + 1;
+        thread.m_depth = depth;
+    }
+
+    if (depth <= MAX_DEPTH)
     {
         // Record timer.
-        timeval start, end;
-        gettimeofday(&end, NULL);
-        start = s_timers[name];
-
-        // Calculate elapsed time.
-        double elapsed_time = (double)(end.tv_sec - start.tv_sec) + ((double)(end.tv_usec - start.tv_usec))/1000000;
-
-        Node &curr = CurrentNode();
-
-        // Update time spent at current location. added after max (changed)
-        double newval = curr["value"].as_float64() + elapsed_time;
-        
-        curr["value"] = newval;
-        curr["min"]   = newval;
-        curr["avg"]   = newval;
-
-        //increment the counter
-        unsigned int count = curr["count"].as_uint32() + 1;
-        curr["count"] = count;
-       
-        // 
-        // Get system memory info and average
-        //
-
-        // Get memory info
-#ifdef STRAWMAN_PLATFORM_UNIX
-        struct sysinfo system_info;
-        sysinfo(&system_info);
-        long long memUsed = (system_info.totalram -system_info.freeram);
-        memUsed *= system_info.mem_unit;
-        memUsed = memUsed / 1024 / 1024;
-        unsigned int cSysMem = curr["sysMemUsed"].as_uint64();
-        
-        cSysMem = ((cSysMem * (count - 1) + memUsed) )/ count;
-        curr["sysMemUsed"] = uint64(cSysMem);
-        
-        // 
-        // Get process memory usage and average
-        //
-        FILE* file = fopen("/proc/self/status", "r");
-        int kb = -1;
-        char line[128];
-        while (fgets(line, 128, file) != NULL)
+        timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        const Frame &frame = thread.m_stack[depth - 1];
+
+        uint64 counters[PerfCounters::NUM_COUNTERS];
+        int counter_mask = 0;
+        if(frame.m_record >= 0 && frame.m_counter_mask != 0)
+        {
+            counter_mask = frame.m_counter_mask & PerfCounters::Read(counters);
+        }
+
+        if(frame.m_record >= 0)
         {
-            if (strncmp(line, "VmRSS:", 6) == 0)
+            // Calculate elapsed time.
+            double elapsed_time = (double)(end.tv_sec - frame.m_start.tv_sec) +
+                                  ((double)(end.tv_nsec - frame.m_start.tv_nsec))
+                                  / 1000000000.0;
+
+            // atomic stores, ScopeTotals() may be reading them
+            Record &record = GetRecord(thread, frame.m_record);
+            double total = record.m_total + elapsed_time;
+            __atomic_store(&record.m_total, &total, __ATOMIC_RELAXED);
+            __atomic_store_n(&record.m_count,
+                             record.m_count + 1,
+                             __ATOMIC_RELAXED);
+
+            SampleMemory(record, frame);
+
+            for(int i = 0; i < PerfCounters::NUM_COUNTERS; ++i)
             {
-                kb = parseLine(line);
-                break;
+                // a group reopened by Enable() starts over from zero
+                if((counter_mask & (1 << i)) && 
+                   counters[i] >= frame.m_start_counters[i])
+                {
+                    record.m_counters[i] += (double)(counters[i] - 
+                                                     frame.m_start_counters[i]);
+                    record.m_counter_calls[i]++;
+                }
             }
         }
-        fclose(file);
-        
-        kb = kb / 1024;
-        
-        int cProcUsage = curr["procMemMB"].as_int32();
-        cProcUsage = ((cProcUsage * (count - 1) + kb ))  / count;
-        curr["procMemMB"] = cProcUsage;
 
-#else
-        curr["sysMemUsed"] = 0;
-        curr["procMemMB"]  = 0;
-#endif
-        GoUp();
+        if(s_trace != NULL && frame.m_name_id >= 0)
+        {
+            unsigned long slot = __sync_fetch_and_add(&s_trace_next, 1);
+            TraceEvent &event = s_trace[slot % s_trace_capacity];
+            event.m_name_id   = frame.m_name_id;
+            event.m_thread_id = thread.m_thread_id;
+            event.m_start     = to_nanoseconds(frame.m_start);
+            event.m_duration  = to_nanoseconds(end) - event.m_start;
+        }
     }
     
     // Update current location.
-    --s_global_depth;
+    --thread.m_depth;
+
+}
 
+//-----------------------------------------------------------------------------
+void
+BlockTimer::SampleMemory(Record &record, const Frame &frame)
+{
+    uint64 mem = MemoryTracker::SampleResidentBytes();
+    if(mem > record.m_mem_peak)
+    {
+        record.m_mem_peak = mem;
+    }
+    record.m_mem_delta     += (double) mem - (double) frame.m_start_mem;
+    record.m_tracked_delta += (double) MemoryTracker::TrackedBytes() - 
+                              (double) frame.m_start_tracked;
 }
+
 //-----------------------------------------------------------------------------
 BlockTimer::~BlockTimer()
 {
-  Stop(m_name);
+  Stop(m_name_id);
 }
 
 //-----------------------------------------------------------------------------
@@ -250,231 +703,429 @@ BlockTimer::Finalize()
     return GlobalRoot();
 }
 
-
 //-----------------------------------------------------------------------------
-Node &
-BlockTimer::CurrentNode()
+void
+BlockTimer::CollectScopes(const ThreadTimers &thread,
+                          int record_id,
+                          const std::string &path,
+                          std::map<std::string, int> &scopes)
 {
-    return s_global_root[s_current_path];
+    int child = __atomic_load_n(&GetRecord(thread, record_id).m_first_child,
+                                __ATOMIC_ACQUIRE);
+    while(child >= 0)
+    {
+        const Record &record = GetRecord(thread, child);
+        std::string name = Name(record.m_name_id);
+        std::string child_path = path.empty() ? name : path + "/" + name;
+        scopes[child_path] = child;
+        CollectScopes(thread, child, child_path, scopes);
+        child = record.m_next_sibling;
+    }
 }
 
 //-----------------------------------------------------------------------------
-// Initializes values if the current location hasn't been s_visited yet,
-// and updates the set of s_visited locations.
-//-----------------------------------------------------------------------------
-void BlockTimer::Precheck()
+void
+BlockTimer::MergeThreads(std::map<std::string, MergedScope> &scopes)
 {
-    if (s_visited.count(s_current_path + "value") == 0)
-    { // != "" is to prevent a root of ""
-        Node &curr= CurrentNode();
-        curr["value"]      = 0.0;
-        curr["id"]         = s_rank;
-        curr["count"]      = 0u;
-        // added after max (the following 3)
-        curr["min"]        = 0.0;
-        curr["minid"]      = s_rank;
-        curr["avg"]        = 0.0;
-        curr["sysMemUsed"] = 0ul;
-        curr["procMemMB"]  = 0;
+    scopes.clear();
+    for(const ThreadTimers *thread = s_threads; 
+        thread != NULL; 
+        thread = thread->m_next)
+    {
+        std::map<std::string, int> thread_scopes;
+        CollectScopes(*thread, 0, "", thread_scopes);
 
-        s_visited.insert(s_current_path + "value");
+        std::map<std::string, int>::const_iterator itr;
+        for(itr = thread_scopes.begin(); itr != thread_scopes.end(); ++itr)
+        {
+            const Record &record = GetRecord(*thread, itr->second);
+            if(record.m_count == 0)
+            {
+                continue;
+            }
+
+            std::map<std::string, MergedScope>::iterator merged_itr;
+            merged_itr = scopes.find(itr->first);
+            if(merged_itr == scopes.end())
+            {
+                MergedScope &merged = scopes[itr->first];
+                merged.m_record           = record;
+                merged.m_threads          = 1;
+                merged.m_max_thread_total = record.m_total;
+                continue;
+            }
+
+            MergedScope &merged = merged_itr->second;
+            Record      &sum    = merged.m_record;
+            sum.m_count         += record.m_count;
+            sum.m_total         += record.m_total;
+            sum.m_mem_delta     += record.m_mem_delta;
+            sum.m_tracked_delta += record.m_tracked_delta;
+            if(record.m_mem_peak > sum.m_mem_peak)
+            {
+                sum.m_mem_peak = record.m_mem_peak;
+            }
+            for(int i = 0; i < PerfCounters::NUM_COUNTERS; ++i)
+            {
+                sum.m_counters[i]      += record.m_counters[i];
+                sum.m_counter_calls[i] += record.m_counter_calls[i];
+            }
+
+            merged.m_threads++;
+            if(record.m_total > merged.m_max_thread_total)
+            {
+                merged.m_max_thread_total = record.m_total;
+            }
+        }
     }
 }
 
 //-----------------------------------------------------------------------------
-bool
-BlockTimer::CheckForKnownPath(std::string &path)
+void
+BlockTimer::ScopeTotals(std::map<std::string, double> &totals)
 {
-  if(path == "value")       return true;
-  if(path == "id")          return true;
-  if(path == "count")       return true;
-  if(path == "avg")         return true;
-  if(path == "minimum")     return true;
-  if(path == "minid")       return true;
-  if(path == "sysMemUsed")  return true;
-  if(path == "procMemMB")   return true;
-  return false;
+    // unlike MergeThreads(), this runs while other threads are timing,
+    // so it only reads what they store atomically
+    totals.clear();
+    for(const ThreadTimers *thread = __atomic_load_n(&s_threads, 
+                                                     __ATOMIC_ACQUIRE);
+        thread != NULL; 
+        thread = thread->m_next)
+    {
+        std::map<std::string, int> thread_scopes;
+        CollectScopes(*thread, 0, "", thread_scopes);
+
+        std::map<std::string, int>::const_iterator itr;
+        for(itr = thread_scopes.begin(); itr != thread_scopes.end(); ++itr)
+        {
+            Record &record = GetRecord(*thread, itr->second);
+            if(__atomic_load_n(&record.m_count, __ATOMIC_RELAXED) == 0)
+            {
+                continue;
+            }
+
+            double total = 0.0;
+            __atomic_load(&record.m_total, &total, __ATOMIC_RELAXED);
+            totals[itr->first] += total;
+        }
+    }
 }
+
 //-----------------------------------------------------------------------------
-// Goes up one function in the current location path.
-//-----------------------------------------------------------------------------
-void
-BlockTimer::GoUp()
+void BlockTimer::ReduceGlobalRoot()
 {
-    const unsigned int len = s_current_path.length();
-    if (len == 0)
+#ifdef PARALLEL
+    // keeps our messages apart from the application's
+    MPI_Comm comm;
+    MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+    MPI_Comm_rank(comm, &s_rank);
+#else
+    s_rank = 0;
+#endif
+
+    std::map<std::string, MergedScope> local_scopes;
+    MergeThreads(local_scopes);
+
+    std::set<std::string> paths;
+    std::map<std::string, MergedScope>::const_iterator itr;
+    for(itr = local_scopes.begin(); itr != local_scopes.end(); ++itr)
     {
-        s_current_path = "";
-        return;
+        paths.insert(itr->first);
     }
-    
-    unsigned int ctr = 1;
-    unsigned int numslashes = 0;
-  
-    std::string::iterator striter = s_current_path.end();
-    --striter;
 
-    while (ctr < len)
+#ifdef PARALLEL
+    // every rank needs the same scopes in the same order
+    merge_paths(paths, comm);
+#endif
+
+    // one fixed layout record per scope, in the order of paths
+    std::vector<ScopeStats> stats(paths.size());
+    std::set<std::string>::const_iterator path_itr = paths.begin();
+    for(size_t i = 0; i < stats.size(); ++i, ++path_itr)
     {
-        if (*striter == '/')
+        init_stats(stats[i]);
+        itr = local_scopes.find(*path_itr);
+        if(itr == local_scopes.end())
         {
-            numslashes += 1;
-            if (numslashes >= 3)
+            continue;
+        }
+
+        const MergedScope &merged = itr->second;
+        const Record      &record = merged.m_record;
+
+        // average time per call on this rank
+        double time = record.m_total / record.m_count;
+        stats[i].m_ranks    = 1;
+        stats[i].m_calls    = record.m_count;
+        stats[i].m_min      = time;
+        stats[i].m_min_rank = s_rank;
+        stats[i].m_max      = time;
+        stats[i].m_max_rank = s_rank;
+        stats[i].m_sum      = time;
+        stats[i].m_sum_sq   = time * time;
+        stats[i].m_mem_peak = (double) record.m_mem_peak;
+        stats[i].m_mem_delta     = record.m_mem_delta / record.m_count;
+        stats[i].m_tracked_delta = record.m_tracked_delta / record.m_count;
+        // the busiest thread against the average thread
+        stats[i].m_threads   = merged.m_threads;
+        stats[i].m_imbalance = 1.0;
+        if(record.m_total > 0.0)
+        {
+            stats[i].m_imbalance = merged.m_max_thread_total * 
+                                   merged.m_threads / record.m_total;
+        }
+        for(int c = 0; c < PerfCounters::NUM_COUNTERS; ++c)
+        {
+            if(record.m_counter_calls[c] > 0)
             {
-                s_current_path = s_current_path.substr(0, len - ctr + 1);
-                return;
+                stats[i].m_counters[c] = record.m_counters[c] / 
+                                         record.m_counter_calls[c];
+                stats[i].m_counter_ranks[c] = 1;
             }
         }
-        
-        --striter;
-        ++ctr;
     }
-    
-    s_current_path = "";
-    return;
-}
-
-//-----------------------------------------------------------------------------
-void 
-//-----------------------------------------------------------------------------
-BlockTimer::Reduce(Node &a, Node &b)
-{
-    // If a has it
-    if (a.dtype().is_object() && a.has_path("value")) 
-    {
-      // Update (reduce) data
-      a["count"] = a["count"].as_uint32() + b["count"].as_uint32();
-      
-      if (b["value"].as_float64() > a["value"].as_float64())
-      {
-          a["value"] = b["value"];
-          a["id"] = b["id"];
-      }
-      
-      // added after max
-      if (a["min"].as_float64() > b["min"].as_float64())
-      {
-          a["min"] = b["min"];
-          a["minid"] = b["minid"];
-      }
-      
-      unsigned int count_a = a["count"].as_uint32();
-      unsigned int count_b = b["count"].as_uint32();
-      a["avg"] = (a["avg"].as_float64() * count_a + b["avg"].as_float64() * count_b) / (count_a + count_b);
-    }
-  
-    NodeIterator itr_b(&b);
-
-    while(itr_b.has_next())
-    {
-        itr_b.next();
-        std::string bpath = itr_b.name();
-        //
-        // If we don't know the path then
-        // it is a timer that needs processing 
-        //
-        if(CheckForKnownPath(bpath))
+
+    std::vector<ScopeStats> reduced(stats);
+
+#ifdef PARALLEL
+    if(!stats.empty())
+    {
+        MPI_Datatype stats_type;
+        MPI_Type_contiguous(sizeof(ScopeStats) / sizeof(double),
+                            MPI_DOUBLE,
+                            &stats_type);
+        MPI_Type_commit(&stats_type);
+
+        MPI_Op stats_op;
+        MPI_Op_create(reduce_scope_stats, 1, &stats_op);
+
+        MPI_Reduce(&stats[0],
+                   &reduced[0],
+                   (int) stats.size(),
+                   stats_type,
+                   stats_op,
+                   0,
+                   comm);
+
+        MPI_Op_free(&stats_op);
+        MPI_Type_free(&stats_type);
+    }
+    MPI_Comm_free(&comm);
+#endif
+
+    // rebuilt from the records, so finalizing again doesn't reduce twice.
+    // rank 0 gets the stats over all ranks, the others their own.
+    s_global_root.reset();
+    const std::vector<ScopeStats> &result = s_rank == 0 ? reduced : stats;
+    path_itr = paths.begin();
+    for(size_t i = 0; i < result.size(); ++i, ++path_itr)
+    {
+        const ScopeStats &scope = result[i];
+        if(scope.m_ranks == 0)
         {
             continue;
         }
-        
-        if (a.dtype().is_object() &&  a.has_path(bpath))
+
+        double mean     = scope.m_sum / scope.m_ranks;
+        double variance = scope.m_sum_sq / scope.m_ranks - mean * mean;
+
+        Node &node = s_global_root[scope_tree_path(*path_itr)];
+        node["ranks"]      = (int) scope.m_ranks;
+        node["count"]      = scope.m_calls / scope.m_ranks;
+        node["min"]        = scope.m_min;
+        node["min_rank"]   = (int) scope.m_min_rank;
+        node["max"]        = scope.m_max;
+        node["max_rank"]   = (int) scope.m_max_rank;
+        node["mean"]       = mean;
+        node["stddev"]     = variance > 0.0 ? sqrt(variance) : 0.0;
+        // memory in MB, the deltas are averages per call
+        node["mem_peak"]   = scope.m_mem_peak / (1024.0 * 1024.0);
+        node["mem_delta"]  = scope.m_mem_delta / scope.m_ranks 
+                             / (1024.0 * 1024.0);
+        node["tracked_delta"] = scope.m_tracked_delta / scope.m_ranks
+                                / (1024.0 * 1024.0);
+
+        // timed by more than one thread of a rank
+        if(scope.m_threads > 1)
+        {
+            node["threads"]          = (int) scope.m_threads;
+            node["thread_imbalance"] = scope.m_imbalance;
+        }
+
+        // hardware counts per call, averaged over the ranks that had them
+        for(int c = 0; c < PerfCounters::NUM_COUNTERS; ++c)
         {
-            Reduce(a[bpath], b[bpath]);
+            if(scope.m_counter_ranks[c] > 0)
+            {
+                node["counters"][PerfCounters::Name(c)] = 
+                    scope.m_counters[c] / scope.m_counter_ranks[c];
+            }
         }
-    }
 
-    return;
+        if(scope.m_counter_ranks[PerfCounters::CYCLES] > 0 &&
+           scope.m_counter_ranks[PerfCounters::INSTRUCTIONS] > 0 &&
+           scope.m_counters[PerfCounters::CYCLES] > 0)
+        {
+            node["counters/ipc"] = scope.m_counters[PerfCounters::INSTRUCTIONS] /
+                                   scope.m_counters[PerfCounters::CYCLES];
+        }
+    }
 }
+
 //-----------------------------------------------------------------------------
-void 
-BlockTimer::AverageByCount(Node &node, int numRanks)
+void
+BlockTimer::EnableTrace(int max_events)
 {
-    if(node.dtype().is_object() && node.has_path("value"))
+    DisableTrace();
+    if(max_events <= 0)
     {
-        double count  = node["count"].as_uint32()  / numRanks;
-        node["value"] = node["value"].as_float64() / count;
-        node["min"]   = node["min"].as_float64()   / count;
-        node["avg"]   = node["avg"].as_float64()   / count;
-        node["count"] = uint32(count);
+        return;
     }
-  
-  
-    NodeIterator itr = node.children();
-
-    while(itr.has_next()) 
-    {
-        Node &curr_node = itr.next();
-        std::string curr_path = itr.name();
+    s_trace_next     = 0;
+    s_trace_capacity = (unsigned long) max_events;
+    s_trace          = new TraceEvent[max_events];
+}
 
-        if(CheckForKnownPath(curr_path))
-        {
-            continue;
-        }
-        
-        AverageByCount(curr_node, numRanks);
-    }
+//-----------------------------------------------------------------------------
+void
+BlockTimer::DisableTrace()
+{
+    TraceEvent *trace = s_trace;
+    s_trace = NULL;
+    delete [] trace;
+    s_trace_capacity = 0;
+    s_trace_next     = 0;
+}
 
-    return;
+//-----------------------------------------------------------------------------
+bool
+BlockTimer::TraceEnabled()
+{
+    return s_trace != NULL;
 }
 
 //-----------------------------------------------------------------------------
-void 
-BlockTimer::ReduceAll(Node &thisRanksNode)
+void
+BlockTimer::WriteTrace(const std::string &file_path)
 {
+    int rank = 0;
+    int size = 1;
 #ifdef PARALLEL
-    int temp;
-    MPI_Comm_size(MPI_COMM_WORLD, &temp);
-    const unsigned int numProcesses = temp;
-    MPI_Comm_rank(MPI_COMM_WORLD, &temp);
-    const unsigned int rank = temp;
-
-    std::vector<Node> recvNodes(numProcesses+1);
+    MPI_Comm comm;
+    MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    // the clocks of different nodes are unrelated, so each rank's 
+    // timeline starts from the moment all ranks leave this barrier
+    MPI_Barrier(comm);
+#endif
+    timespec sync;
+    clock_gettime(CLOCK_MONOTONIC, &sync);
+    int64 sync_ns = to_nanoseconds(sync);
 
-    if (rank == 0)
+    // the ring holds the last s_trace_capacity events
+    unsigned long num_events = 0;
+    unsigned long first      = 0;
+    int64 earliest = sync_ns;
+    if(s_trace != NULL)
     {
-        for (unsigned int i = 1; i < numProcesses; ++i)
+        num_events = s_trace_next;
+        if(num_events > s_trace_capacity)
         {
-          recv(recvNodes[i], // node
-               i, // source
-               42, // tag
-               MPI_COMM_WORLD // comm
-               );
-           }
-     }
-     else 
-     { 
-         send(thisRanksNode, // node
-              0, // dest
-              42, // tag
-              MPI_COMM_WORLD // comm
-              );
-    }
-
-    if (rank == 0)
-    {
-        for (unsigned int i = 1; i < numProcesses; ++i)
+            first      = num_events - s_trace_capacity;
+        }
+        for(unsigned long i = first; i < num_events; ++i)
         {
-            Reduce(thisRanksNode.fetch("children"),
-                   recvNodes[i].fetch("children"));
+            int64 start = s_trace[i % s_trace_capacity].m_start;
+            earliest = start < earliest ? start : earliest;
         }
     }
-  
-    // Get the average time per iteration
+
+    // shift every timeline by the same amount, so no timestamp is negative
+    int64 shift = sync_ns - earliest;
+#ifdef PARALLEL
+    long long local_shift = shift, max_shift = 0;
+    MPI_Allreduce(&local_shift, &max_shift, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    shift = max_shift;
+#endif
+
+    // json array format, the ranks' parts are concatenated as they are
+    std::ostringstream oss;
+    oss << (rank == 0 ? "[\n" : ",\n")
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+        << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+
+    char buff[256];
+    for(unsigned long i = first; i < num_events; ++i)
+    {
+        const TraceEvent &event = s_trace[i % s_trace_capacity];
+        snprintf(buff, sizeof(buff),
+                 ",\n{\"name\":\"%s\",\"cat\":\"strawman\",\"ph\":\"X\","
+                 "\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                 Name(event.m_name_id),
+                 rank,
+                 event.m_thread_id,
+                 (double)(event.m_start - sync_ns + shift) / 1000.0,
+                 (double)event.m_duration / 1000.0);
+        oss << buff;
+    }
+
+    if(rank == size - 1)
+    {
+        oss << "\n]\n";
+    }
+
+    std::string chunk = oss.str();
+
+#ifdef PARALLEL
+    long long chunk_size = (long long) chunk.size();
+    long long offset = 0;
+    MPI_Exscan(&chunk_size, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
     if(rank == 0)
     {
-        AverageByCount(s_global_root, numProcesses);
+        offset = 0;
     }
 
+    MPI_File fh;
+    int res = MPI_File_open(comm,
+                            const_cast<char*>(file_path.c_str()),
+                            MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                            MPI_INFO_NULL,
+                            &fh);
+    if(res == MPI_SUCCESS)
+    {
+        MPI_File_set_size(fh, 0);
+        res = MPI_File_write_at_all(fh,
+                                    (MPI_Offset) offset,
+                                    &chunk[0],
+                                    (int) chunk.size(),
+                                    MPI_CHAR,
+                                    MPI_STATUS_IGNORE);
+        MPI_File_close(&fh);
+    }
+    MPI_Comm_free(&comm);
+    bool ok = res == MPI_SUCCESS;
 #else
-    AverageByCount(BlockTimer::GlobalRoot(),1);
+    FILE *fp = fopen(file_path.c_str(), "w");
+    bool ok = fp != NULL;
+    if(ok)
+    {
+        ok = fwrite(chunk.c_str(), 1, chunk.size(), fp) == chunk.size();
+        ok = fclose(fp) == 0 && ok;
+    }
 #endif
-}
 
-//-----------------------------------------------------------------------------
-void BlockTimer::ReduceGlobalRoot()
-{
-    ReduceAll(GlobalRoot());
+    if(!ok)
+    {
+        STRAWMAN_ERROR("Error: failed to write trace file " << file_path);
+    }
+
+    if(first > 0)
+    {
+        STRAWMAN_INFO("Trace buffer of rank " << rank << " wrapped, " 
+                      << file_path << " only has its last " 
+                      << s_trace_capacity << " events");
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -51,17 +51,36 @@
 #ifndef STRAWMAN_BLOCK_TIMER_HPP
 #define STRAWMAN_BLOCK_TIMER_HPP
 
-#define STRAWMAN_BLOCK_TIMER(NAME) strawman::BlockTimer STRAWMAN_BLOCK_TIMER_##NAME(#NAME);
+// the name is interned once per call site, so starting the timer 
+// doesn't touch strings
+#define STRAWMAN_BLOCK_TIMER(NAME) \
+    static const int STRAWMAN_BLOCK_TIMER_ID_##NAME = \
+        strawman::BlockTimer::InternName(#NAME); \
+    strawman::BlockTimer STRAWMAN_BLOCK_TIMER_##NAME(STRAWMAN_BLOCK_TIMER_ID_##NAME);
+// for timers that don't follow a block, each call site caches its id
+#define STRAWMAN_TIMER_START(NAME) \
+    do { \
+        static const int strawman_timer_id = \
+            strawman::BlockTimer::InternName(#NAME); \
+        strawman::BlockTimer::StartTimer(strawman_timer_id); \
+    } while(0)
+#define STRAWMAN_TIMER_STOP(NAME) \
+    do { \
+        static const int strawman_timer_id = \
+            strawman::BlockTimer::InternName(#NAME); \
+        strawman::BlockTimer::StopTimer(strawman_timer_id); \
+    } while(0)
 #define MAX_DEPTH 5
 
-#include<sys/time.h>
+#include <time.h>
 #include <string>
 #include <map>
-#include <set>
+#include <vector>
 #include <cstdlib>
     
 #include <conduit.hpp>
 #include <strawman_config.h>
+#include <strawman_perf_counters.hpp>
 
 //-----------------------------------------------------------------------------
 // -- begin strawman:: --
@@ -69,63 +88,187 @@
 namespace strawman
 {
 
+//-----------------------------------------------------------------------------
+// Starting and stopping a timer only updates a fixed size record of its
+// scope (the path of timer names that lead to it), found by interned
+// name ids. Nothing is allocated once a scope has been seen, and there
+// is no communication: the records are turned into a tree and reduced
+// over the ranks in Finalize().
+//
+// Each thread has its own scope stack and records, so timers can run
+// inside TBB or OpenMP regions. A worker thread's scopes start at the top
+// of the tree, they don't nest under the scope that spawned the work.
+// Finalize() merges the threads, it must not run while other threads 
+// are timing. ScopeTotals() can: records never move once added, and 
+// the links and totals it reads are atomic.
+//
+// Names are interned into a fixed size table that is only locked to add
+// a name, looking up a known name is lock free. A stop must match the
+// running timer: a stop of a timer further down the stack also closes
+// (without recording) the timers started after it, and a stop of a 
+// timer that isn't running is ignored.
 //-----------------------------------------------------------------------------
 class BlockTimer
 {
 public:
     // methods
     BlockTimer(const std::string &name);
+    BlockTimer(int name_id);
     ~BlockTimer();
+
+    // id of a timer name, the same name always gets the same id.
+    // -1 once the name table is full, those timers are not recorded.
+    static int  InternName(const char *name);
+
+    // by name, for the c api. prefer ids (or the STRAWMAN_TIMER_START 
+    // and STRAWMAN_TIMER_STOP macros) in c++ code.
     static void StartTimer(const char *name);
     static void StopTimer(const char *name);
+    static void StartTimer(int name_id);
+    static void StopTimer(int name_id);
+    // collective. rank 0 gets the min, max (with the ranks they came 
+    // from), mean and stddev over the ranks of each scope's average 
+    // time per call, the other ranks get the stats of their own timings.
     static conduit::Node &Finalize();
     static void           WriteLogFile();
+    // local, total seconds spent so far in each scope, keyed by path 
+    // ("A/B"). cheap enough to diff around every Execute.
+    static void ScopeTotals(std::map<std::string, double> &totals);
+
+    // keeps a timeline of the last max_events timed calls of all threads
+    static void EnableTrace(int max_events);
+    static void DisableTrace();
+    static bool TraceEnabled();
+    // collective, writes the timelines of all ranks to one chrome 
+    // trace-event json file (chrome://tracing, ui.perfetto.dev)
+    static void WriteTrace(const std::string &file_path);
 
 private:
+    // scopes a thread can have records for, deeper scopes and scopes 
+    // past the limit are not timed
+    static const int MAX_RECORDS = 1024;
+    // records are allocated this many at a time
+    static const int RECORD_CHUNK = 16;
+    // distinct timer names
+    static const int MAX_NAMES   = 1024;
+    // open addressing hash of the names, kept at most half full
+    static const int NAME_SLOTS  = 2 * MAX_NAMES;
+    // nesting depth up to which stops are checked against their starts
+    static const int MAX_CHECKED_DEPTH = 64;
+
+    // totals of one scope. the links are published with release stores
+    // and m_count and m_total are stored atomically, everything else is
+    // only read by Finalize().
+    struct Record
+    {
+        int           m_name_id;
+        int           m_parent;
+        int           m_first_child;
+        int           m_next_sibling;
+        unsigned int  m_count;
+        double        m_total;
+        // resident bytes: the most seen at a stop and the growth summed
+        // over the calls, and the summed growth of tracked allocations
+        conduit::uint64 m_mem_peak;
+        double        m_mem_delta;
+        double        m_tracked_delta;
+        // hardware counter totals, and the calls that counted them
+        double        m_counters[PerfCounters::NUM_COUNTERS];
+        unsigned int  m_counter_calls[PerfCounters::NUM_COUNTERS];
+    };
+
+    // a started timer
+    struct Frame
+    {
+        int           m_name_id;
+        int           m_record;
+        timespec      m_start;
+        conduit::uint64 m_start_mem;
+        conduit::uint64 m_start_tracked;
+        // valid counters at the start
+        int           m_counter_mask;
+        conduit::uint64 m_start_counters[PerfCounters::NUM_COUNTERS];
+    };
+
+    // one timed call, times in nanoseconds of CLOCK_MONOTONIC
+    struct TraceEvent
+    {
+        int             m_name_id;
+        int             m_thread_id;
+        conduit::int64  m_start;
+        conduit::int64  m_duration;
+    };
     
-    static void Start(const std::string &name);
-    static void Stop(const std::string &name);
+    // the timers of one thread. made the first time the thread starts
+    // a timer and kept for the life of the process, so Finalize() can 
+    // merge threads that are gone.
+    struct ThreadTimers
+    {
+        int           m_thread_id;
+        int           m_depth;
+        Frame         m_stack[MAX_DEPTH];
+        // names of the running timers, including the untimed deeper ones
+        int           m_name_stack[MAX_CHECKED_DEPTH];
+        // record i is m_chunks[i / RECORD_CHUNK][i % RECORD_CHUNK], 
+        // record 0 is the root of the thread's scope tree
+        Record       *m_chunks[MAX_RECORDS / RECORD_CHUNK];
+        int           m_num_records;
+        ThreadTimers *m_next;
+    };
+
+    // a scope summed over the threads that ran it
+    struct MergedScope
+    {
+        Record        m_record;
+        int           m_threads;
+        double        m_max_thread_total;
+    };
+    
+    static void Start(int name_id);
+    static void Stop(int name_id);
+    // id of an interned name, -1 if it hasn't been interned
+    static int  FindName(const char *name, unsigned int hash);
+    // "" for -1
+    static const char *Name(int name_id);
     static inline conduit::Node &GlobalRoot() 
         {return s_global_root;}
 
     static void ReduceGlobalRoot();
-    
-    // non-static methods
-    
-    // Initializes values if the current location hasn't been visited yet,
-    // and updates the set of visited locations.
-    static void Precheck();
 
-    // Goes up one function in the current location path.
-    static void GoUp();
+    // timers of the calling thread
+    static ThreadTimers &Thread();
+    static inline Record &GetRecord(const ThreadTimers &thread, int record)
+        {return thread.m_chunks[record / RECORD_CHUNK][record % RECORD_CHUNK];}
+    // record of the scope name_id under parent, -1 if we are out of records
+    static int  FindRecord(ThreadTimers &thread, int parent, int name_id);
+    // adds the memory the frame's call took to the record
+    static void SampleMemory(Record &record, const Frame &frame);
+    // maps the path of each scope under record ("A/B") to its record
+    static void CollectScopes(const ThreadTimers &thread,
+                              int record,
+                              const std::string &path,
+                              std::map<std::string, int> &scopes);
+    // the scopes of all threads, by path
+    static void MergeThreads(std::map<std::string, MergedScope> &scopes);
 
     // non-static data members
-    std::string m_name;
+    int m_name_id;
 
-    // private static methods
-    static void ReduceAll(conduit::Node &);
-    static conduit::Node &CurrentNode();
-    
-    static void Reduce(conduit::Node &,
-                       conduit::Node &);
-
-    static bool CheckForKnownPath(std::string &);
-
-    static void AverageByCount(conduit::Node &,
-                               int);
-    static void FillDataArray(conduit::Node &,
-                              const int &,
-                              double &,
-                              double [][3],
-                              std::string);
     // static data members 
     static conduit::Node                  s_global_root;
     static int                            s_rank; // MPI rank
-    static int                            s_global_depth;
-    static std::string                    s_current_path;
-    static std::map<std::string, timeval> s_timers;
-    static std::set<std::string>          s_visited;
-    
+    // interned names by id, never moved or freed. a slot is only 
+    // published after its name is in place.
+    static const char                    *s_names[MAX_NAMES];
+    static int                            s_num_names;
+    static int                            s_name_slots[NAME_SLOTS];
+    // every thread that has timed something, pushed atomically
+    static ThreadTimers * volatile        s_threads;
+    // ring buffer of trace events, NULL unless tracing. writers claim
+    // slots with an atomic increment of s_trace_next.
+    static TraceEvent                    *s_trace;
+    static unsigned long                  s_trace_capacity;
+    static volatile unsigned long         s_trace_next;
 };
 
 //-----------------------------------------------------------------------------
@@ -80,6 +80,21 @@ create_directory(const std::string &path)
     return (mkdir(path.c_str(),S_IRWXU | S_IRWXG) == 0);
 }
 
+//-----------------------------------------------------------------------------
+bool
+create_file_directory(const std::string &file_path)
+{
+    std::string file_name, dir;
+    conduit::utils::rsplit_string(file_path, "/", file_name, dir);
+
+    if(dir.empty())
+    {
+        return true;
+    }
+
+    return create_directory(dir) || directory_exists(dir);
+}
+
 
 //-----------------------------------------------------------------------------
 };
@@ -64,6 +64,9 @@ namespace strawman
 bool directory_exists(const std::string &path);
 // helper to create a directory
 bool create_directory(const std::string &path);
+// helper to create the directory a file lives in, true if it exists 
+// afterwards. ranks may race to create it, the losers still succeed.
+bool create_file_directory(const std::string &file_path);
 
 //-----------------------------------------------------------------------------
 };
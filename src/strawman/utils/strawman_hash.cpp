@@ -0,0 +1,138 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_hash.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_hash.hpp"
+
+// standard includes
+#include <string.h>
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+void
+hash_bytes(const void *ptr, index_t num_bytes, uint64 &hash)
+{
+    const unsigned char *bytes = (const unsigned char*) ptr;
+
+    index_t i = 0;
+    for(; i + (index_t) sizeof(uint64) <= num_bytes; i += sizeof(uint64))
+    {
+        uint64 word;
+        memcpy(&word, bytes + i, sizeof(uint64));
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+
+    for(; i < num_bytes; ++i)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+hash_string(const std::string &str, uint64 &hash)
+{
+    hash_bytes(str.c_str(), str.size() + 1, hash);
+}
+
+//-----------------------------------------------------------------------------
+void
+hash_node(const Node &node, uint64 &hash)
+{
+    const DataType &dtype = node.dtype();
+    index_t id = dtype.id();
+    hash_bytes(&id, sizeof(id), hash);
+
+    if(dtype.is_object() || dtype.is_list())
+    {
+        index_t num_children = node.number_of_children();
+        hash_bytes(&num_children, sizeof(num_children), hash);
+
+        NodeConstIterator itr = node.children();
+        while(itr.has_next())
+        {
+            const Node &child = itr.next();
+            if(dtype.is_object())
+            {
+                hash_string(itr.name(), hash);
+            }
+            hash_node(child, hash);
+        }
+    }
+    else if(dtype.is_compact())
+    {
+        index_t num_bytes = dtype.bytes_compact();
+        hash_bytes(&num_bytes, sizeof(num_bytes), hash);
+        if(num_bytes > 0)
+        {
+            hash_bytes(node.element_ptr(0), num_bytes, hash);
+        }
+    }
+    else
+    {
+        Node n_compact;
+        node.compact_to(n_compact);
+        index_t num_bytes = n_compact.total_bytes_compact();
+        hash_bytes(&num_bytes, sizeof(num_bytes), hash);
+        hash_bytes(n_compact.data_ptr(), num_bytes, hash);
+    }
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
@@ -0,0 +1,527 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_lossy_codec.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_lossy_codec.hpp"
+
+#include "strawman_logging.hpp"
+
+// standard includes
+#include <math.h>
+#include <limits>
+
+// thirdparty includes
+#include <lodepng.h>
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+const char *LOSSY_CODEC   = "strawman_lossy";
+const int   LOSSY_VERSION = 1;
+// bin indices are stored as uint16 offset by the radius, code 0 marks
+// a value stored as an outlier
+const int32 LOSSY_RADIUS  = 32768;
+
+//-----------------------------------------------------------------------------
+// false for nans and infs
+//-----------------------------------------------------------------------------
+bool
+is_finite(float64 value)
+{
+    return (value - value) == 0;
+}
+
+//-----------------------------------------------------------------------------
+// the encoder and decoder must compute the same decoded value
+//-----------------------------------------------------------------------------
+template<typename T>
+T
+reconstruct(T pred, float64 bin_size, int32 bin)
+{
+    return (T) ((float64) pred + bin_size * (float64) bin);
+}
+
+//-----------------------------------------------------------------------------
+template<typename T>
+void
+value_range(const Node &values, float64 &vmin, float64 &vmax)
+{
+    vmin =  std::numeric_limits<float64>::max();
+    vmax = -std::numeric_limits<float64>::max();
+    index_t num_elements = values.dtype().number_of_elements();
+    for(index_t i = 0; i < num_elements; ++i)
+    {
+        float64 value = (float64) *(const T*) values.element_ptr(i);
+        if(is_finite(value))
+        {
+            vmin = value < vmin ? value : vmin;
+            vmax = value > vmax ? value : vmax;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+template<typename T>
+void
+quantize(const Node &values,
+         float64 error_bound,
+         std::vector<uint16> &codes,
+         std::vector<T> &outliers,
+         float64 &max_error)
+{
+    index_t num_elements = values.dtype().number_of_elements();
+    codes.resize(num_elements);
+    max_error = 0.0;
+
+    float64 bin_size = 2.0 * error_bound;
+    T pred = 0;
+    for(index_t i = 0; i < num_elements; ++i)
+    {
+        T value = *(const T*) values.element_ptr(i);
+        bool coded = false;
+        if(bin_size > 0 && is_finite((float64) value))
+        {
+            float64 bin = floor(((float64) value - (float64) pred) / bin_size 
+                                + 0.5);
+            if(bin > -LOSSY_RADIUS && bin < LOSSY_RADIUS)
+            {
+                T decoded = reconstruct(pred, bin_size, (int32) bin);
+                float64 error = fabs((float64) value - (float64) decoded);
+                // the cast to T can round past the bound
+                if(error <= error_bound)
+                {
+                    codes[i] = (uint16) ((int32) bin + LOSSY_RADIUS);
+                    pred = decoded;
+                    max_error = error > max_error ? error : max_error;
+                    coded = true;
+                }
+            }
+        }
+        else if(value == pred)
+        {
+            codes[i] = (uint16) LOSSY_RADIUS;
+            coded = true;
+        }
+
+        if(!coded)
+        {
+            codes[i] = 0;
+            outliers.push_back(value);
+            pred = value;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+template<typename T>
+void
+dequantize(const std::vector<uint16> &codes,
+           const Node &outliers,
+           float64 error_bound,
+           T *values)
+{
+    index_t num_outliers = outliers.dtype().is_empty() ? 0 :
+                           outliers.dtype().number_of_elements();
+    index_t outlier = 0;
+
+    float64 bin_size = 2.0 * error_bound;
+    T pred = 0;
+    for(size_t i = 0; i < codes.size(); ++i)
+    {
+        if(codes[i] == 0)
+        {
+            if(outlier >= num_outliers)
+            {
+                STRAWMAN_ERROR("Error: lossy encoded array is missing "
+                               "outliers");
+            }
+            pred = *(const T*) outliers.element_ptr(outlier++);
+        }
+        else
+        {
+            pred = reconstruct(pred, 
+                               bin_size,
+                               (int32) codes[i] - LOSSY_RADIUS);
+        }
+        values[i] = pred;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// byte planes of the codes, the high bytes are nearly constant and 
+// deflate well on their own
+//-----------------------------------------------------------------------------
+void
+deflate_codes(const std::vector<uint16> &codes, 
+              std::vector<unsigned char> &bytes)
+{
+    size_t num_codes = codes.size();
+    std::vector<unsigned char> planes(2 * num_codes);
+    for(size_t i = 0; i < num_codes; ++i)
+    {
+        planes[i]             = (unsigned char) (codes[i] & 0xff);
+        planes[num_codes + i] = (unsigned char) (codes[i] >> 8);
+    }
+
+    // larger lz77 windows barely help the ratio and are much slower
+    if(lodepng::compress(bytes, planes) != 0)
+    {
+        STRAWMAN_ERROR("Error: failed to deflate lossy codes");
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+inflate_codes(const Node &bytes, 
+              size_t num_codes,
+              std::vector<uint16> &codes)
+{
+    std::vector<unsigned char> planes;
+    if(lodepng::decompress(planes,
+                           (const unsigned char *) bytes.element_ptr(0),
+                           (size_t) bytes.dtype().number_of_elements()) != 0 ||
+       planes.size() != 2 * num_codes)
+    {
+        STRAWMAN_ERROR("Error: failed to inflate lossy codes");
+    }
+
+    codes.resize(num_codes);
+    for(size_t i = 0; i < num_codes; ++i)
+    {
+        codes[i] = (uint16) (planes[i] | (planes[num_codes + i] << 8));
+    }
+}
+
+//-----------------------------------------------------------------------------
+template<typename T>
+void
+encode(const Node &values,
+       float64 error_bound,
+       bool relative,
+       Node &encoded,
+       Node &stats)
+{
+    if(relative)
+    {
+        float64 vmin, vmax;
+        value_range<T>(values, vmin, vmax);
+        error_bound = vmax > vmin ? error_bound * (vmax - vmin) : 0.0;
+    }
+
+    std::vector<uint16> codes;
+    std::vector<T>      outliers;
+    float64             max_error;
+    quantize(values, error_bound, codes, outliers, max_error);
+
+    std::vector<unsigned char> bytes;
+    deflate_codes(codes, bytes);
+
+    index_t num_elements = values.dtype().number_of_elements();
+
+    encoded.reset();
+    encoded["codec"]              = LOSSY_CODEC;
+    encoded["version"]            = LOSSY_VERSION;
+    encoded["dtype"]              = values.dtype().name();
+    encoded["number_of_elements"] = (int64) num_elements;
+    encoded["error_bound"]        = error_bound;
+    encoded["codes"].set((const uint8 *) &bytes[0], (index_t) bytes.size());
+    if(!outliers.empty())
+    {
+        encoded["outliers"].set(&outliers[0], (index_t) outliers.size());
+    }
+
+    float64 raw_bytes     = (float64) (num_elements * sizeof(T));
+    float64 encoded_bytes = (float64) (bytes.size() + 
+                                       outliers.size() * sizeof(T));
+
+    stats["error_bound"]   = error_bound;
+    stats["max_error"]     = max_error;
+    stats["outliers"]      = (int64) outliers.size();
+    stats["raw_bytes"]     = raw_bytes;
+    stats["encoded_bytes"] = encoded_bytes;
+    stats["ratio"]         = encoded_bytes > 0 ? raw_bytes / encoded_bytes 
+                                               : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+bool
+selects_field(const std::vector<std::string> &field_names,
+              const std::string &name)
+{
+    if(field_names.empty())
+    {
+        return true;
+    }
+
+    for(size_t i = 0; i < field_names.size(); ++i)
+    {
+        if(field_names[i] == name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// encodes the float leaves of values into the matching nodes of encoded
+//-----------------------------------------------------------------------------
+void
+encode_values(const Node &values,
+              float64 error_bound,
+              bool relative,
+              Node &encoded,
+              Node &stats)
+{
+    const DataType &dtype = values.dtype();
+    if(dtype.is_float32() || dtype.is_float64())
+    {
+        lossy_encode(values, error_bound, relative, encoded, stats);
+        return;
+    }
+
+    // multi component values, e.g. values/x
+    if(dtype.is_object())
+    {
+        NodeConstIterator itr = values.children();
+        while(itr.has_next())
+        {
+            const Node &child = itr.next();
+            std::string name = itr.name();
+            encode_values(child, error_bound, relative, 
+                          encoded[name], stats[name]);
+            if(stats[name].number_of_children() == 0)
+            {
+                stats.remove(name);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+decode_values(Node &values)
+{
+    if(lossy_is_encoded(values))
+    {
+        Node decoded;
+        lossy_decode(values, decoded);
+        values.set(decoded);
+        return;
+    }
+
+    if(values.dtype().is_object())
+    {
+        NodeIterator itr = values.children();
+        while(itr.has_next())
+        {
+            decode_values(itr.next());
+        }
+    }
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+bool
+lossy_is_encoded(const Node &node)
+{
+    return node.dtype().is_object() &&
+           node.has_child("codec") &&
+           node["codec"].dtype().is_string() &&
+           node["codec"].as_string() == LOSSY_CODEC;
+}
+
+//-----------------------------------------------------------------------------
+void
+lossy_encode(const Node &values,
+             float64 error_bound,
+             bool relative,
+             Node &encoded,
+             Node &stats)
+{
+    if(values.dtype().number_of_elements() == 0)
+    {
+        STRAWMAN_ERROR("Error: lossy encoding needs a non-empty array");
+    }
+
+    if(values.dtype().is_float64())
+    {
+        encode<float64>(values, error_bound, relative, encoded, stats);
+    }
+    else if(values.dtype().is_float32())
+    {
+        encode<float32>(values, error_bound, relative, encoded, stats);
+    }
+    else
+    {
+        STRAWMAN_ERROR("Error: lossy encoding only supports float32 and "
+                       "float64 arrays, not " << values.dtype().name());
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+lossy_decode(const Node &encoded, Node &values)
+{
+    if(!lossy_is_encoded(encoded) ||
+       encoded["version"].to_int() != LOSSY_VERSION)
+    {
+        STRAWMAN_ERROR("Error: not a lossy encoded array (version " 
+                       << LOSSY_VERSION << ")");
+    }
+
+    index_t     num_elements = encoded["number_of_elements"].to_int64();
+    float64     error_bound  = encoded["error_bound"].to_float64();
+    std::string dtype_name   = encoded["dtype"].as_string();
+
+    std::vector<uint16> codes;
+    inflate_codes(encoded["codes"], (size_t) num_elements, codes);
+
+    Node no_outliers;
+    const Node &outliers = encoded.has_child("outliers") ? 
+                           encoded["outliers"] : no_outliers;
+
+    if(dtype_name == "float64")
+    {
+        values.set(DataType::float64(num_elements));
+        dequantize(codes, outliers, error_bound, values.as_float64_ptr());
+    }
+    else if(dtype_name == "float32")
+    {
+        values.set(DataType::float32(num_elements));
+        dequantize(codes, outliers, error_bound, values.as_float32_ptr());
+    }
+    else
+    {
+        STRAWMAN_ERROR("Error: unsupported lossy encoded dtype " 
+                       << dtype_name);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+lossy_encode_fields(const Node &data,
+                    float64 error_bound,
+                    bool relative,
+                    const std::vector<std::string> &field_names,
+                    Node &encoded,
+                    Node &stats)
+{
+    encoded.set_external(const_cast<Node&>(data));
+
+    if(!data.has_child("fields"))
+    {
+        return;
+    }
+
+    NodeConstIterator itr = data["fields"].children();
+    while(itr.has_next())
+    {
+        const Node &field = itr.next();
+        std::string name = itr.name();
+        if(!field.has_child("values") || !selects_field(field_names, name))
+        {
+            continue;
+        }
+
+        encode_values(field["values"],
+                      error_bound,
+                      relative,
+                      encoded["fields"][name]["values"],
+                      stats[name]);
+
+        if(stats.has_child(name) && stats[name].number_of_children() == 0)
+        {
+            // no float arrays
+            stats.remove(name);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+lossy_decode_fields(Node &data)
+{
+    if(!data.has_child("fields"))
+    {
+        return;
+    }
+
+    NodeIterator itr = data["fields"].children();
+    while(itr.has_next())
+    {
+        Node &field = itr.next();
+        if(field.has_child("values"))
+        {
+            decode_values(field["values"]);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
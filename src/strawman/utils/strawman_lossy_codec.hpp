@@ -0,0 +1,114 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_lossy_codec.hpp
+///
+//-----------------------------------------------------------------------------
+#ifndef STRAWMAN_LOSSY_CODEC_HPP
+#define STRAWMAN_LOSSY_CODEC_HPP
+
+#include <conduit.hpp>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// Error bounded lossy compression of float arrays. Each value is 
+// predicted from the previous decoded value and the difference is 
+// quantized into bins of twice the error bound. The bin indices are 
+// deflated, values that don't fit a bin are stored as they are.
+//
+// An encoded array is a tree with:
+//   codec, version, dtype, number_of_elements, error_bound,
+//   codes (uint8, deflated bin indices), outliers (optional)
+//-----------------------------------------------------------------------------
+
+// true if node holds an array encoded by lossy_encode
+bool lossy_is_encoded(const conduit::Node &node);
+
+// encodes a float32 or float64 array, each decoded value is within the
+// error bound of the original. a relative bound is scaled by the range
+// of the values. stats gets the absolute bound used, the max error, 
+// the raw and encoded sizes and their ratio.
+void lossy_encode(const conduit::Node &values,
+                  conduit::float64 error_bound,
+                  bool relative,
+                  conduit::Node &encoded,
+                  conduit::Node &stats);
+
+void lossy_decode(const conduit::Node &encoded,
+                  conduit::Node &values);
+
+// encodes the values of the float fields of a blueprint domain, or of 
+// the named fields only. encoded gets an external view of data, with 
+// the encoded arrays in place of the field values. stats has an entry
+// per encoded array, e.g. stats/pressure or stats/velocity/x.
+void lossy_encode_fields(const conduit::Node &data,
+                         conduit::float64 error_bound,
+                         bool relative,
+                         const std::vector<std::string> &field_names,
+                         conduit::Node &encoded,
+                         conduit::Node &stats);
+
+// decodes the encoded field values of a blueprint domain in place
+void lossy_decode_fields(conduit::Node &data);
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
+
@@ -0,0 +1,268 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_memory_tracker.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_memory_tracker.hpp"
+
+// standard includes
+#include <stdlib.h>
+#include <time.h>
+// unix only
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+// Allocate() keeps the size in front of the block, padded so the block 
+// keeps malloc's alignment
+const size_t ALLOCATION_HEADER = 16;
+
+// /proc/self/statm, -1 before the first read, -2 if it can't be opened
+volatile int statm_fd     = -1;
+long    page_bytes        = 0;
+
+// read and written atomically, SetSampleInterval() bumps the generation
+// so every thread reads again
+double  sample_interval   = 0.0;
+int     sample_generation = 0;
+
+// each thread keeps its own reading, the timers sample from any thread
+__thread double  last_sample_time       = -1.0;
+__thread uint64  last_sample            = 0;
+__thread int     last_sample_generation = 0;
+
+//-----------------------------------------------------------------------------
+double
+coarse_seconds()
+{
+    timespec now;
+#ifdef CLOCK_MONOTONIC_COARSE
+    // served from the vdso at tick resolution, about the cost of a load
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+    return (double) now.tv_sec + (double) now.tv_nsec / 1000000000.0;
+}
+
+//-----------------------------------------------------------------------------
+void
+raise_peak(volatile int64 &peak, int64 value)
+{
+    int64 current = peak;
+    while(value > current)
+    {
+        int64 seen = __sync_val_compare_and_swap(&peak, current, value);
+        if(seen == current)
+        {
+            return;
+        }
+        current = seen;
+    }
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// static members
+//-----------------------------------------------------------------------------
+volatile int64 MemoryTracker::s_tracked_bytes = 0;
+volatile int64 MemoryTracker::s_tracked_peak  = 0;
+
+//-----------------------------------------------------------------------------
+uint64
+MemoryTracker::ResidentBytes()
+{
+    int fd = __atomic_load_n(&statm_fd, __ATOMIC_ACQUIRE);
+    if(fd == -1)
+    {
+        __atomic_store_n(&page_bytes, sysconf(_SC_PAGESIZE), __ATOMIC_RELAXED);
+        int new_fd = open("/proc/self/statm", O_RDONLY);
+        // another thread may have beaten us to it
+        if(!__sync_bool_compare_and_swap(&statm_fd, 
+                                         -1,
+                                         new_fd < 0 ? -2 : new_fd) &&
+           new_fd >= 0)
+        {
+            close(new_fd);
+        }
+        fd = __atomic_load_n(&statm_fd, __ATOMIC_ACQUIRE);
+    }
+
+    if(fd < 0)
+    {
+        return 0;
+    }
+
+    // "size resident shared text lib data dt", in pages
+    char buffer[128];
+    ssize_t num_read = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if(num_read <= 0)
+    {
+        return 0;
+    }
+    buffer[num_read] = '\0';
+
+    char *resident = buffer;
+    strtoull(buffer, &resident, 10);
+    return (uint64) strtoull(resident, NULL, 10) * 
+           (uint64) __atomic_load_n(&page_bytes, __ATOMIC_RELAXED);
+}
+
+//-----------------------------------------------------------------------------
+uint64
+MemoryTracker::SampleResidentBytes()
+{
+    double interval = 0.0;
+    __atomic_load(&sample_interval, &interval, __ATOMIC_RELAXED);
+    if(interval <= 0.0)
+    {
+        return ResidentBytes();
+    }
+
+    int generation = __atomic_load_n(&sample_generation, __ATOMIC_RELAXED);
+    double now = coarse_seconds();
+    if(last_sample_time < 0.0 || 
+       last_sample_generation != generation ||
+       now - last_sample_time >= interval)
+    {
+        last_sample            = ResidentBytes();
+        last_sample_time       = now;
+        last_sample_generation = generation;
+    }
+    return last_sample;
+}
+
+//-----------------------------------------------------------------------------
+void
+MemoryTracker::SetSampleInterval(double seconds)
+{
+    __atomic_store(&sample_interval, &seconds, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sample_generation, 1, __ATOMIC_RELAXED);
+}
+
+//-----------------------------------------------------------------------------
+double
+MemoryTracker::SampleInterval()
+{
+    double interval = 0.0;
+    __atomic_load(&sample_interval, &interval, __ATOMIC_RELAXED);
+    return interval;
+}
+
+//-----------------------------------------------------------------------------
+void *
+MemoryTracker::Allocate(size_t num_bytes)
+{
+    char *block = (char *) malloc(num_bytes + ALLOCATION_HEADER);
+    if(block == NULL)
+    {
+        return NULL;
+    }
+    *((size_t *) block) = num_bytes;
+    Track((int64) num_bytes);
+    return block + ALLOCATION_HEADER;
+}
+
+//-----------------------------------------------------------------------------
+void
+MemoryTracker::Free(void *ptr)
+{
+    if(ptr == NULL)
+    {
+        return;
+    }
+    char *block = ((char *) ptr) - ALLOCATION_HEADER;
+    Track(-(int64) *((size_t *) block));
+    free(block);
+}
+
+//-----------------------------------------------------------------------------
+void
+MemoryTracker::Track(int64 num_bytes)
+{
+    int64 tracked = __sync_add_and_fetch(&s_tracked_bytes, num_bytes);
+    raise_peak(s_tracked_peak, tracked);
+}
+
+//-----------------------------------------------------------------------------
+uint64
+MemoryTracker::TrackedBytes()
+{
+    int64 tracked = s_tracked_bytes;
+    return tracked > 0 ? (uint64) tracked : 0;
+}
+
+//-----------------------------------------------------------------------------
+uint64
+MemoryTracker::TrackedPeakBytes()
+{
+    return (uint64) s_tracked_peak;
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
@@ -0,0 +1,109 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_memory_tracker.hpp
+///
+//-----------------------------------------------------------------------------
+#ifndef STRAWMAN_MEMORY_TRACKER_HPP
+#define STRAWMAN_MEMORY_TRACKER_HPP
+
+#include <conduit.hpp>
+#include <cstddef>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+/// Cheap memory accounting for the timers and metrics.
+///
+/// The resident set size is read from /proc/self/statm through a file
+/// descriptor that is opened once, one pread per reading. With a sample 
+/// interval set, readings younger than the interval are reused.
+///
+/// Strawman's own large buffers (canvases, converted arrays, png buffers)
+/// are counted either by allocating them here or, for buffers another 
+/// library allocates, by reporting their size with Track().
+//-----------------------------------------------------------------------------
+class MemoryTracker
+{
+public:
+    // resident set size of the process in bytes, 0 if unknown
+    static conduit::uint64 ResidentBytes();
+    // ResidentBytes(), or the calling thread's last reading if it is 
+    // younger than the sample interval
+    static conduit::uint64 SampleResidentBytes();
+    // seconds, 0 (the default) reads on every sample
+    static void            SetSampleInterval(double seconds);
+    static double          SampleInterval();
+
+    // counted allocations, Free() takes what Allocate() returned
+    static void           *Allocate(size_t num_bytes);
+    static void            Free(void *ptr);
+    // counts (or with a negative size, uncounts) a buffer allocated 
+    // elsewhere
+    static void            Track(conduit::int64 num_bytes);
+
+    static conduit::uint64 TrackedBytes();
+    static conduit::uint64 TrackedPeakBytes();
+
+private:
+    static volatile conduit::int64  s_tracked_bytes;
+    static volatile conduit::int64  s_tracked_peak;
+};
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
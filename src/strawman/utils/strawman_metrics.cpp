@@ -0,0 +1,519 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_metrics.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_metrics.hpp"
+
+#include "strawman_block_timer.hpp"
+#include "strawman_logging.hpp"
+#include "strawman_memory_tracker.hpp"
+
+// standard includes
+#include <string.h>
+// unix only
+#include <sys/resource.h>
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+const size_t DEFAULT_HISTORY        = 1000;
+const size_t DEFAULT_FLUSH_INTERVAL = 100;
+
+//-----------------------------------------------------------------------------
+double
+seconds_between(const timespec &start, const timespec &end)
+{
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+//-----------------------------------------------------------------------------
+// peak resident set size of the process
+//-----------------------------------------------------------------------------
+double
+memory_high_water_mb()
+{
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0.0;
+    }
+    // linux reports kilobytes
+    return usage.ru_maxrss / 1024.0;
+}
+
+//-----------------------------------------------------------------------------
+// scope paths use '.' so they stay one key of a conduit tree
+//-----------------------------------------------------------------------------
+std::string
+stage_name(const std::string &scope_path)
+{
+    std::string res = scope_path;
+    for(size_t i = 0; i < res.size(); i++)
+    {
+        if(res[i] == '/')
+        {
+            res[i] = '.';
+        }
+    }
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+size_t
+option_count(const Node &options,
+             const std::string &name,
+             size_t default_value)
+{
+    if(!options.has_child(name))
+    {
+        return default_value;
+    }
+
+    int value = options[name].to_int();
+    return value < 1 ? 1 : (size_t) value;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// static members
+//-----------------------------------------------------------------------------
+std::vector<std::string> Metrics::s_counter_names;
+std::vector<double>      Metrics::s_counter_values;
+int                      Metrics::s_enabled = 0;
+
+//-----------------------------------------------------------------------------
+Metrics::Metrics()
+: m_enabled(false),
+  m_rank(0),
+  m_csv(false),
+  m_max_history(DEFAULT_HISTORY),
+  m_flush_interval(DEFAULT_FLUSH_INTERVAL),
+  m_cycle(0),
+  m_executes(0),
+  m_unflushed(0)
+{
+    m_enabled_at.tv_sec     = 0;
+    m_enabled_at.tv_nsec    = 0;
+    m_execute_start.tv_sec  = 0;
+    m_execute_start.tv_nsec = 0;
+}
+
+//-----------------------------------------------------------------------------
+Metrics::~Metrics()
+{
+    Disable();
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::Add(const char *name, double value)
+{
+    if(s_enabled == 0)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < s_counter_names.size(); i++)
+    {
+        if(strcmp(s_counter_names[i].c_str(), name) == 0)
+        {
+            s_counter_values[i] += value;
+            return;
+        }
+    }
+
+    s_counter_names.push_back(name);
+    s_counter_values.push_back(value);
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::Enable(const Node &options, int rank)
+{
+    if(m_enabled)
+    {
+        Disable();
+    }
+
+    m_rank           = rank;
+    m_max_history    = option_count(options, "history", DEFAULT_HISTORY);
+    m_flush_interval = option_count(options,
+                                    "flush_interval",
+                                    DEFAULT_FLUSH_INTERVAL);
+
+    std::string file_path = "strawman_metrics.jsonl";
+    if(options.has_child("file"))
+    {
+        file_path = options["file"].as_string();
+    }
+
+    bool all_ranks = options.has_child("all_ranks") &&
+                     options["all_ranks"].as_string() == "true";
+
+    m_csv = file_path.size() >= 4 &&
+            file_path.compare(file_path.size() - 4, 4, ".csv") == 0;
+
+    m_file_path.clear();
+    if(all_ranks)
+    {
+        // strawman_metrics.jsonl -> strawman_metrics_000003.jsonl
+        size_t ext = file_path.rfind('.');
+        if(ext == std::string::npos || 
+           file_path.find('/', ext) != std::string::npos)
+        {
+            ext = file_path.size();
+        }
+
+        char rank_suffix[32];
+        snprintf(rank_suffix, sizeof(rank_suffix), "_%06d", rank);
+        m_file_path = file_path.substr(0, ext) + 
+                      rank_suffix + 
+                      file_path.substr(ext);
+    }
+    else if(rank == 0)
+    {
+        m_file_path = file_path;
+    }
+
+    // start each run with a fresh file
+    if(!m_file_path.empty())
+    {
+        FILE *file = fopen(m_file_path.c_str(), "w");
+        if(file == NULL)
+        {
+            STRAWMAN_INFO("Metrics: cannot write \"" << m_file_path 
+                          << "\", snapshots are kept in memory only");
+            m_file_path.clear();
+        }
+        else
+        {
+            if(m_csv)
+            {
+                fprintf(file, "cycle,execute,rank,name,value\n");
+            }
+            fclose(file);
+        }
+    }
+
+    m_cycle     = 0;
+    m_executes  = 0;
+    m_unflushed = 0;
+    m_history.clear();
+    BlockTimer::ScopeTotals(m_last_totals);
+    clock_gettime(CLOCK_MONOTONIC, &m_enabled_at);
+    m_execute_start = m_enabled_at;
+
+    if(s_enabled == 0)
+    {
+        s_counter_names.clear();
+        s_counter_values.clear();
+    }
+    s_enabled++;
+    m_enabled = true;
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::Disable()
+{
+    if(!m_enabled)
+    {
+        return;
+    }
+
+    Flush();
+    m_history.clear();
+    m_last_totals.clear();
+    m_enabled = false;
+    s_enabled--;
+}
+
+//-----------------------------------------------------------------------------
+bool
+Metrics::Enabled() const
+{
+    return m_enabled;
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::BeginExecute(int64 cycle)
+{
+    if(!m_enabled)
+    {
+        return;
+    }
+
+    m_cycle = cycle;
+    clock_gettime(CLOCK_MONOTONIC, &m_execute_start);
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::EndExecute()
+{
+    if(!m_enabled)
+    {
+        return;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    m_history.push_back(Snapshot());
+    Snapshot &snapshot = m_history.back();
+    snapshot.m_cycle      = m_cycle;
+    snapshot.m_execute    = m_executes++;
+    snapshot.m_time       = seconds_between(m_enabled_at, now);
+    snapshot.m_seconds    = seconds_between(m_execute_start, now);
+    snapshot.m_memory_hwm = memory_high_water_mb();
+    snapshot.m_tracked_peak = MemoryTracker::TrackedPeakBytes() / 
+                              (1024.0 * 1024.0);
+
+    // time each scope gained since the last snapshot
+    std::map<std::string, double> totals;
+    BlockTimer::ScopeTotals(totals);
+    std::map<std::string, double>::const_iterator it;
+    for(it = totals.begin(); it != totals.end(); ++it)
+    {
+        double delta = it->second;
+        std::map<std::string, double>::const_iterator last;
+        last = m_last_totals.find(it->first);
+        if(last != m_last_totals.end())
+        {
+            delta -= last->second;
+        }
+
+        if(delta > 0.0)
+        {
+            snapshot.m_stages[stage_name(it->first)] = delta;
+        }
+    }
+    m_last_totals.swap(totals);
+
+    for(size_t i = 0; i < s_counter_names.size(); i++)
+    {
+        snapshot.m_counters[s_counter_names[i]] = s_counter_values[i];
+        s_counter_values[i] = 0.0;
+    }
+
+    if(m_history.size() > m_max_history)
+    {
+        m_history.pop_front();
+    }
+    m_unflushed++;
+
+    // flush before an unwritten snapshot would fall out of the history
+    if(m_unflushed >= m_flush_interval || m_unflushed >= m_max_history)
+    {
+        Flush();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::Flush()
+{
+    if(m_unflushed == 0)
+    {
+        return;
+    }
+
+    if(m_file_path.empty())
+    {
+        m_unflushed = 0;
+        return;
+    }
+
+    FILE *file = fopen(m_file_path.c_str(), "a");
+    if(file == NULL)
+    {
+        STRAWMAN_INFO("Metrics: cannot append to \"" << m_file_path << "\"");
+        m_unflushed = 0;
+        return;
+    }
+
+    for(size_t i = m_history.size() - m_unflushed; i < m_history.size(); i++)
+    {
+        if(m_csv)
+        {
+            WriteCSV(file, m_history[i]);
+        }
+        else
+        {
+            WriteJSON(file, m_history[i]);
+        }
+    }
+
+    fclose(file);
+    m_unflushed = 0;
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::Last(Node &snapshot) const
+{
+    snapshot.reset();
+    if(m_history.empty())
+    {
+        return;
+    }
+
+    const Snapshot &last = m_history.back();
+    snapshot["cycle"]         = last.m_cycle;
+    snapshot["execute"]       = last.m_execute;
+    snapshot["rank"]          = m_rank;
+    snapshot["time"]          = last.m_time;
+    snapshot["seconds"]       = last.m_seconds;
+    snapshot["memory_hwm_mb"] = last.m_memory_hwm;
+    snapshot["tracked_peak_mb"] = last.m_tracked_peak;
+
+    std::map<std::string, double>::const_iterator it;
+    for(it = last.m_stages.begin(); it != last.m_stages.end(); ++it)
+    {
+        snapshot["stages"][it->first] = it->second;
+    }
+    for(it = last.m_counters.begin(); it != last.m_counters.end(); ++it)
+    {
+        snapshot["counters"][it->first] = it->second;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::WriteJSON(FILE *file, const Snapshot &snapshot) const
+{
+    fprintf(file,
+            "{\"cycle\": %lld, \"execute\": %d, \"rank\": %d, "
+            "\"time\": %.9g, \"seconds\": %.9g, \"memory_hwm_mb\": %.9g, "
+            "\"tracked_peak_mb\": %.9g",
+            (long long) snapshot.m_cycle,
+            snapshot.m_execute,
+            m_rank,
+            snapshot.m_time,
+            snapshot.m_seconds,
+            snapshot.m_memory_hwm,
+            snapshot.m_tracked_peak);
+
+    // timer and counter names are identifiers, nothing to escape
+    std::map<std::string, double>::const_iterator it;
+    fprintf(file, ", \"stages\": {");
+    for(it = snapshot.m_stages.begin(); it != snapshot.m_stages.end(); ++it)
+    {
+        fprintf(file, "%s\"%s\": %.9g",
+                it == snapshot.m_stages.begin() ? "" : ", ",
+                it->first.c_str(),
+                it->second);
+    }
+    fprintf(file, "}, \"counters\": {");
+    for(it = snapshot.m_counters.begin(); 
+        it != snapshot.m_counters.end(); 
+        ++it)
+    {
+        fprintf(file, "%s\"%s\": %.9g",
+                it == snapshot.m_counters.begin() ? "" : ", ",
+                it->first.c_str(),
+                it->second);
+    }
+    fprintf(file, "}}\n");
+}
+
+//-----------------------------------------------------------------------------
+void
+Metrics::WriteCSV(FILE *file, const Snapshot &snapshot) const
+{
+    // one row per value keeps the columns fixed as scopes come and go
+    long long cycle = (long long) snapshot.m_cycle;
+    int execute = snapshot.m_execute;
+
+    fprintf(file, "%lld,%d,%d,time,%.9g\n", 
+            cycle, execute, m_rank, snapshot.m_time);
+    fprintf(file, "%lld,%d,%d,seconds,%.9g\n",
+            cycle, execute, m_rank, snapshot.m_seconds);
+    fprintf(file, "%lld,%d,%d,memory_hwm_mb,%.9g\n",
+            cycle, execute, m_rank, snapshot.m_memory_hwm);
+    fprintf(file, "%lld,%d,%d,tracked_peak_mb,%.9g\n",
+            cycle, execute, m_rank, snapshot.m_tracked_peak);
+
+    std::map<std::string, double>::const_iterator it;
+    for(it = snapshot.m_stages.begin(); it != snapshot.m_stages.end(); ++it)
+    {
+        fprintf(file, "%lld,%d,%d,stages/%s,%.9g\n",
+                cycle, execute, m_rank, it->first.c_str(), it->second);
+    }
+    for(it = snapshot.m_counters.begin(); 
+        it != snapshot.m_counters.end(); 
+        ++it)
+    {
+        fprintf(file, "%lld,%d,%d,counters/%s,%.9g\n",
+                cycle, execute, m_rank, it->first.c_str(), it->second);
+    }
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
@@ -0,0 +1,160 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_metrics.hpp
+///
+//-----------------------------------------------------------------------------
+#ifndef STRAWMAN_METRICS_HPP
+#define STRAWMAN_METRICS_HPP
+
+#include <conduit.hpp>
+#include <stdio.h>
+#include <time.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+/// Per Execute snapshots of what visualization cost, so it can be lined up
+/// with the simulation cycle. A snapshot holds the wall time of the 
+/// Execute, the seconds each timed scope gained since the last snapshot,
+/// the counters added with Metrics::Add() since then (for example bytes
+/// converted or pixels composited), the memory high-water mark of the 
+/// process and the peak of Strawman's own tracked buffers.
+///
+/// The last snapshots are kept in memory and appended to a json-lines 
+/// (one object per line) or csv (cycle,execute,name,value rows) file 
+/// every few snapshots.
+//-----------------------------------------------------------------------------
+class Metrics
+{
+public:
+    Metrics();
+    ~Metrics();
+
+    // adds value to the named counter of the next snapshot, a no-op 
+    // unless some Metrics is enabled
+    static void Add(const char *name, double value);
+
+    // options: file, history, flush_interval and all_ranks. only rank 0
+    // writes unless all_ranks is "true", then each rank writes its own 
+    // file.
+    void        Enable(const conduit::Node &options, int rank);
+    // flushes and stops taking snapshots
+    void        Disable();
+    bool        Enabled() const;
+
+    void        BeginExecute(conduit::int64 cycle);
+    // takes the snapshot and flushes if flush_interval are pending
+    void        EndExecute();
+    // appends the snapshots not written yet to the file
+    void        Flush();
+
+    // the latest snapshot, empty if there is none
+    void        Last(conduit::Node &snapshot) const;
+
+private:
+    Metrics(const Metrics &);
+    Metrics &operator=(const Metrics &);
+
+    struct Snapshot
+    {
+        conduit::int64                 m_cycle;
+        int                            m_execute;
+        // seconds since Enable()
+        double                         m_time;
+        double                         m_seconds;
+        double                         m_memory_hwm;
+        double                         m_tracked_peak;
+        std::map<std::string, double>  m_stages;
+        std::map<std::string, double>  m_counters;
+    };
+
+    void        WriteJSON(FILE *file, const Snapshot &snapshot) const;
+    void        WriteCSV(FILE *file, const Snapshot &snapshot) const;
+
+    bool                           m_enabled;
+    int                            m_rank;
+    // empty when this rank doesn't write
+    std::string                    m_file_path;
+    bool                           m_csv;
+    size_t                         m_max_history;
+    size_t                         m_flush_interval;
+
+    conduit::int64                 m_cycle;
+    int                            m_executes;
+    timespec                       m_enabled_at;
+    timespec                       m_execute_start;
+
+    std::deque<Snapshot>           m_history;
+    // the newest m_unflushed snapshots of the history are not written
+    size_t                         m_unflushed;
+    // scope totals at the last snapshot
+    std::map<std::string, double>  m_last_totals;
+
+    // counters since the last snapshot
+    static std::vector<std::string>  s_counter_names;
+    static std::vector<double>       s_counter_values;
+    static int                       s_enabled;
+};
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
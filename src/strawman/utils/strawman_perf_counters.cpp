@@ -0,0 +1,304 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_perf_counters.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_perf_counters.hpp"
+
+#include "strawman_logging.hpp"
+
+// standard includes
+#include <errno.h>
+#include <string.h>
+// linux only
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+const char *COUNTER_NAMES[PerfCounters::NUM_COUNTERS] = {"cycles",
+                                                         "instructions",
+                                                         "llc_misses",
+                                                         "branch_misses"};
+
+// bumped by Enable() and Disable(), so threads notice their groups are 
+// stale
+volatile int generation = 0;
+volatile int enabled    = 0;
+// warn once per process that counters are unavailable
+volatile int warned     = 0;
+
+//-----------------------------------------------------------------------------
+// the perf group of one thread
+//-----------------------------------------------------------------------------
+struct ThreadGroup
+{
+    int m_generation;
+    int m_fds[PerfCounters::NUM_COUNTERS];
+    // position of each counter in a group read, -1 if it didn't open
+    int m_slots[PerfCounters::NUM_COUNTERS];
+    int m_num_open;
+    int m_mask;
+};
+
+__thread ThreadGroup thread_group = {-1, {-1, -1, -1, -1}, 
+                                     {-1, -1, -1, -1}, 0, 0};
+
+#ifdef __linux__
+//-----------------------------------------------------------------------------
+int
+open_counter(int counter, int group_fd)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.disabled       = group_fd < 0 ? 1 : 0;
+    // user space only works with perf_event_paranoid up to 2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | 
+                          PERF_FORMAT_TOTAL_TIME_ENABLED |
+                          PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch(counter)
+    {
+        case PerfCounters::CYCLES:
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfCounters::INSTRUCTIONS:
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfCounters::LLC_MISSES:
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        default:
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+    }
+
+    // this thread, any cpu
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+void
+close_group(ThreadGroup &group)
+{
+    for(int i = 0; i < PerfCounters::NUM_COUNTERS; i++)
+    {
+#ifdef __linux__
+        if(group.m_fds[i] >= 0)
+        {
+            close(group.m_fds[i]);
+        }
+#endif
+        group.m_fds[i]   = -1;
+        group.m_slots[i] = -1;
+    }
+    group.m_num_open = 0;
+    group.m_mask     = 0;
+}
+
+//-----------------------------------------------------------------------------
+void
+open_group(ThreadGroup &group)
+{
+    close_group(group);
+#ifdef __linux__
+    int leader = -1;
+    int error  = 0;
+    for(int i = 0; i < PerfCounters::NUM_COUNTERS; i++)
+    {
+        int fd = open_counter(i, leader);
+        if(fd < 0)
+        {
+            error = errno;
+            continue;
+        }
+
+        if(leader < 0)
+        {
+            leader = fd;
+        }
+        group.m_fds[i]   = fd;
+        group.m_slots[i] = group.m_num_open++;
+        group.m_mask    |= 1 << i;
+    }
+
+    if(leader >= 0)
+    {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    if(group.m_mask != (1 << PerfCounters::NUM_COUNTERS) - 1 &&
+       __sync_bool_compare_and_swap(&warned, 0, 1))
+    {
+        STRAWMAN_INFO("Hardware counters unavailable ("
+                      << strerror(error) << "), timing without "
+                      << (group.m_mask == 0 ? "them" : "some of them")
+                      << ". See /proc/sys/kernel/perf_event_paranoid.");
+    }
+#endif
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+void
+PerfCounters::Enable()
+{
+    __sync_add_and_fetch(&generation, 1);
+    enabled = 1;
+}
+
+//-----------------------------------------------------------------------------
+void
+PerfCounters::Disable()
+{
+    enabled = 0;
+    __sync_add_and_fetch(&generation, 1);
+    close_group(thread_group);
+}
+
+//-----------------------------------------------------------------------------
+bool
+PerfCounters::Enabled()
+{
+    return enabled != 0;
+}
+
+//-----------------------------------------------------------------------------
+int
+PerfCounters::Read(uint64 values[NUM_COUNTERS])
+{
+    ThreadGroup &group = thread_group;
+    if(group.m_generation != generation)
+    {
+        group.m_generation = generation;
+        if(enabled)
+        {
+            open_group(group);
+        }
+        else
+        {
+            close_group(group);
+        }
+    }
+
+    if(group.m_mask == 0)
+    {
+        return 0;
+    }
+
+#ifdef __linux__
+    // nr, time enabled, time running, then one value per open counter
+    uint64 buffer[3 + NUM_COUNTERS];
+    int leader = group.m_fds[0];
+    for(int i = 0; leader < 0 && i < NUM_COUNTERS; i++)
+    {
+        leader = group.m_fds[i];
+    }
+
+    ssize_t num_read = read(leader, buffer, sizeof(buffer));
+    if(num_read < (ssize_t)(3 * sizeof(uint64)))
+    {
+        return 0;
+    }
+
+    double scale = 1.0;
+    if(buffer[2] > 0 && buffer[2] < buffer[1])
+    {
+        scale = (double) buffer[1] / (double) buffer[2];
+    }
+
+    for(int i = 0; i < NUM_COUNTERS; i++)
+    {
+        int slot = group.m_slots[i];
+        values[i] = slot < 0 ? 0 : (uint64)(buffer[3 + slot] * scale);
+    }
+    return group.m_mask;
+#else
+    (void) values;
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+const char *
+PerfCounters::Name(int counter)
+{
+    return COUNTER_NAMES[counter];
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
@@ -50,7 +50,9 @@
 
 #include "strawman_png_encoder.hpp"
 
+#include "strawman_block_timer.hpp"
 #include "strawman_logging.hpp"
+#include "strawman_memory_tracker.hpp"
 
 // standard includes
 #include <stdlib.h>
@@ -69,7 +71,9 @@ namespace strawman
 //-----------------------------------------------------------------------------
 PNGEncoder::PNGEncoder()
 :m_buffer(NULL),
- m_buffer_size(0)
+ m_buffer_size(0),
+ m_width(0),
+ m_height(0)
 {}
   
 //-----------------------------------------------------------------------------
@@ -84,14 +88,17 @@ PNGEncoder::Encode(const unsigned char *rgba_in,
                    const int width,
                    const int height)
 {
+    // also runs on the web interface's thread
+    STRAWMAN_BLOCK_TIMER(PNG_ENCODE);
     Cleanup();
 
     // upside down relative to what lodepng wants
-    unsigned char *rgba_flip = new unsigned char[width * height *4];
+    unsigned char *rgba_flip = (unsigned char *)
+        MemoryTracker::Allocate(width * height * 4);
 
     for (int y=0; y<height; ++y)
     {
-        memcpy(&(rgba_flip[y*height*4]),
+        memcpy(&(rgba_flip[y*width*4]),
                &(rgba_in[(height-y-1)*width*4]),
                width*4);
     }
@@ -104,12 +111,22 @@ PNGEncoder::Encode(const unsigned char *rgba_in,
                                             LCT_RGBA, // these settings match those for 
                                             8);       // lodepng_encode32_file
 
-    delete [] rgba_flip;
+    MemoryTracker::Free(rgba_flip);
+
+    if(m_buffer != NULL)
+    {
+        MemoryTracker::Track((conduit::int64) m_buffer_size);
+    }
     
     if(error)
     {
         STRAWMAN_WARN("lodepng_encode_memory failed")
     }
+    else
+    {
+        m_width  = width;
+        m_height = height;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -118,10 +135,12 @@ PNGEncoder::Encode(const float *rgba_in,
                    const int width,
                    const int height)
 {
+    STRAWMAN_BLOCK_TIMER(PNG_ENCODE);
     Cleanup();
 
     // upside down relative to what lodepng wants
-    unsigned char *rgba_flip = new unsigned char[width * height *4];
+    unsigned char *rgba_flip = (unsigned char *)
+        MemoryTracker::Allocate(width * height * 4);
 
 
     for(int x = 0; x < width; ++x)
@@ -147,12 +166,22 @@ PNGEncoder::Encode(const float *rgba_in,
                                             LCT_RGBA, // these settings match those for 
                                             8);       // lodepng_encode32_file
 
-    delete [] rgba_flip;
+    MemoryTracker::Free(rgba_flip);
+
+    if(m_buffer != NULL)
+    {
+        MemoryTracker::Track((conduit::int64) m_buffer_size);
+    }
     
     if(error)
     {
         STRAWMAN_WARN("lodepng_encode_memory failed")
     }
+    else
+    {
+        m_width  = width;
+        m_height = height;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -190,28 +219,17 @@ PNGEncoder::PngBufferSize()
 }
 
 //-----------------------------------------------------------------------------
-void 
-PNGEncoder::Base64Encode()
+int
+PNGEncoder::Width()
 {
-    if(m_buffer == NULL)
-    {
-        STRAWMAN_WARN("base64_encode must be called after encode()")
-        return;
-    }
-
-    // base64 encode the raw png data
-    m_base64_data.set(DataType::char8_str(m_buffer_size*2));
-    utils::base64_encode(m_buffer,
-                         m_buffer_size,
-                         m_base64_data.data_ptr());
+    return m_width;
 }
 
-
 //-----------------------------------------------------------------------------
-Node &
-PNGEncoder::Base64Node()
+int
+PNGEncoder::Height()
 {
-    return m_base64_data;
+    return m_height;
 }
 
 //-----------------------------------------------------------------------------
@@ -224,9 +242,12 @@ PNGEncoder::Cleanup()
         // ^-- Not found even if LODEPNG_COMPILE_ALLOCATORS is defined?
         // simply use "free"
         free(m_buffer);
+        MemoryTracker::Track(-(conduit::int64) m_buffer_size);
         m_buffer = NULL;
         m_buffer_size = 0;
     }
+    m_width  = 0;
+    m_height = 0;
 }
 
 
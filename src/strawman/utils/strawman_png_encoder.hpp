@@ -75,16 +75,17 @@ public:
 
     void          *PngBuffer();
     size_t         PngBufferSize();
+    // dims of the last encoded image
+    int            Width();
+    int            Height();
 
-    void           Base64Encode();
-    conduit::Node &Base64Node();
-    
     void           Cleanup();
     
 private:
     unsigned char *m_buffer;
     size_t         m_buffer_size;
-    conduit::Node  m_base64_data;
+    int            m_width;
+    int            m_height;
 };
 
 //-----------------------------------------------------------------------------
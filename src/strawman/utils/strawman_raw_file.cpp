@@ -0,0 +1,420 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_raw_file.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_raw_file.hpp"
+
+#include "strawman_file_system.hpp"
+#include "strawman_logging.hpp"
+
+// standard includes
+#include <sstream>
+#include <utility>
+#include <vector>
+// unix only
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+const char *RAW_FILE_MAGIC   = "strawman_raw";
+const int   RAW_FILE_VERSION = 1;
+// alignment of leaves smaller than a page, enough for any element type
+const index_t RAW_FILE_MIN_ALIGN = 8;
+// the header line is short, anything longer isn't a raw file
+const size_t  RAW_FILE_MAX_HEADER_LINE = 256;
+
+//-----------------------------------------------------------------------------
+index_t
+page_size()
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (index_t) size : 4096;
+}
+
+//-----------------------------------------------------------------------------
+index_t
+round_up(index_t value, index_t align)
+{
+    return ((value + align - 1) / align) * align;
+}
+
+//-----------------------------------------------------------------------------
+void
+write_json_name(const std::string &name, std::ostringstream &oss)
+{
+    oss << "\"";
+    for(size_t i = 0; i < name.size(); ++i)
+    {
+        if(name[i] == '"' || name[i] == '\\')
+        {
+            oss << "\\";
+        }
+        oss << name[i];
+    }
+    oss << "\"";
+}
+
+//-----------------------------------------------------------------------------
+// appends the json schema of node to oss, placing each leaf after the
+// ones before it. leaves of a page or more start on a page boundary, 
+// so they can be mapped on their own.
+//-----------------------------------------------------------------------------
+void
+raw_schema(const Node &node,
+           index_t page,
+           index_t &data_bytes,
+           std::vector<std::pair<const Node*, index_t> > &leaves,
+           std::ostringstream &oss)
+{
+    const DataType &dtype = node.dtype();
+
+    if(dtype.is_object() || dtype.is_list())
+    {
+        bool object = dtype.is_object();
+        oss << (object ? "{" : "[");
+        NodeConstIterator itr = node.children();
+        bool first = true;
+        while(itr.has_next())
+        {
+            const Node &child = itr.next();
+            if(!first)
+            {
+                oss << ",";
+            }
+            first = false;
+            if(object)
+            {
+                write_json_name(itr.name(), oss);
+                oss << ":";
+            }
+            raw_schema(child, page, data_bytes, leaves, oss);
+        }
+        oss << (object ? "}" : "]");
+    }
+    else if(dtype.is_empty())
+    {
+        oss << "{\"dtype\":\"empty\"}";
+    }
+    else
+    {
+        index_t num_bytes = dtype.bytes_compact();
+        index_t offset = round_up(data_bytes, 
+                                  num_bytes >= page ? page 
+                                                    : RAW_FILE_MIN_ALIGN);
+
+        index_t endianness = dtype.endianness();
+        if(endianness == Endianness::DEFAULT_ID)
+        {
+            endianness = Endianness::machine_default();
+        }
+
+        oss << "{\"dtype\":\""            << dtype.name() << "\""
+            << ",\"number_of_elements\":" << dtype.number_of_elements()
+            << ",\"offset\":"             << offset
+            << ",\"stride\":"             << dtype.element_bytes()
+            << ",\"element_bytes\":"      << dtype.element_bytes()
+            << ",\"endianness\":\""       
+            << Endianness::id_to_name(endianness) << "\"}";
+
+        leaves.push_back(std::make_pair(&node, offset));
+        data_bytes = offset + num_bytes;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+write_all(int fd, const void *ptr, size_t num_bytes, off_t offset)
+{
+    const char *bytes = (const char *) ptr;
+    while(num_bytes > 0)
+    {
+        ssize_t res = pwrite(fd, bytes, num_bytes, offset);
+        if(res < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(res <= 0)
+        {
+            return false;
+        }
+        bytes     += res;
+        num_bytes -= (size_t) res;
+        offset    += (off_t) res;
+    }
+    return true;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+RawFile::RawFile()
+: m_map(NULL),
+  m_map_bytes(0)
+{}
+
+//-----------------------------------------------------------------------------
+RawFile::~RawFile()
+{
+    Close();
+}
+
+//-----------------------------------------------------------------------------
+void
+RawFile::Write(const Node &data, const std::string &file_path)
+{
+    index_t page = page_size();
+
+    std::ostringstream oss;
+    index_t data_bytes = 0;
+    std::vector<std::pair<const Node*, index_t> > leaves;
+    raw_schema(data, page, data_bytes, leaves, oss);
+    std::string schema = oss.str();
+
+    // the length of the header line depends on the data offset it holds
+    index_t data_offset = page;
+    std::string header;
+    while(true)
+    {
+        oss.str("");
+        oss << RAW_FILE_MAGIC   << " "
+            << RAW_FILE_VERSION << " "
+            << schema.size()    << " "
+            << data_offset      << " "
+            << data_bytes       << "\n";
+        header = oss.str() + schema;
+        if((index_t) header.size() <= data_offset)
+        {
+            break;
+        }
+        data_offset += page;
+    }
+
+    int fd = open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    // we only create the file's directory when the file can't be created
+    // without it, so the common case costs no extra metadata operations
+    if(fd < 0 && errno == ENOENT && create_file_directory(file_path))
+    {
+        fd = open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    if(fd < 0)
+    {
+        STRAWMAN_ERROR("Error: failed to create file " << file_path);
+    }
+
+    bool ok = write_all(fd, header.c_str(), header.size(), 0);
+
+    for(size_t i = 0; ok && i < leaves.size(); ++i)
+    {
+        const Node &leaf = *leaves[i].first;
+        off_t offset = (off_t) (data_offset + leaves[i].second);
+        index_t num_bytes = leaf.dtype().bytes_compact();
+        if(num_bytes == 0)
+        {
+            continue;
+        }
+
+        if(leaf.is_compact())
+        {
+            ok = write_all(fd, leaf.element_ptr(0), num_bytes, offset);
+        }
+        else
+        {
+            Node compact;
+            leaf.compact_to(compact);
+            ok = write_all(fd, compact.data_ptr(), num_bytes, offset);
+        }
+    }
+
+    // leaves are written out of order with gaps between them, make sure
+    // the file spans the whole data section
+    if(ok)
+    {
+        ok = ftruncate(fd, (off_t) (data_offset + data_bytes)) == 0;
+    }
+
+    if(close(fd) != 0)
+    {
+        ok = false;
+    }
+
+    if(!ok)
+    {
+        STRAWMAN_ERROR("Error: failed to write file " << file_path);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+RawFile::Open(const std::string &file_path)
+{
+    Close();
+
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        STRAWMAN_ERROR("Error: failed to open file " << file_path);
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        STRAWMAN_ERROR("Error: " << file_path << " is not a raw blueprint file");
+    }
+
+    size_t num_bytes = (size_t) st.st_size;
+    // private, so writes to the tree never reach the file
+    void *map = mmap(NULL, 
+                     num_bytes,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE,
+                     fd,
+                     0);
+    close(fd);
+
+    if(map == MAP_FAILED)
+    {
+        STRAWMAN_ERROR("Error: failed to map file " << file_path);
+    }
+
+    m_map       = map;
+    m_map_bytes = num_bytes;
+
+    const char *bytes = (const char *) m_map;
+
+    size_t line_end = 0;
+    while(line_end < num_bytes &&
+          line_end < RAW_FILE_MAX_HEADER_LINE &&
+          bytes[line_end] != '\n')
+    {
+        ++line_end;
+    }
+
+    std::string magic;
+    int         version = 0;
+    index_t     schema_bytes = 0;
+    index_t     data_offset  = 0;
+    index_t     data_bytes   = 0;
+
+    if(line_end < num_bytes && bytes[line_end] == '\n')
+    {
+        std::istringstream iss(std::string(bytes, line_end));
+        iss >> magic >> version >> schema_bytes >> data_offset >> data_bytes;
+    }
+
+    // a truncated file fails the size checks
+    if(magic != RAW_FILE_MAGIC ||
+       version != RAW_FILE_VERSION ||
+       line_end + 1 + schema_bytes > data_offset ||
+       data_offset + data_bytes > num_bytes)
+    {
+        Close();
+        STRAWMAN_ERROR("Error: " << file_path << " is not a raw blueprint file"
+                       " or is truncated");
+    }
+
+    try
+    {
+        Schema schema(std::string(bytes + line_end + 1, schema_bytes));
+        m_data.set_external(schema, (char *) m_map + data_offset);
+    }
+    catch(...)
+    {
+        Close();
+        throw;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+RawFile::Close()
+{
+    m_data.reset();
+    if(m_map != NULL)
+    {
+        munmap(m_map, m_map_bytes);
+        m_map       = NULL;
+        m_map_bytes = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+Node &
+RawFile::Data()
+{
+    return m_data;
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
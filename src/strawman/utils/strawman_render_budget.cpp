@@ -0,0 +1,344 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_render_budget.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_render_budget.hpp"
+
+#include "strawman_logging.hpp"
+#include "strawman_metrics.hpp"
+
+// standard includes
+#include <float.h>
+#include <math.h>
+
+#ifdef PARALLEL
+#include <mpi.h>
+#endif
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+const double DEFAULT_MIN_SCALE = 0.25;
+
+// aim a bit under the budget, so small variations don't go over it
+const double TARGET_SHARE = 0.9;
+// hold the quality while rendering takes this much of what is available
+const double HOLD_SHARE   = 0.75;
+// largest change of the quality from one Execute to the next
+const double MIN_STEP     = 0.5;
+const double MAX_STEP     = 1.25;
+
+//-----------------------------------------------------------------------------
+double
+seconds_between(const timespec &start, const timespec &end)
+{
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+//-----------------------------------------------------------------------------
+double
+clamp(double value, double min_value, double max_value)
+{
+    return value < min_value ? min_value :
+           value > max_value ? max_value : value;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+RenderBudget::RenderBudget()
+: m_enabled(false),
+  m_seconds(0.0),
+  m_fraction(0.0),
+  m_min_scale(DEFAULT_MIN_SCALE),
+  m_scale(1.0),
+  m_mpi_comm(-1),
+  m_executed(false),
+  m_render_seconds(0.0),
+  m_volume(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+RenderBudget::~RenderBudget()
+{
+}
+
+//-----------------------------------------------------------------------------
+void
+RenderBudget::Enable(const Node &options)
+{
+    if(options.has_child("seconds"))
+    {
+        m_seconds = options["seconds"].to_float64();
+    }
+
+    if(options.has_child("fraction"))
+    {
+        m_fraction = options["fraction"].to_float64();
+    }
+
+    if(options.has_child("min_scale"))
+    {
+        m_min_scale = clamp(options["min_scale"].to_float64(), 0.01, 1.0);
+    }
+
+    if(m_seconds <= 0.0 && m_fraction <= 0.0)
+    {
+        STRAWMAN_ERROR("budget needs seconds and/or fraction");
+    }
+
+    m_enabled  = true;
+    m_scale    = 1.0;
+    m_executed = false;
+}
+
+//-----------------------------------------------------------------------------
+bool
+RenderBudget::Enabled() const
+{
+    return m_enabled;
+}
+
+//-----------------------------------------------------------------------------
+void
+RenderBudget::SetMPICommHandle(int mpi_comm)
+{
+    m_mpi_comm = mpi_comm;
+}
+
+//-----------------------------------------------------------------------------
+void
+RenderBudget::BeginExecute()
+{
+    if(!m_enabled)
+    {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &m_execute_start);
+    m_render_seconds = 0.0;
+    m_volume         = false;
+}
+
+//-----------------------------------------------------------------------------
+void
+RenderBudget::BeginRender()
+{
+    if(!m_enabled)
+    {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &m_render_start);
+}
+
+//-----------------------------------------------------------------------------
+void
+RenderBudget::EndRender(bool volume)
+{
+    if(!m_enabled)
+    {
+        return;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    m_render_seconds += seconds_between(m_render_start, now);
+    m_volume = m_volume || volume;
+}
+
+//-----------------------------------------------------------------------------
+void
+RenderBudget::EndExecute()
+{
+    if(!m_enabled)
+    {
+        return;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // the slowest rank decides, so all ranks pick the same image size
+    double times[4];
+    times[0] = seconds_between(m_execute_start, now);
+    times[1] = m_render_seconds;
+    times[2] = m_executed ? 
+               seconds_between(m_last_execute_start, m_execute_start) : 0.0;
+    times[3] = m_volume ? 1.0 : 0.0;
+    Reduce(times, 4);
+
+    double execute_seconds = times[0];
+    double render_seconds  = times[1];
+    double period          = times[2];
+    bool   volume          = times[3] > 0.0;
+
+    m_last_execute_start = m_execute_start;
+    m_executed = true;
+
+    double budget = DBL_MAX;
+    if(m_seconds > 0.0)
+    {
+        budget = m_seconds;
+    }
+
+    if(m_fraction > 0.0 && period > 0.0 && m_fraction * period < budget)
+    {
+        budget = m_fraction * period;
+    }
+
+    // nothing rendered, or no period to take a fraction of yet
+    if(budget == DBL_MAX || render_seconds <= 0.0)
+    {
+        return;
+    }
+
+    // only the render time scales with the quality, the rest is fixed
+    double fixed_seconds = execute_seconds - render_seconds;
+    double available = TARGET_SHARE * budget - fixed_seconds;
+
+    double step = MIN_STEP;
+    if(available > 0.0)
+    {
+        // surfaces cost about the pixels, volumes the pixels times the
+        // samples along each ray
+        double exponent = volume ? 3.0 : 2.0;
+        step = pow(available / render_seconds, 1.0 / exponent);
+
+        if(render_seconds <= available &&
+           render_seconds >= HOLD_SHARE * available)
+        {
+            step = 1.0;
+        }
+    }
+
+    m_scale = clamp(m_scale * clamp(step, MIN_STEP, MAX_STEP),
+                    m_min_scale,
+                    1.0);
+
+    int rank = 0;
+#ifdef PARALLEL
+    MPI_Comm mpi_comm = m_mpi_comm == -1 ? MPI_COMM_WORLD :
+                                           MPI_Comm_f2c(m_mpi_comm);
+    MPI_Comm_rank(mpi_comm, &rank);
+#endif
+
+    if(rank == 0)
+    {
+        STRAWMAN_INFO("Render budget: "
+                      << execute_seconds << " s (render "
+                      << render_seconds << " s) of "
+                      << budget << " s, next scale " << m_scale);
+    }
+
+    Metrics::Add("budget_seconds", budget);
+    Metrics::Add("budget_scale", m_scale);
+}
+
+//-----------------------------------------------------------------------------
+double
+RenderBudget::Scale() const
+{
+    return m_scale;
+}
+
+//-----------------------------------------------------------------------------
+int
+RenderBudget::Scale(int size, int min_size) const
+{
+    if(m_scale >= 1.0 || size <= min_size)
+    {
+        return size;
+    }
+
+    int scaled = (int)(size * m_scale + 0.5);
+    return scaled < min_size ? min_size : scaled;
+}
+
+//-----------------------------------------------------------------------------
+void
+RenderBudget::Reduce(double *values, int count) const
+{
+#ifdef PARALLEL
+    MPI_Comm mpi_comm = m_mpi_comm == -1 ? MPI_COMM_WORLD :
+                                           MPI_Comm_f2c(m_mpi_comm);
+    MPI_Allreduce(MPI_IN_PLACE,
+                  values,
+                  count,
+                  MPI_DOUBLE,
+                  MPI_MAX,
+                  mpi_comm);
+#else
+    (void) values;
+    (void) count;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
@@ -0,0 +1,132 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_render_budget.hpp
+///
+//-----------------------------------------------------------------------------
+#ifndef STRAWMAN_RENDER_BUDGET_HPP
+#define STRAWMAN_RENDER_BUDGET_HPP
+
+#include <conduit.hpp>
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+/// Keeps each Execute of a pipeline within a time budget by lowering the
+/// render quality (image resolution and volume samples) for the next 
+/// Execute when it runs over and raising it again when there is room.
+///
+/// The budget is budget/seconds per Execute, budget/fraction of the wall
+/// time since the previous Execute (the simulation's time step plus the
+/// last Execute), or the smaller of the two. The time spent outside of
+/// rendering counts against it but isn't scaled. The quality never goes
+/// below budget/min_scale or above what the actions ask for.
+//-----------------------------------------------------------------------------
+class RenderBudget
+{
+public:
+    RenderBudget();
+    ~RenderBudget();
+
+    // options: seconds, fraction and min_scale
+    void    Enable(const conduit::Node &options);
+    bool    Enabled() const;
+    // fortran handle of the communicator the ranks agree over, unused 
+    // in serial
+    void    SetMPICommHandle(int mpi_comm);
+
+    void    BeginExecute();
+    void    BeginRender();
+    // volume if any of the rendered plots was volume rendered
+    void    EndRender(bool volume);
+    // picks the quality of the next Execute from the slowest rank's 
+    // times and logs it. collective in the MPI case.
+    void    EndExecute();
+
+    // current quality, 1 is what the actions ask for
+    double  Scale() const;
+    // size at the current quality, no smaller than min_size unless size
+    // is smaller
+    int     Scale(int size, int min_size) const;
+
+private:
+    RenderBudget(const RenderBudget &);
+    RenderBudget &operator=(const RenderBudget &);
+
+    // max over the ranks, in place
+    void    Reduce(double *values, int count) const;
+
+    bool        m_enabled;
+    double      m_seconds;
+    double      m_fraction;
+    double      m_min_scale;
+    double      m_scale;
+    int         m_mpi_comm;
+
+    bool        m_executed;
+    timespec    m_last_execute_start;
+    timespec    m_execute_start;
+    timespec    m_render_start;
+    double      m_render_seconds;
+    bool        m_volume;
+};
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
+
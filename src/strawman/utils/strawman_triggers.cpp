@@ -0,0 +1,571 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_triggers.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_triggers.hpp"
+
+#include "strawman_action_plan.hpp"
+#include "strawman_logging.hpp"
+
+// standard includes
+#include <float.h>
+#include <string.h>
+
+#ifdef PARALLEL
+#include <mpi.h>
+#endif
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+// a time interval summed from time steps may come out a hair short
+const double TIME_TOLERANCE = 1e-9;
+
+// values each trigger adds to the reduction: wall seconds since it fired,
+// minus the field's min and the field's max, so one max reduces all three
+const int SLOT_WALL = 0;
+const int SLOT_NEG_MIN = 1;
+const int SLOT_MAX = 2;
+const int NUM_SLOTS = 3;
+
+// independent min / max lanes, enough for the compiler to keep them in 
+// vector registers
+const int SCAN_LANES = 8;
+
+//-----------------------------------------------------------------------------
+double
+seconds_between(const timespec &start, const timespec &end)
+{
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+//-----------------------------------------------------------------------------
+// min and max of num_values values of type T, stride bytes apart
+//-----------------------------------------------------------------------------
+template<typename T>
+void
+scan_min_max(const char *ptr,
+             index_t num_values,
+             index_t stride,
+             double &min_value,
+             double &max_value)
+{
+    T lo;
+    T hi;
+
+    if(stride == sizeof(T))
+    {
+        const T *values = (const T*) ptr;
+
+        T lanes_lo[SCAN_LANES];
+        T lanes_hi[SCAN_LANES];
+        for(int l = 0; l < SCAN_LANES; ++l)
+        {
+            lanes_lo[l] = values[0];
+            lanes_hi[l] = values[0];
+        }
+
+        index_t i = 0;
+        for(; i + SCAN_LANES <= num_values; i += SCAN_LANES)
+        {
+            for(int l = 0; l < SCAN_LANES; ++l)
+            {
+                T v = values[i + l];
+                lanes_lo[l] = v < lanes_lo[l] ? v : lanes_lo[l];
+                lanes_hi[l] = v > lanes_hi[l] ? v : lanes_hi[l];
+            }
+        }
+
+        lo = lanes_lo[0];
+        hi = lanes_hi[0];
+        for(int l = 1; l < SCAN_LANES; ++l)
+        {
+            lo = lanes_lo[l] < lo ? lanes_lo[l] : lo;
+            hi = lanes_hi[l] > hi ? lanes_hi[l] : hi;
+        }
+
+        for(; i < num_values; ++i)
+        {
+            lo = values[i] < lo ? values[i] : lo;
+            hi = values[i] > hi ? values[i] : hi;
+        }
+    }
+    else
+    {
+        memcpy(&lo, ptr, sizeof(T));
+        hi = lo;
+        for(index_t i = 1; i < num_values; ++i)
+        {
+            T v;
+            memcpy(&v, ptr + i * stride, sizeof(T));
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+    }
+
+    if((double) lo < min_value)
+    {
+        min_value = (double) lo;
+    }
+
+    if((double) hi > max_value)
+    {
+        max_value = (double) hi;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+leaf_min_max(const Node &leaf,
+             double &min_value,
+             double &max_value)
+{
+    const DataType &dtype = leaf.dtype();
+    index_t num_values = dtype.number_of_elements();
+    if(num_values == 0 || !dtype.is_number())
+    {
+        return false;
+    }
+
+    const char *ptr = (const char*) leaf.element_ptr(0);
+    index_t stride = dtype.stride();
+
+    if(dtype.is_float64())
+    {
+        scan_min_max<float64>(ptr, num_values, stride, min_value, max_value);
+    }
+    else if(dtype.is_float32())
+    {
+        scan_min_max<float32>(ptr, num_values, stride, min_value, max_value);
+    }
+    else if(dtype.is_int32())
+    {
+        scan_min_max<int32>(ptr, num_values, stride, min_value, max_value);
+    }
+    else if(dtype.is_int64())
+    {
+        scan_min_max<int64>(ptr, num_values, stride, min_value, max_value);
+    }
+    else
+    {
+        // uncommon field types pay for a conversion
+        Node n_values;
+        leaf.to_float64_array(n_values);
+        scan_min_max<float64>((const char*) n_values.as_float64_ptr(),
+                              num_values,
+                              sizeof(float64),
+                              min_value,
+                              max_value);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// min and max of all components of a field, false if this rank doesn't
+// have it
+//-----------------------------------------------------------------------------
+bool
+field_min_max(const Node *data,
+              const std::string &field_name,
+              double &min_value,
+              double &max_value)
+{
+    if(data == NULL ||
+       !data->has_child("fields") ||
+       !(*data)["fields"].has_child(field_name) ||
+       !(*data)["fields"][field_name].has_child("values"))
+    {
+        return false;
+    }
+
+    const Node &values = (*data)["fields"][field_name]["values"];
+    index_t num_components = values.number_of_children();
+    if(num_components == 0)
+    {
+        return leaf_min_max(values, min_value, max_value);
+    }
+
+    bool found = false;
+    for(index_t i = 0; i < num_components; ++i)
+    {
+        found = leaf_min_max(values.child(i), min_value, max_value) || found;
+    }
+    return found;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+Triggers::Triggers()
+: m_num_untriggered(0),
+  m_compiled(false),
+  m_actions_hash(0),
+  m_mpi_comm(-1),
+  m_skipped(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+Triggers::~Triggers()
+{
+}
+
+//-----------------------------------------------------------------------------
+void
+Triggers::SetMPICommHandle(int mpi_comm)
+{
+    m_mpi_comm = mpi_comm;
+}
+
+//-----------------------------------------------------------------------------
+void
+Triggers::Update(const Node &actions)
+{
+    uint64 actions_hash = ActionPlan::Hash(actions);
+    if(m_compiled && actions_hash == m_actions_hash)
+    {
+        return;
+    }
+
+    m_compiled = false;
+    Compile(actions);
+    m_actions_hash = actions_hash;
+    m_compiled = true;
+}
+
+//-----------------------------------------------------------------------------
+bool
+Triggers::Active() const
+{
+    return !m_triggers.empty();
+}
+
+//-----------------------------------------------------------------------------
+int
+Triggers::Skipped() const
+{
+    return m_skipped;
+}
+
+//-----------------------------------------------------------------------------
+void
+Triggers::Compile(const Node &actions)
+{
+    m_triggers.clear();
+    m_num_untriggered = 0;
+
+    int num_slots = 0;
+    index_t num_actions = actions.number_of_children();
+    m_run.assign(num_actions, true);
+
+    for(index_t i = 0; i < num_actions; ++i)
+    {
+        const Node &action = actions.child(i);
+        if(!action.has_child("trigger"))
+        {
+            m_num_untriggered++;
+            continue;
+        }
+
+        const Node &clauses = action["trigger"];
+
+        Trigger trigger;
+        trigger.m_action        = (int) i;
+        trigger.m_cycle_stride  = 0;
+        trigger.m_time_interval = 0.0;
+        trigger.m_wall_interval = 0.0;
+        trigger.m_has_above     = false;
+        trigger.m_above         = 0.0;
+        trigger.m_has_below     = false;
+        trigger.m_below         = 0.0;
+        trigger.m_fired_once    = false;
+        trigger.m_last_cycle    = 0;
+        trigger.m_last_time     = 0.0;
+        trigger.m_last_wall.tv_sec  = 0;
+        trigger.m_last_wall.tv_nsec = 0;
+        trigger.m_slot          = -1;
+        trigger.m_candidate     = false;
+
+        if(clauses.has_child("cycle_stride"))
+        {
+            trigger.m_cycle_stride = clauses["cycle_stride"].to_int64();
+        }
+
+        if(clauses.has_child("time_interval"))
+        {
+            trigger.m_time_interval = clauses["time_interval"].to_float64();
+        }
+
+        if(clauses.has_child("wall_interval"))
+        {
+            trigger.m_wall_interval = clauses["wall_interval"].to_float64();
+        }
+
+        if(clauses.has_child("field"))
+        {
+            trigger.m_field = clauses["field"].as_string();
+        }
+
+        if(clauses.has_child("above"))
+        {
+            trigger.m_has_above = true;
+            trigger.m_above     = clauses["above"].to_float64();
+        }
+
+        if(clauses.has_child("below"))
+        {
+            trigger.m_has_below = true;
+            trigger.m_below     = clauses["below"].to_float64();
+        }
+
+        bool has_field = !trigger.m_field.empty();
+        bool threshold = trigger.m_has_above || trigger.m_has_below;
+        if(has_field != threshold)
+        {
+            STRAWMAN_ERROR("trigger of action " << i 
+                           << ": field needs above and/or below and "
+                           << "above and below need a field");
+        }
+
+        if(trigger.m_cycle_stride <= 0 && 
+           trigger.m_time_interval <= 0.0 &&
+           trigger.m_wall_interval <= 0.0 &&
+           !threshold)
+        {
+            STRAWMAN_ERROR("trigger of action " << i << " has no clauses");
+        }
+
+        if(trigger.m_wall_interval > 0.0 || threshold)
+        {
+            trigger.m_slot = num_slots;
+            num_slots += NUM_SLOTS;
+        }
+
+        m_triggers.push_back(trigger);
+    }
+
+    m_reduce_values.resize(num_slots);
+}
+
+//-----------------------------------------------------------------------------
+bool
+Triggers::Evaluate(const Node *data,
+                   int64 cycle,
+                   double time)
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    //
+    // cycle and time are the same on all ranks, check them first
+    //
+    bool reduce = false;
+    for(size_t i = 0; i < m_triggers.size(); ++i)
+    {
+        Trigger &trigger = m_triggers[i];
+
+        bool cycle_ok = !trigger.m_fired_once ||
+                        trigger.m_cycle_stride <= 0 ||
+                        cycle - trigger.m_last_cycle >= trigger.m_cycle_stride;
+
+        bool time_ok = !trigger.m_fired_once ||
+                       trigger.m_time_interval <= 0.0 ||
+                       time - trigger.m_last_time >= 
+                       trigger.m_time_interval * (1.0 - TIME_TOLERANCE);
+
+        trigger.m_candidate = cycle_ok && time_ok;
+        if(trigger.m_candidate && trigger.m_slot >= 0)
+        {
+            reduce = true;
+        }
+    }
+
+    //
+    // one reduction for the wall time and field clauses of all triggers
+    //
+    if(reduce)
+    {
+        for(size_t i = 0; i < m_triggers.size(); ++i)
+        {
+            const Trigger &trigger = m_triggers[i];
+            if(trigger.m_slot < 0)
+            {
+                continue;
+            }
+
+            double *slots = &m_reduce_values[trigger.m_slot];
+            slots[SLOT_WALL]    = -DBL_MAX;
+            slots[SLOT_NEG_MIN] = -DBL_MAX;
+            slots[SLOT_MAX]     = -DBL_MAX;
+
+            if(!trigger.m_candidate)
+            {
+                continue;
+            }
+
+            if(trigger.m_wall_interval > 0.0)
+            {
+                slots[SLOT_WALL] = trigger.m_fired_once ? 
+                                   seconds_between(trigger.m_last_wall, now) :
+                                   DBL_MAX;
+            }
+
+            double min_value = DBL_MAX;
+            double max_value = -DBL_MAX;
+            if(!trigger.m_field.empty() &&
+               field_min_max(data, trigger.m_field, min_value, max_value))
+            {
+                slots[SLOT_NEG_MIN] = -min_value;
+                slots[SLOT_MAX]     = max_value;
+            }
+        }
+
+        Reduce(m_reduce_values);
+    }
+
+    //
+    // fire the candidates whose wall time and field clauses hold
+    //
+    int num_run = m_num_untriggered;
+    for(size_t i = 0; i < m_triggers.size(); ++i)
+    {
+        Trigger &trigger = m_triggers[i];
+        bool fired = trigger.m_candidate;
+
+        if(fired && trigger.m_slot >= 0)
+        {
+            const double *slots = &m_reduce_values[trigger.m_slot];
+
+            if(trigger.m_wall_interval > 0.0 &&
+               slots[SLOT_WALL] < trigger.m_wall_interval)
+            {
+                fired = false;
+            }
+
+            if(!trigger.m_field.empty())
+            {
+                bool above = trigger.m_has_above && 
+                             slots[SLOT_MAX] > trigger.m_above;
+                bool below = trigger.m_has_below &&
+                             -slots[SLOT_NEG_MIN] < trigger.m_below;
+                fired = fired && (above || below);
+            }
+        }
+
+        m_run[trigger.m_action] = fired;
+        if(fired)
+        {
+            trigger.m_fired_once = true;
+            trigger.m_last_cycle = cycle;
+            trigger.m_last_time  = time;
+            trigger.m_last_wall  = now;
+            num_run++;
+        }
+    }
+
+    if(num_run == 0)
+    {
+        m_skipped++;
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<bool> &
+Triggers::Fired() const
+{
+    return m_run;
+}
+
+//-----------------------------------------------------------------------------
+void
+Triggers::Reduce(std::vector<double> &values) const
+{
+#ifdef PARALLEL
+    if(values.empty())
+    {
+        return;
+    }
+
+    MPI_Comm mpi_comm = m_mpi_comm == -1 ? MPI_COMM_WORLD :
+                                           MPI_Comm_f2c(m_mpi_comm);
+    MPI_Allreduce(MPI_IN_PLACE,
+                  &values[0],
+                  (int) values.size(),
+                  MPI_DOUBLE,
+                  MPI_MAX,
+                  mpi_comm);
+#else
+    (void) values;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
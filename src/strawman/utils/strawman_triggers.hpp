@@ -0,0 +1,162 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_triggers.hpp
+///
+//-----------------------------------------------------------------------------
+#ifndef STRAWMAN_TRIGGERS_HPP
+#define STRAWMAN_TRIGGERS_HPP
+
+#include <conduit.hpp>
+#include <time.h>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+/// Decides which actions run this cycle from their optional "trigger" 
+/// clause:
+///
+///   trigger/cycle_stride   cycles since the trigger last fired
+///   trigger/time_interval  state/time since the trigger last fired
+///   trigger/wall_interval  wall seconds since the trigger last fired
+///   trigger/field          with trigger/above and/or trigger/below, the 
+///                          field's max is above or its min is below
+///
+/// A trigger fires the first time it is evaluated and then when all of 
+/// its clauses hold. The cycle and time clauses are checked first, they 
+/// are the same on all ranks. Only if they hold are the wall time and 
+/// field clauses evaluated, with a single reduction over the ranks for 
+/// all triggers so the ranks agree.
+//-----------------------------------------------------------------------------
+class Triggers
+{
+public:
+    Triggers();
+    ~Triggers();
+
+    // fortran handle of the communicator to reduce over, unused in serial
+    void                 SetMPICommHandle(int mpi_comm);
+
+    // compiles the trigger clauses if the actions changed
+    void                 Update(const conduit::Node &actions);
+    // true if any action has a trigger
+    bool                 Active() const;
+
+    // decides which of the actions passed to Update run this cycle, 
+    // false when none do. data may be NULL before the first Publish.
+    bool                 Evaluate(const conduit::Node *data,
+                                  conduit::int64 cycle,
+                                  double time);
+    // per action, true if it runs this cycle. the pipelines skip the 
+    // others, so their plan stays compiled for all the actions.
+    const std::vector<bool> &Fired() const;
+
+    // how often Evaluate returned NULL
+    int                  Skipped() const;
+
+private:
+    Triggers(const Triggers &);
+    Triggers &operator=(const Triggers &);
+
+    struct Trigger
+    {
+        // index of the action it belongs to
+        int                  m_action;
+
+        conduit::int64       m_cycle_stride;
+        double               m_time_interval;
+        double               m_wall_interval;
+        std::string          m_field;
+        bool                 m_has_above;
+        double               m_above;
+        bool                 m_has_below;
+        double               m_below;
+
+        bool                 m_fired_once;
+        conduit::int64       m_last_cycle;
+        double               m_last_time;
+        timespec             m_last_wall;
+
+        // first of the values this trigger adds to the reduction
+        int                  m_slot;
+        // passed the cycle and time clauses in this Evaluate
+        bool                 m_candidate;
+    };
+
+    void                 Compile(const conduit::Node &actions);
+    // max of values over all ranks, in place
+    void                 Reduce(std::vector<double> &values) const;
+
+    std::vector<Trigger> m_triggers;
+    // per action, true if it has no trigger or its trigger fired
+    std::vector<bool>    m_run;
+    int                  m_num_untriggered;
+    // values the triggers add to the reduction
+    std::vector<double>  m_reduce_values;
+
+    bool                 m_compiled;
+    conduit::uint64      m_actions_hash;
+    int                  m_mpi_comm;
+    int                  m_skipped;
+};
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
+
@@ -52,15 +52,15 @@
 
 #include <strawman_config.h>
 #include <strawman_logging.hpp>
+#include <strawman_mutex_lock.hpp>
 
-// thirdparty includes
-#include <lodepng.h>
-
-// conduit includes
-#include <conduit_relay.hpp>
+// standard includes
+#include <fstream>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
 
 using namespace conduit;
-using namespace conduit::relay::web;
 
 //-----------------------------------------------------------------------------
 // -- begin strawman:: --
@@ -69,125 +69,908 @@ namespace strawman
 {
 
 //-----------------------------------------------------------------------------
-WebInterface::WebInterface(int ms_poll,
-                           int ms_timeout)
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+const size_t FRAME_HEADER_BYTES = 40;
+// frames kept for reuse, one being filled while another is in flight
+const size_t MAX_SPARE_FRAMES   = 2;
+
+//-----------------------------------------------------------------------------
+double
+wall_time()
+{
+    timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1.0e-6;
+}
+
+//-----------------------------------------------------------------------------
+void
+pack_uint32(unsigned char *dest, uint32 val)
+{
+    for(int i = 0; i < 4; ++i)
+    {
+        dest[i] = (unsigned char)((val >> (i*8)) & 0xFF);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+pack_uint64(unsigned char *dest, uint64 val)
+{
+    for(int i = 0; i < 8; ++i)
+    {
+        dest[i] = (unsigned char)((val >> (i*8)) & 0xFF);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+pack_frame_header(unsigned char *header,
+                  int format,
+                  int width,
+                  int height,
+                  int64 cycle,
+                  float64 time)
+{
+    uint64 time_bits = 0;
+    memcpy(&time_bits, &time, sizeof(float64));
+
+    header[0] = 'S';
+    header[1] = 'M';
+    header[2] = 'I';
+    header[3] = 'F';
+    pack_uint32(header +  4, (uint32)FRAME_HEADER_BYTES);
+    pack_uint32(header +  8, (uint32)format);
+    pack_uint32(header + 12, (uint32)width);
+    pack_uint32(header + 16, (uint32)height);
+    pack_uint32(header + 20, 0);
+    pack_uint64(header + 24, (uint64)cycle);
+    pack_uint64(header + 32, time_bits);
+}
+
+//-----------------------------------------------------------------------------
+// box filter rgba8 pixels by an integer factor
+//-----------------------------------------------------------------------------
+void
+downscale_rgba(const unsigned char *src,
+               int width,
+               int height,
+               int factor,
+               std::vector<unsigned char> &dest,
+               int &dest_width,
+               int &dest_height)
+{
+    dest_width  = width  / factor > 0 ? width  / factor : 1;
+    dest_height = height / factor > 0 ? height / factor : 1;
+    dest.resize((size_t)dest_width * dest_height * 4);
+
+    for(int y = 0; y < dest_height; ++y)
+    {
+        for(int x = 0; x < dest_width; ++x)
+        {
+            unsigned int sum[4] = {0, 0, 0, 0};
+            unsigned int count  = 0;
+            for(int j = y * factor; j < (y + 1) * factor && j < height; ++j)
+            {
+                const unsigned char *row = src + ((size_t)j * width) * 4;
+                for(int i = x * factor; i < (x + 1) * factor && i < width; ++i)
+                {
+                    for(int c = 0; c < 4; ++c)
+                    {
+                        sum[c] += row[i * 4 + c];
+                    }
+                    count++;
+                }
+            }
+
+            unsigned char *res = &dest[((size_t)y * dest_width + x) * 4];
+            for(int c = 0; c < 4; ++c)
+            {
+                res[c] = (unsigned char)(sum[c] / count);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// reads a png file the renderer just wrote and checks it is complete 
+// (ends with an IEND chunk). problems are only logged, a missing frame
+// must not stop the simulation.
+//-----------------------------------------------------------------------------
+bool
+read_png_file(const std::string &path,
+              std::vector<unsigned char> &data,
+              int &width,
+              int &height)
+{
+    std::ifstream file(path.c_str(), std::ios::binary);
+
+    // find out how big the png file is
+    file.seekg(0, std::ios::end);
+    std::streamsize png_raw_bytes = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    // signature + IHDR + IEND
+    if(png_raw_bytes < 45)
+    {
+        STRAWMAN_INFO("Error reading png file " << path);
+        return false;
+    }
+
+    data.resize((size_t)png_raw_bytes);
+    if(!file.read((char*)&data[0], png_raw_bytes))
+    {
+        STRAWMAN_INFO("Error reading png file " << path);
+        return false;
+    }
+
+    if(memcmp(&data[data.size() - 8], "IEND", 4) != 0)
+    {
+        STRAWMAN_INFO("Skipping incomplete png file " << path);
+        return false;
+    }
+
+    // the image dims live in the IHDR chunk, which always directly 
+    // follows the 8 byte png signature
+    const unsigned char *ihdr = &data[16];
+    width  = (ihdr[0] << 24) | (ihdr[1] << 16) | (ihdr[2] << 8) | ihdr[3];
+    height = (ihdr[4] << 24) | (ihdr[5] << 16) | (ihdr[6] << 8) | ihdr[7];
+    return true;
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// a frame waiting to be sent, owned by whoever last took it from the mailbox.
+// frames are recycled, so their buffers keep their capacity across cycles.
+//-----------------------------------------------------------------------------
+struct WebInterface::Frame
+{
+    enum Source
+    {
+        PNG_FILE,
+        FLOAT_PIXELS,
+        BYTE_PIXELS
+    };
+
+    Source                     m_source;
+    int                        m_width;
+    int                        m_height;
+    int64                      m_cycle;
+    float64                    m_time;
+    // bottom-up rgba pixels, or the contents of a png file. only 
+    // the one that matches m_source is used
+    std::vector<float>         m_float_pixels;
+    std::vector<unsigned char> m_pixels;
+
+    Frame()
+    : m_source(BYTE_PIXELS),
+      m_width(0),
+      m_height(0),
+      m_cycle(0),
+      m_time(0.0)
+    {}
+
+    void SetState(const Node &state)
+    {
+        m_cycle = 0;
+        m_time  = 0.0;
+
+        if(state.has_path("cycle"))
+        {
+            m_cycle = state["cycle"].to_int64();
+        }
+
+        if(state.has_path("time"))
+        {
+            m_time = state["time"].to_float64();
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+WebInterface::WebInterface(int ms_poll)
 :m_server(NULL),
  m_ms_poll(ms_poll),
- m_ms_timeout(ms_timeout)
-{}
+ m_thread_running(false),
+ m_shutdown(false),
+ m_client_connected(false),
+ m_clients_ready(false),
+ m_sending(false),
+ m_frames_queried(false),
+ m_message_slot(NULL),
+ m_frame_slot(NULL),
+ m_camera_changed(false)
+{
+    pthread_mutex_init(&m_mutex, NULL);
+}
   
 //-----------------------------------------------------------------------------
 WebInterface::~WebInterface()
 {
-    if(m_server)
+    Stop();
+
+    delete m_message_slot;
+    delete m_frame_slot;
+
+    for(size_t i = 0; i < m_spare_frames.size(); ++i)
+    {
+        delete m_spare_frames[i];
+    }
+
+    pthread_mutex_destroy(&m_mutex);
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::SetOptions(const Node &options)
+{
+    MutexLock lock(m_mutex);
+    m_policy.SetOptions(options);
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::Start()
+{
+    // only try once, if we could not serve there is 
+    // no reason to keep trying each cycle
+    if(m_server != NULL)
+    {
+        return;
+    }
+
+    // bind on the calling thread, so a port conflict is reported 
+    // where the user can see it
+    m_server = new WebServer();
+    m_server->SetDocumentRoot(STRAWMAN_WEB_CLIENT_ROOT);
+
+    if(!m_server->Serve())
+    {
+        return;
+    }
+
+    if(pthread_create(&m_thread, NULL, WebInterface::ThreadMain, this) != 0)
+    {
+        STRAWMAN_WARN("Failed to start web server thread");
+        m_server->Shutdown();
+        return;
+    }
+
+    m_thread_running = true;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::Stop()
+{
+    if(m_thread_running)
+    {
+        {
+            MutexLock lock(m_mutex);
+            m_shutdown = true;
+        }
+
+        m_server->Wake();
+        pthread_join(m_thread, NULL);
+        m_thread_running = false;
+    }
+
+    if(m_server != NULL)
     {
         delete m_server;
+        m_server = NULL;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebInterface::FrameWanted()
+{
+    Start();
+
+    if(!m_thread_running)
+    {
+        return false;
     }
+
+    MutexLock lock(m_mutex);
+
+    double now = wall_time();
+    m_policy.FrameOffered(now);
+    m_frames_queried = true;
+
+    // don't ask for a new frame while we are still busy with the last one,
+    // it would most likely be replaced before it is sent
+    return m_clients_ready &&
+           !m_sending &&
+           m_frame_slot == NULL &&
+           m_policy.FrameDue(now);
 }
 
+//-----------------------------------------------------------------------------
+void *
+WebInterface::ThreadMain(void *self)
+{
+    ((WebInterface*)self)->Serve();
+    return NULL;
+}
 
 //-----------------------------------------------------------------------------
-WebSocket *
-WebInterface::Connection()
+// runs on the service thread. conduit's default warning handler throws,
+// so we only log with STRAWMAN_INFO here.
+//-----------------------------------------------------------------------------
+void
+WebInterface::Serve()
 {
-    // start our web server if necessary 
-    if(m_server == NULL)
+    // the latest message and frame we have not sent yet
+    std::string *msg   = NULL;
+    Frame       *frame = NULL;
+
+    std::vector<WebSocket*> clients;
+
+    // an exception that escapes the thread would terminate the 
+    // simulation, so we stop serving instead
+    try
     {
-        m_server = new WebServer();
-        m_server->set_document_root(STRAWMAN_WEB_CLIENT_ROOT);
-        m_server->set_request_handler(new WebRequestHandler());
-        m_server->serve(false);
+        while(true)
+        {
+            // wait for activity, but no longer than it takes 
+            // for a held frame to become due
+            int ms_wait = m_ms_poll;
+            if(frame != NULL)
+            {
+                double next_time = 0.0;
+                {
+                    MutexLock lock(m_mutex);
+                    next_time = m_policy.NextFrameTime();
+                }
+
+                double ms_due = (next_time - wall_time()) * 1000.0;
+                if(ms_due < 0.0)
+                {
+                    ms_wait = 0;
+                }
+                else if(ms_due < (double) ms_wait)
+                {
+                    ms_wait = (int) ms_due + 1;
+                }
+            }
+
+            // services http requests, new websocket connections, flushes 
+            // client send queues and returns early when something lands 
+            // in the mailbox
+            m_server->Poll(ms_wait);
+            m_server->Connections(clients);
+
+            std::string client_msg;
+            for(size_t i = 0; i < clients.size(); ++i)
+            {
+                while(clients[i]->NextMessage(client_msg))
+                {
+                    Receive(client_msg);
+                }
+            }
+
+            // the stream quality follows the fastest client. slower clients
+            // drop frames from their own send queues instead of lowering 
+            // the quality for everyone. a client that never made us wait
+            // reports 0, which means no limit.
+            double throughput = 0.0;
+            bool   unlimited  = false;
+            bool   ready      = false;
+            for(size_t i = 0; i < clients.size(); ++i)
+            {
+                double client_throughput = clients[i]->Throughput();
+                if(client_throughput <= 0.0)
+                {
+                    unlimited = true;
+                }
+                else if(client_throughput > throughput)
+                {
+                    throughput = client_throughput;
+                }
+                ready = ready || clients[i]->CanSend();
+            }
+
+            if(unlimited)
+            {
+                throughput = 0.0;
+            }
+
+            bool connected = !clients.empty();
+
+            std::string *stale_msg   = NULL;
+            Frame       *stale_frame = NULL;
+            bool  frame_due = false;
+            bool  use_raw   = false;
+            int   downscale = 1;
+            {
+                MutexLock lock(m_mutex);
+                if(m_shutdown)
+                {
+                    break;
+                }
+
+                if(m_message_slot != NULL)
+                {
+                    stale_msg = msg;
+                    msg = m_message_slot;
+                    m_message_slot = NULL;
+                }
+
+                if(m_frame_slot != NULL)
+                {
+                    stale_frame = frame;
+                    frame = m_frame_slot;
+                    m_frame_slot = NULL;
+                }
+
+                if(connected != m_client_connected)
+                {
+                    m_client_connected = connected;
+                    m_policy.Reset();
+                }
+
+                m_clients_ready = ready;
+                m_policy.SetThroughput(throughput);
+
+                frame_due = m_policy.FrameDue(wall_time());
+                use_raw   = m_policy.UseRaw();
+                downscale = m_policy.Downscale();
+
+                // tells FrameWanted() we are busy with a frame
+                m_sending = (connected && frame != NULL && frame_due);
+            }
+
+            delete stale_msg;
+            RecycleFrame(stale_frame);
+
+            // frames pushed while nobody is watching are simply dropped
+            if(!connected)
+            {
+                delete msg;
+                RecycleFrame(frame);
+                msg   = NULL;
+                frame = NULL;
+                continue;
+            }
+
+            // hold the status message back with its frame
+            if(frame != NULL && !frame_due)
+            {
+                continue;
+            }
+
+            if(msg != NULL)
+            {
+                WebMessage *wmsg = WebMessage::Text(*msg);
+                Broadcast(clients, wmsg);
+                wmsg->Release();
+
+                delete msg;
+                msg = NULL;
+            }
+
+            if(frame != NULL)
+            {
+                // encode once, every client queues the same message
+                double t0 = wall_time();
+                size_t num_bytes = 0;
+                WebMessage *wmsg = NULL;
+                try
+                {
+                    wmsg = CreateFrameMessage(*frame,
+                                              use_raw,
+                                              downscale,
+                                              num_bytes);
+                }
+                catch(conduit::Error &)
+                {
+                    // conduit's default warning handler throws, an 
+                    // encoder warning must not take the thread down
+                    wmsg = NULL;
+                }
+                catch(std::exception &e)
+                {
+                    // for example, the encode buffers could not grow. 
+                    // we drop this frame and try again with the next
+                    STRAWMAN_INFO("Dropping web frame: " << e.what());
+                    wmsg = NULL;
+                }
+                double encode_seconds = wall_time() - t0;
+
+                if(wmsg != NULL)
+                {
+                    Broadcast(clients, wmsg);
+                    wmsg->Release();
+                }
+
+                RecycleFrame(frame);
+                frame = NULL;
+
+                MutexLock lock(m_mutex);
+                m_sending = false;
+                if(wmsg != NULL)
+                {
+                    m_policy.FrameSent(wall_time(),
+                                       num_bytes,
+                                       encode_seconds);
+                }
+            }
+        }
+    }
+    catch(std::exception &e)
+    {
+        STRAWMAN_INFO("Web interface stopped serving: " << e.what());
+        MutexLock lock(m_mutex);
+        m_sending = false;
     }
 
-    //  Don't do any more work unless we have a valid client connection
-    WebSocket *wsock = m_server->websocket((index_t)m_ms_poll,
-                                           (index_t)m_ms_timeout);
-    return wsock;
+    delete msg;
+    delete frame;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::Receive(const std::string &msg)
+{
+    Node n;
+    try
+    {
+        Generator g(msg, "json");
+        g.walk(n);
+    }
+    catch(conduit::Error &)
+    {
+        STRAWMAN_INFO("Ignoring malformed web client message: " << msg);
+        return;
+    }
+
+    if(!n.has_path("type") || !n["type"].dtype().is_string())
+    {
+        STRAWMAN_INFO("Ignoring web client message without a type");
+        return;
+    }
+
+    std::string type = n["type"].as_string();
+    if(type == "camera" && n.has_path("data"))
+    {
+        // newer cameras replace older ones we haven't used yet
+        MutexLock lock(m_mutex);
+        m_camera.set(n["data"]);
+        m_camera_changed = true;
+    }
+    else
+    {
+        STRAWMAN_INFO("Ignoring web client message of type " << type);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebInterface::PopCamera(Node &camera)
+{
+    MutexLock lock(m_mutex);
+    if(!m_camera_changed)
+    {
+        return false;
+    }
+
+    camera.set(m_camera);
+    m_camera_changed = false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::Broadcast(const std::vector<WebSocket*> &clients,
+                        WebMessage *msg)
+{
+    for(size_t i = 0; i < clients.size(); ++i)
+    {
+        clients[i]->Send(msg);
+    }
+}
+
+//-----------------------------------------------------------------------------
+WebMessage *
+WebInterface::CreateFrameMessage(const Frame &frame,
+                                 bool use_raw,
+                                 int downscale,
+                                 size_t &payload_bytes)
+{
+    unsigned char header[FRAME_HEADER_BYTES];
+    const void *payload = NULL;
+    payload_bytes = 0;
+
+    if(frame.m_source == Frame::PNG_FILE)
+    {
+        // png files are sent as is
+        pack_frame_header(header,
+                          PNG_IMAGE,
+                          frame.m_width,
+                          frame.m_height,
+                          frame.m_cycle,
+                          frame.m_time);
+        payload       = &frame.m_pixels[0];
+        payload_bytes = frame.m_pixels.size();
+    }
+    else
+    {
+        const unsigned char *pixels = &frame.m_pixels[0];
+        if(frame.m_source == Frame::FLOAT_PIXELS)
+        {
+            size_t num_values = frame.m_float_pixels.size();
+            m_converted.resize(num_values);
+            for(size_t i = 0; i < num_values; ++i)
+            {
+                m_converted[i] = 
+                    (unsigned char)(frame.m_float_pixels[i] * 255.f);
+            }
+            pixels = &m_converted[0];
+        }
+
+        EncodeFrame(frame,
+                    pixels,
+                    use_raw,
+                    downscale,
+                    header,
+                    payload,
+                    payload_bytes);
+    }
+
+    if(payload == NULL)
+    {
+        return NULL;
+    }
+
+    return WebMessage::Binary(header,
+                              FRAME_HEADER_BYTES,
+                              payload,
+                              payload_bytes);
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::EncodeFrame(const Frame &frame,
+                          const unsigned char *pixels,
+                          bool use_raw,
+                          int downscale,
+                          unsigned char *header,
+                          const void *&payload,
+                          size_t &payload_bytes)
+{
+    int width  = frame.m_width;
+    int height = frame.m_height;
+
+    if(downscale > 1)
+    {
+        downscale_rgba(pixels,
+                       frame.m_width,
+                       frame.m_height,
+                       downscale,
+                       m_scaled,
+                       width,
+                       height);
+        pixels = &m_scaled[0];
+    }
+
+    if(use_raw)
+    {
+        // the client wants top-down rows
+        size_t row_bytes = (size_t)width * 4;
+        m_pixels.resize(row_bytes * height);
+        for(int y = 0; y < height; ++y)
+        {
+            memcpy(&m_pixels[row_bytes * y],
+                   pixels + row_bytes * (height - y - 1),
+                   row_bytes);
+        }
+
+        pack_frame_header(header,
+                          RGBA_IMAGE,
+                          width,
+                          height,
+                          frame.m_cycle,
+                          frame.m_time);
+        payload       = &m_pixels[0];
+        payload_bytes = m_pixels.size();
+    }
+    else
+    {
+        m_png.Encode(pixels, width, height);
+        if(m_png.PngBuffer() == NULL)
+        {
+            return;
+        }
+
+        pack_frame_header(header,
+                          PNG_IMAGE,
+                          width,
+                          height,
+                          frame.m_cycle,
+                          frame.m_time);
+        payload       = m_png.PngBuffer();
+        payload_bytes = m_png.PngBufferSize();
+    }
 }
 
 //-----------------------------------------------------------------------------
 void
 WebInterface::PushMessage(Node &msg)
 {
-    //  Don't do any more work unless we have a valid client connection
-    WebSocket *wsock = Connection();
+    Start();
 
-    if(wsock == NULL)
+    if(!m_thread_running)
     {
         return;
     }
-    
-    // sent the message
-    wsock->send(msg);
+
+    std::string *json = new std::string(msg.to_json());
+    std::string *stale = NULL;
+    {
+        MutexLock lock(m_mutex);
+        stale = m_message_slot;
+        m_message_slot = json;
+    }
+
+    m_server->Wake();
+    delete stale;
 }
 
 //-----------------------------------------------------------------------------
 void
-WebInterface::PushImage(PNGEncoder &png)
+WebInterface::PushImage(const std::string &png_image_path,
+                        const Node &state)
 {
-    //  Don't do any more work unless we have a valid client connection
-    WebSocket *wsock = Connection();
+    Start();
+
+    if(!m_thread_running)
+    {
+        return;
+    }
 
-    if(wsock == NULL)
+    // the renderer rewrites the same file every cycle, so we read it 
+    // now, while we know it is complete. it is small compared to the
+    // raw pixels the other PushImage calls copy.
+    Frame *frame = AcquireFrame(state);
+    frame->m_source = Frame::PNG_FILE;
+    if(!read_png_file(png_image_path,
+                      frame->m_pixels,
+                      frame->m_width,
+                      frame->m_height))
     {
+        RecycleFrame(frame);
         return;
     }
-    // create message with image data
-    png.Base64Encode();
-    Node msg;
-    msg["type"] = "image";
-    msg["data"] = "data:image/png;base64," + png.Base64Node().as_string();
-    // sent the message
-    wsock->send(msg);
+
+    PostFrame(frame);
 }
 
 //-----------------------------------------------------------------------------
 void
-WebInterface::PushImage(const std::string &png_image_path)
+WebInterface::PushImage(const float *rgba_in,
+                        int width,
+                        int height,
+                        const Node &state)
 {
-    //  Don't do any more work unless we have a valid client connection
-    WebSocket *wsock = Connection();
+    Start();
 
-    if(wsock == NULL)
+    if(rgba_in == NULL || width <= 0 || height <= 0 || !m_thread_running)
     {
         return;
     }
-    
-    STRAWMAN_INFO("png path:" << png_image_path);
 
-    std::ifstream file(png_image_path.c_str(),
-                       std::ios::binary);
+    // only copy here, conversion to rgba8 and encoding happen on the 
+    // service thread, and only if the frame is actually sent
+    size_t num_values = (size_t)width * (size_t)height * 4;
 
-    // find out how big the png file is
-    file.seekg(0, std::ios::end);
-    std::streamsize png_raw_bytes = file.tellg();
-    file.seekg(0, std::ios::beg);
-    
-    // use a node to hold the buffers for raw and base64 encoded png data
-    Node png_data;
-    png_data["raw"].set(DataType::c_char(png_raw_bytes));
-    char *png_raw_ptr = png_data["raw"].value();
-    
-    // read in the raw png data
-    if(!file.read(png_raw_ptr, png_raw_bytes))
-    {
-        // ERROR ... 
-        STRAWMAN_WARN("ERROR Reading png file " << png_image_path);
-    }
-
-    // base64 encode the raw png data
-    png_data["encoded"].set(DataType::char8_str(png_raw_bytes*2));
-    
-    utils::base64_encode(png_raw_ptr,
-                         png_raw_bytes,
-                         png_data["encoded"].data_ptr());
-
-    // create message with image data
-    Node msg;
-    msg["type"] = "image";
-    msg["data"] = "data:image/png;base64," + png_data["encoded"].as_string();
-    // send the message
-    wsock->send(msg);
+    Frame *frame = AcquireFrame(state);
+    frame->m_source = Frame::FLOAT_PIXELS;
+    frame->m_width  = width;
+    frame->m_height = height;
+    frame->m_float_pixels.assign(rgba_in, rgba_in + num_values);
+
+    PostFrame(frame);
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::PushImage(const unsigned char *rgba_in,
+                        int width,
+                        int height,
+                        const Node &state)
+{
+    Start();
+
+    if(rgba_in == NULL || width <= 0 || height <= 0 || !m_thread_running)
+    {
+        return;
+    }
+
+    size_t num_bytes = (size_t)width * (size_t)height * 4;
+
+    Frame *frame = AcquireFrame(state);
+    frame->m_source = Frame::BYTE_PIXELS;
+    frame->m_width  = width;
+    frame->m_height = height;
+    frame->m_pixels.assign(rgba_in, rgba_in + num_bytes);
+
+    PostFrame(frame);
+}
+
+//-----------------------------------------------------------------------------
+WebInterface::Frame *
+WebInterface::AcquireFrame(const Node &state)
+{
+    Frame *frame = NULL;
+    {
+        MutexLock lock(m_mutex);
+        if(!m_spare_frames.empty())
+        {
+            frame = m_spare_frames.back();
+            m_spare_frames.pop_back();
+        }
+    }
+
+    if(frame == NULL)
+    {
+        frame = new Frame();
+    }
+
+    frame->SetState(state);
+    return frame;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::RecycleFrame(Frame *frame)
+{
+    if(frame == NULL)
+    {
+        return;
+    }
+
+    {
+        MutexLock lock(m_mutex);
+        if(m_spare_frames.size() < MAX_SPARE_FRAMES)
+        {
+            m_spare_frames.push_back(frame);
+            return;
+        }
+    }
+
+    delete frame;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebInterface::PostFrame(Frame *frame)
+{
+    // swap into the mailbox, replacing any frame the 
+    // service thread has not picked up yet
+    Frame *stale = NULL;
+    {
+        MutexLock lock(m_mutex);
+        // callers that use FrameWanted() already told us about this frame
+        if(!m_frames_queried)
+        {
+            m_policy.FrameOffered(wall_time());
+        }
+        stale = m_frame_slot;
+        m_frame_slot = frame;
+    }
+
+    m_server->Wake();
+    RecycleFrame(stale);
 }
 
 
@@ -51,11 +51,15 @@
 #define STRAWMAN_WEB_INTERFACE_HPP
 
 #include <string>
+#include <vector>
+
+#include <pthread.h>
 
 #include <conduit.hpp>
-#include <conduit_relay.hpp>
 
 #include <strawman_png_encoder.hpp>
+#include <strawman_web_server.hpp>
+#include <strawman_web_stream_policy.hpp>
 
 //-----------------------------------------------------------------------------
 // -- begin strawman:: --
@@ -63,28 +67,155 @@
 namespace strawman
 {
 
+//-----------------------------------------------------------------------------
+/// Streams status messages and images to the strawman web client.
+///
+/// The web server and all socket sends run on a service thread owned by 
+/// the WebInterface, which is started on first use. The Push methods
+/// never touch the network: they copy the image into a recycled frame and
+/// hand it to the service thread through a single slot mailbox. If the 
+/// service thread has not sent the previous frame by the time a new one 
+/// is pushed, the stale frame is dropped, so a slow or missing client 
+/// never stalls the simulation. Png files are read when they are pushed,
+/// float to rgba8 conversion happens on the service thread, along with 
+/// encoding.
+///
+/// Raw pixels are encoded on the service thread, right before they are
+/// sent, using the quality picked by a WebStreamPolicy (see 
+/// strawman_web_stream_policy.hpp for the web/ options). Callers can use
+/// FrameWanted() to skip producing frames that would not be sent.
+///
+/// Any number of browsers can watch at once. Each frame is encoded once
+/// into a shared WebMessage that is queued on every client, and each 
+/// client drops stale frames from its own bounded queue when it can't 
+/// keep up.
+///
+/// Status messages are sent as json text frames. Images are sent as binary
+/// frames that start with a fixed 40 byte little endian header:
+///
+///   bytes  0-3  : magic "SMIF"
+///   bytes  4-7  : uint32  header size in bytes
+///   bytes  8-11 : uint32  image format (see ImageFormat)
+///   bytes 12-15 : uint32  width
+///   bytes 16-19 : uint32  height
+///   bytes 20-23 : uint32  reserved
+///   bytes 24-31 : int64   cycle
+///   bytes 32-39 : float64 time
+///
+/// followed by the png file contents or top-down rgba8 pixels.
+///
+/// Clients can steer the view by sending json text messages:
+///
+///   {"type": "camera",
+///    "data": {"azimuth": 30.0, "elevation": 10.0,
+///             "zoom": 1.5, "xpan": 0.0, "ypan": 0.0}}
+///
+/// Only the newest camera is kept, renderers pick it up with PopCamera().
+//-----------------------------------------------------------------------------
 class WebInterface
 {
 public:
-    
-     WebInterface(int ms_poll = 1,
-                  int ms_timeout = 1);
+    enum ImageFormat
+    {
+        PNG_IMAGE  = 0,
+        RGBA_IMAGE = 1
+    };
+
+    // ms_poll: how long the service thread waits for socket activity
+    //          before checking for shutdown. new frames wake it early.
+     WebInterface(int ms_poll = 100);
 
     ~WebInterface();
-        
-    conduit::relay::web::WebSocket *Connection();
-    void                            PushMessage(conduit::Node &msg);
-    void                            PushImage(PNGEncoder &png);
-    void                            PushImage(const std::string &png_file_path);
+
+    // web/format, web/max_fps, web/max_bandwidth
+    void       SetOptions(const conduit::Node &options);
+
+    // true if a client is connected and a frame pushed now would be sent
+    bool       FrameWanted();
+
+    void       PushMessage(conduit::Node &msg);
+    // state is used to fill the frame header (state/cycle, state/time)
+    // png files are sent as is, the file is read before this returns
+    void       PushImage(const std::string &png_file_path,
+                         const conduit::Node &state);
+    // input is a bottom-up float rgba buffer 
+    void       PushImage(const float *rgba_in,
+                         int width,
+                         int height,
+                         const conduit::Node &state);
+    // input is a bottom-up rgba8 buffer 
+    void       PushImage(const unsigned char *rgba_in,
+                         int width,
+                         int height,
+                         const conduit::Node &state);
+
+    // true if a client sent a new camera since the last call,
+    // camera is set to the "data" of the newest camera message
+    bool       PopCamera(conduit::Node &camera);
         
 private:
-    conduit::relay::web::WebServer *m_server;
-    int                             m_ms_poll;
-    int                             m_ms_timeout;
-    
+    struct Frame;
+
+    // starts the service thread if necessary
+    void        Start();
+    void        Stop();
+    // a recycled (or new) frame for the given state
+    Frame      *AcquireFrame(const conduit::Node &state);
+    // keeps the frame for reuse, or deletes it if we have enough
+    void        RecycleFrame(Frame *frame);
+    // hands a frame to the service thread
+    void        PostFrame(Frame *frame);
+
+    // service thread entry point + main loop
+    static void *ThreadMain(void *self);
+    void         Serve();
+    // handles a text message from a client
+    void         Receive(const std::string &msg);
+    // queues msg on every client
+    void         Broadcast(const std::vector<WebSocket*> &clients,
+                           WebMessage *msg);
+    // encodes (if necessary) a frame into a message that can be 
+    // shared by all clients. returns NULL if encoding failed.
+    WebMessage  *CreateFrameMessage(const Frame &frame,
+                                    bool use_raw,
+                                    int downscale,
+                                    size_t &payload_bytes);
+    // encodes the frame's rgba8 pixels at the given quality, payload 
+    // points into one of our scratch buffers
+    void         EncodeFrame(const Frame &frame,
+                             const unsigned char *pixels,
+                             bool use_raw,
+                             int downscale,
+                             unsigned char *header,
+                             const void *&payload,
+                             size_t &payload_bytes);
+
+    WebServer         *m_server;
+    int                m_ms_poll;
+
+    pthread_t          m_thread;
+    bool               m_thread_running;
 
-    
+    // only used by the service thread
+    PNGEncoder                 m_png;
+    std::vector<unsigned char> m_converted;
+    std::vector<unsigned char> m_pixels;
+    std::vector<unsigned char> m_scaled;
 
+    // everything below is guarded by m_mutex
+    pthread_mutex_t    m_mutex;
+    bool               m_shutdown;
+    bool               m_client_connected;
+    // at least one client has room in its send queue
+    bool               m_clients_ready;
+    bool               m_sending;
+    bool               m_frames_queried;
+    WebStreamPolicy    m_policy;
+    std::string       *m_message_slot;
+    Frame             *m_frame_slot;
+    std::vector<Frame*> m_spare_frames;
+    conduit::Node      m_camera;
+    bool               m_camera_changed;
 };
 
 //-----------------------------------------------------------------------------
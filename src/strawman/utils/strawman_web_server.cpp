@@ -0,0 +1,1337 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_web_server.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_web_server.hpp"
+
+#include <strawman_config.h>
+#include <strawman_logging.hpp>
+
+// standard includes
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include <fstream>
+#include <sstream>
+
+// conduit includes
+#include <conduit.hpp>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+#ifdef MSG_NOSIGNAL
+const int  SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int  SEND_FLAGS = 0;
+#endif
+
+// websocket opcodes (RFC 6455)
+const unsigned char WS_OP_CONTINUATION = 0x0;
+const unsigned char WS_OP_TEXT         = 0x1;
+const unsigned char WS_OP_BINARY       = 0x2;
+const unsigned char WS_OP_CLOSE        = 0x8;
+const unsigned char WS_OP_PING         = 0x9;
+const unsigned char WS_OP_PONG         = 0xA;
+
+// guard against clients that never finish their request header
+const size_t  MAX_HTTP_REQUEST_BYTES = 8192;
+
+// per client send queue length, a status message + frame pair
+const size_t  DEFAULT_MAX_QUEUED_MESSAGES = 4;
+// weight of the newest message in the smoothed client throughput
+const double  SEND_SMOOTHING   = 0.2;
+// unread client messages we keep, older ones are dropped
+const size_t  MAX_RECV_MESSAGES = 64;
+
+//-----------------------------------------------------------------------------
+double
+wall_time()
+{
+    timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1.0e-6;
+}
+
+//-----------------------------------------------------------------------------
+bool
+send_all(int fd, const void *data, size_t num_bytes)
+{
+    const char *ptr = (const char*)data;
+    while(num_bytes > 0)
+    {
+        ssize_t res = ::send(fd, ptr, num_bytes, SEND_FLAGS);
+        if(res < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        ptr       += res;
+        num_bytes -= (size_t)res;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+set_blocking(int fd, bool blocking)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if(blocking)
+    {
+        flags &= ~O_NONBLOCK;
+    }
+    else
+    {
+        flags |= O_NONBLOCK;
+    }
+    fcntl(fd, F_SETFL, flags);
+
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// sha1 is only needed to compute the websocket handshake accept key.
+//-----------------------------------------------------------------------------
+inline unsigned int
+sha1_rotl(unsigned int v, int bits)
+{
+    return (v << bits) | (v >> (32 - bits));
+}
+
+//-----------------------------------------------------------------------------
+void
+sha1(const std::string &msg, unsigned char digest[20])
+{
+    unsigned int h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE,
+                          0x10325476, 0xC3D2E1F0 };
+
+    // pad the message: 0x80, zeros, then the 64-bit big endian bit length
+    std::string data(msg);
+    unsigned long long bit_len = ((unsigned long long)msg.size()) * 8;
+    data.push_back((char)0x80);
+    while((data.size() % 64) != 56)
+    {
+        data.push_back((char)0x00);
+    }
+    for(int i = 7; i >= 0; --i)
+    {
+        data.push_back((char)((bit_len >> (i*8)) & 0xFF));
+    }
+
+    const unsigned char *bytes = (const unsigned char*)data.data();
+
+    for(size_t chunk = 0; chunk < data.size(); chunk += 64)
+    {
+        unsigned int w[80];
+        for(int i = 0; i < 16; ++i)
+        {
+            const unsigned char *p = bytes + chunk + i*4;
+            w[i] = ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) |
+                   ((unsigned int)p[2] << 8)  |  (unsigned int)p[3];
+        }
+        for(int i = 16; i < 80; ++i)
+        {
+            w[i] = sha1_rotl(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+        }
+
+        unsigned int a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+        for(int i = 0; i < 80; ++i)
+        {
+            unsigned int f, k;
+            if(i < 20)
+            {
+                f = (b & c) | ((~b) & d);
+                k = 0x5A827999;
+            }
+            else if(i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if(i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            unsigned int temp = sha1_rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = sha1_rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    for(int i = 0; i < 5; ++i)
+    {
+        digest[i*4 + 0] = (unsigned char)((h[i] >> 24) & 0xFF);
+        digest[i*4 + 1] = (unsigned char)((h[i] >> 16) & 0xFF);
+        digest[i*4 + 2] = (unsigned char)((h[i] >> 8)  & 0xFF);
+        digest[i*4 + 3] = (unsigned char)( h[i]        & 0xFF);
+    }
+}
+
+//-----------------------------------------------------------------------------
+std::string
+base64(const unsigned char *data, size_t num_bytes)
+{
+    static const char *chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                               "abcdefghijklmnopqrstuvwxyz"
+                               "0123456789+/";
+    std::string res;
+    for(size_t i = 0; i < num_bytes; i += 3)
+    {
+        unsigned int v = ((unsigned int)data[i]) << 16;
+        if(i + 1 < num_bytes) v |= ((unsigned int)data[i+1]) << 8;
+        if(i + 2 < num_bytes) v |= ((unsigned int)data[i+2]);
+
+        res.push_back(chars[(v >> 18) & 0x3F]);
+        res.push_back(chars[(v >> 12) & 0x3F]);
+        res.push_back( (i + 1 < num_bytes) ? chars[(v >> 6) & 0x3F] : '=');
+        res.push_back( (i + 2 < num_bytes) ? chars[v & 0x3F]        : '=');
+    }
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+std::string
+to_lower(const std::string &str)
+{
+    std::string res(str);
+    for(size_t i = 0; i < res.size(); ++i)
+    {
+        res[i] = (char)tolower(res[i]);
+    }
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+std::string
+trim(const std::string &str)
+{
+    size_t start = str.find_first_not_of(" \t\r\n");
+    if(start == std::string::npos)
+    {
+        return "";
+    }
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(start, end - start + 1);
+}
+
+//-----------------------------------------------------------------------------
+std::string
+mime_type(const std::string &path)
+{
+    std::string ext = "";
+    size_t pos = path.rfind('.');
+    if(pos != std::string::npos)
+    {
+        ext = to_lower(path.substr(pos + 1));
+    }
+
+    if(ext == "html" || ext == "htm") return "text/html";
+    if(ext == "js")                   return "application/javascript";
+    if(ext == "css")                  return "text/css";
+    if(ext == "json" || ext == "map") return "application/json";
+    if(ext == "png")                  return "image/png";
+    if(ext == "svg")                  return "image/svg+xml";
+    if(ext == "ttf")                  return "font/ttf";
+    if(ext == "otf")                  return "font/otf";
+    if(ext == "woff")                 return "font/woff";
+    if(ext == "woff2")                return "font/woff2";
+    if(ext == "eot")                  return "application/vnd.ms-fontobject";
+    return "application/octet-stream";
+}
+
+//-----------------------------------------------------------------------------
+void
+send_http_status(int fd, int code, const std::string &reason)
+{
+    std::ostringstream oss;
+    oss << "HTTP/1.1 " << code << " " << reason << "\r\n"
+        << "Content-Type: text/plain\r\n"
+        << "Content-Length: " << reason.size() << "\r\n"
+        << "Connection: close\r\n\r\n"
+        << reason;
+    std::string res = oss.str();
+    send_all(fd, res.data(), res.size());
+}
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// WebMessage Methods
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+WebMessage::WebMessage(unsigned char opcode,
+                       const void *prefix,
+                       size_t prefix_bytes,
+                       const void *data,
+                       size_t data_bytes)
+:m_ref_count(1)
+{
+    size_t num_bytes = prefix_bytes + data_bytes;
+
+    // servers never mask their frames, so the header is at most 10 bytes
+    unsigned char header[10];
+    size_t header_bytes = 2;
+    header[0] = 0x80 | opcode; // FIN + opcode
+
+    if(num_bytes < 126)
+    {
+        header[1] = (unsigned char) num_bytes;
+    }
+    else if(num_bytes <= 0xFFFF)
+    {
+        header[1] = 126;
+        header[2] = (unsigned char)((num_bytes >> 8) & 0xFF);
+        header[3] = (unsigned char)( num_bytes       & 0xFF);
+        header_bytes = 4;
+    }
+    else
+    {
+        header[1] = 127;
+        unsigned long long len = (unsigned long long) num_bytes;
+        for(int i = 0; i < 8; ++i)
+        {
+            header[2+i] = (unsigned char)((len >> ((7-i)*8)) & 0xFF);
+        }
+        header_bytes = 10;
+    }
+
+    m_bytes.resize(header_bytes + num_bytes);
+    unsigned char *ptr = &m_bytes[0];
+    memcpy(ptr, header, header_bytes);
+    ptr += header_bytes;
+
+    if(prefix_bytes > 0)
+    {
+        memcpy(ptr, prefix, prefix_bytes);
+        ptr += prefix_bytes;
+    }
+
+    if(data_bytes > 0)
+    {
+        memcpy(ptr, data, data_bytes);
+    }
+}
+
+//-----------------------------------------------------------------------------
+WebMessage::~WebMessage()
+{}
+
+//-----------------------------------------------------------------------------
+WebMessage *
+WebMessage::Text(const std::string &msg)
+{
+    return new WebMessage(WS_OP_TEXT, NULL, 0, msg.data(), msg.size());
+}
+
+//-----------------------------------------------------------------------------
+WebMessage *
+WebMessage::Binary(const void *data,
+                   size_t num_bytes)
+{
+    return new WebMessage(WS_OP_BINARY, NULL, 0, data, num_bytes);
+}
+
+//-----------------------------------------------------------------------------
+WebMessage *
+WebMessage::Binary(const void *prefix,
+                   size_t prefix_bytes,
+                   const void *data,
+                   size_t num_bytes)
+{
+    return new WebMessage(WS_OP_BINARY,
+                          prefix,
+                          prefix_bytes,
+                          data,
+                          num_bytes);
+}
+
+//-----------------------------------------------------------------------------
+void
+WebMessage::Retain()
+{
+    m_ref_count++;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebMessage::Release()
+{
+    m_ref_count--;
+    if(m_ref_count == 0)
+    {
+        delete this;
+    }
+}
+
+//-----------------------------------------------------------------------------
+const unsigned char *
+WebMessage::Data() const
+{
+    return &m_bytes[0];
+}
+
+//-----------------------------------------------------------------------------
+size_t
+WebMessage::Size() const
+{
+    return m_bytes.size();
+}
+
+//-----------------------------------------------------------------------------
+// WebSocket Methods
+//-----------------------------------------------------------------------------
+
+const size_t WebSocket::MAX_RECV_PAYLOAD_BYTES;
+
+//-----------------------------------------------------------------------------
+WebSocket::WebSocket(int fd)
+:m_fd(fd),
+ m_connected(true),
+ m_max_queued(DEFAULT_MAX_QUEUED_MESSAGES),
+ m_send_offset(0),
+ m_send_start(0.0),
+ m_sent_bytes(0.0),
+ m_sent_seconds(0.0)
+{}
+
+//-----------------------------------------------------------------------------
+WebSocket::~WebSocket()
+{
+    Close();
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebSocket::IsConnected() const
+{
+    return m_connected;
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebSocket::SendText(const std::string &msg)
+{
+    WebMessage *wmsg = WebMessage::Text(msg);
+    bool res = Send(wmsg);
+    wmsg->Release();
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebSocket::SendBinary(const void *data, size_t num_bytes)
+{
+    WebMessage *wmsg = WebMessage::Binary(data, num_bytes);
+    bool res = Send(wmsg);
+    wmsg->Release();
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebSocket::SetMaxQueuedMessages(size_t max_queued)
+{
+    m_max_queued = max_queued > 0 ? max_queued : 1;
+}
+
+//-----------------------------------------------------------------------------
+size_t
+WebSocket::QueuedMessages() const
+{
+    return m_send_queue.size();
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebSocket::CanSend() const
+{
+    return m_connected && m_send_queue.size() < m_max_queued;
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebSocket::HasQueuedData() const
+{
+    return m_connected && !m_send_queue.empty();
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebSocket::Send(WebMessage *msg)
+{
+    if(!m_connected)
+    {
+        return false;
+    }
+
+    if(m_send_queue.size() >= m_max_queued)
+    {
+        // drop the oldest message that hasn't started sending,
+        // the front one may be partially written
+        std::deque<WebMessage*>::iterator itr = m_send_queue.begin();
+        if(m_send_offset > 0)
+        {
+            ++itr;
+        }
+
+        if(itr != m_send_queue.end())
+        {
+            (*itr)->Release();
+            m_send_queue.erase(itr);
+        }
+    }
+
+    msg->Retain();
+    m_send_queue.push_back(msg);
+
+    // write what we can right away, the rest goes out 
+    // when the server is polled
+    Flush();
+
+    return m_connected;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebSocket::Flush()
+{
+    while(m_connected && !m_send_queue.empty())
+    {
+        WebMessage *msg = m_send_queue.front();
+
+        ssize_t res = ::send(m_fd,
+                             msg->Data() + m_send_offset,
+                             msg->Size() - m_send_offset,
+                             SEND_FLAGS);
+        if(res < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+
+            if(errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                STRAWMAN_INFO("websocket client disconnected during send");
+                Close();
+            }
+            // otherwise the client is not ready for more, from here
+            // on we are waiting on it
+            if(m_send_start <= 0.0)
+            {
+                m_send_start = wall_time();
+            }
+            return;
+        }
+
+        m_send_offset += (size_t)res;
+
+        if(m_send_offset == msg->Size())
+        {
+            // only time spent waiting on the client counts, messages
+            // the socket buffers absorbed right away add bytes for free.
+            // decayed sums let one stalled message outweigh many quick ones
+            double send_seconds = 0.0;
+            if(m_send_start > 0.0)
+            {
+                send_seconds = wall_time() - m_send_start;
+            }
+
+            m_sent_bytes   = (1.0 - SEND_SMOOTHING) * m_sent_bytes + 
+                             (double) msg->Size();
+            m_sent_seconds = (1.0 - SEND_SMOOTHING) * m_sent_seconds + 
+                             send_seconds;
+
+            msg->Release();
+            m_send_queue.pop_front();
+            m_send_offset = 0;
+            m_send_start  = 0.0;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+double
+WebSocket::Throughput() const
+{
+    double bytes   = m_sent_bytes;
+    double seconds = m_sent_seconds;
+
+    // a stalled message should pull the estimate down 
+    // before it completes
+    if(m_send_start > 0.0)
+    {
+        bytes   += (double) m_send_offset;
+        seconds += wall_time() - m_send_start;
+    }
+
+    if(seconds <= 0.0)
+    {
+        return 0.0;
+    }
+
+    return bytes / seconds;
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebSocket::NextMessage(std::string &msg)
+{
+    if(m_recv_messages.empty())
+    {
+        return false;
+    }
+
+    msg = m_recv_messages.front();
+    m_recv_messages.pop_front();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+WebSocket::FrameStatus
+WebSocket::ParseFrame(const std::string &buffer,
+                      Frame &frame,
+                      size_t &frame_bytes)
+{
+    const size_t size = buffer.size();
+    if(size < 2)
+    {
+        return FRAME_INCOMPLETE;
+    }
+
+    const unsigned char *bytes = (const unsigned char*)buffer.data();
+    bool          masked = (bytes[1] & 0x80) != 0;
+    size_t        offset = 2;
+    unsigned long long len = bytes[1] & 0x7F;
+
+    if(len == 126)
+    {
+        if(size < 4) return FRAME_INCOMPLETE;
+        len = ((unsigned long long)bytes[2] << 8) | bytes[3];
+        offset = 4;
+    }
+    else if(len == 127)
+    {
+        if(size < 10) return FRAME_INCOMPLETE;
+        len = 0;
+        for(int i = 0; i < 8; ++i)
+        {
+            len = (len << 8) | bytes[2+i];
+        }
+        offset = 10;
+    }
+
+    // check before waiting on the payload, so a bogus length can't make
+    // us buffer without bound
+    if(len > MAX_RECV_PAYLOAD_BYTES)
+    {
+        return FRAME_TOO_LARGE;
+    }
+
+    unsigned char mask[4] = {0, 0, 0, 0};
+    if(masked)
+    {
+        if(size - offset < 4) return FRAME_INCOMPLETE;
+        memcpy(mask, bytes + offset, 4);
+        offset += 4;
+    }
+
+    if(len > size - offset)
+    {
+        return FRAME_INCOMPLETE;
+    }
+
+    frame.m_opcode  = bytes[0] & 0x0F;
+    frame.m_fin     = (bytes[0] & 0x80) != 0;
+    frame.m_payload = buffer.substr(offset, (size_t)len);
+
+    if(masked)
+    {
+        for(size_t i = 0; i < frame.m_payload.size(); ++i)
+        {
+            frame.m_payload[i] = (char)(frame.m_payload[i] ^ mask[i % 4]);
+        }
+    }
+
+    frame_bytes = offset + (size_t)len;
+    return FRAME_OK;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebSocket::Recv()
+{
+    if(!m_connected)
+    {
+        return;
+    }
+
+    char buff[4096];
+    ssize_t res = ::recv(m_fd, buff, sizeof(buff), 0);
+
+    if(res == 0 || (res < 0 && errno != EINTR && errno != EAGAIN))
+    {
+        Close();
+        return;
+    }
+
+    if(res < 0)
+    {
+        return;
+    }
+
+    m_recv_buffer.append(buff, (size_t)res);
+
+    // process all complete frames
+    while(m_connected)
+    {
+        Frame  frame;
+        size_t frame_bytes = 0;
+        FrameStatus status = ParseFrame(m_recv_buffer, frame, frame_bytes);
+
+        if(status == FRAME_INCOMPLETE)
+        {
+            // wait for the rest of the frame
+            return;
+        }
+
+        if(status == FRAME_TOO_LARGE)
+        {
+            STRAWMAN_INFO("Closing websocket: frame payload exceeds "
+                          << MAX_RECV_PAYLOAD_BYTES << " bytes");
+            m_recv_buffer.clear();
+            Close();
+            return;
+        }
+
+        m_recv_buffer.erase(0, frame_bytes);
+
+        unsigned char opcode = frame.m_opcode;
+        bool          fin    = frame.m_fin;
+        std::string  &payload = frame.m_payload;
+
+        if(opcode == WS_OP_CLOSE)
+        {
+            // echo the close frame before we hang up, this is best 
+            // effort since we won't wait for queued data to drain
+            WebMessage *reply = new WebMessage(WS_OP_CLOSE,
+                                               NULL,
+                                               0,
+                                               payload.data(),
+                                               payload.size());
+            if(m_send_offset == 0)
+            {
+                ssize_t sres = ::send(m_fd, 
+                                      reply->Data(),
+                                      reply->Size(),
+                                      SEND_FLAGS);
+                (void) sres;
+            }
+            reply->Release();
+            Close();
+        }
+        else if(opcode == WS_OP_PING)
+        {
+            WebMessage *reply = new WebMessage(WS_OP_PONG,
+                                               NULL,
+                                               0,
+                                               payload.data(),
+                                               payload.size());
+            Send(reply);
+            reply->Release();
+        }
+        else if(opcode == WS_OP_TEXT)
+        {
+            // our client sends small, unfragmented messages, 
+            // so we don't reassemble continuation frames
+            if(!fin)
+            {
+                STRAWMAN_INFO("Ignoring fragmented websocket message");
+                continue;
+            }
+
+            if(m_recv_messages.size() >= MAX_RECV_MESSAGES)
+            {
+                m_recv_messages.pop_front();
+            }
+            m_recv_messages.push_back(payload);
+        }
+        // we drop any binary, continuation or pong frames.
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+WebSocket::Close()
+{
+    if(m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_connected = false;
+
+    while(!m_send_queue.empty())
+    {
+        m_send_queue.front()->Release();
+        m_send_queue.pop_front();
+    }
+    m_send_offset = 0;
+    m_send_start  = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+// WebServer Methods
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+WebServer::WebServer()
+:m_doc_root(""),
+ m_port(9000),
+ m_listen_fd(-1)
+{
+    m_wake_fds[0] = -1;
+    m_wake_fds[1] = -1;
+}
+
+//-----------------------------------------------------------------------------
+WebServer::~WebServer()
+{
+    Shutdown();
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::SetDocumentRoot(const std::string &path)
+{
+    m_doc_root = path;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::SetPort(int port)
+{
+    m_port = port;
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebServer::IsRunning() const
+{
+    return m_listen_fd >= 0;
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebServer::Serve()
+{
+    if(IsRunning())
+    {
+        return true;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0)
+    {
+        STRAWMAN_WARN("WebServer failed to create socket");
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port        = htons((unsigned short)m_port);
+
+    if(::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+       ::listen(fd, 16) != 0)
+    {
+        STRAWMAN_WARN("WebServer failed to listen on port " << m_port);
+        ::close(fd);
+        return false;
+    }
+
+    set_blocking(fd, false);
+    m_listen_fd = fd;
+
+    // self pipe used by Wake() to interrupt poll
+    if(::pipe(m_wake_fds) == 0)
+    {
+        set_blocking(m_wake_fds[0], false);
+        set_blocking(m_wake_fds[1], false);
+    }
+    else
+    {
+        m_wake_fds[0] = -1;
+        m_wake_fds[1] = -1;
+    }
+
+    STRAWMAN_INFO("WebServer serving " << m_doc_root 
+                  << " on port " << m_port);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::Shutdown()
+{
+    for(size_t i = 0; i < m_sockets.size(); ++i)
+    {
+        delete m_sockets[i];
+    }
+    m_sockets.clear();
+
+    for(size_t i = 0; i < m_pending.size(); ++i)
+    {
+        ::close(m_pending[i].m_fd);
+    }
+    m_pending.clear();
+
+    if(m_listen_fd >= 0)
+    {
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+    }
+
+    for(int i = 0; i < 2; ++i)
+    {
+        if(m_wake_fds[i] >= 0)
+        {
+            ::close(m_wake_fds[i]);
+            m_wake_fds[i] = -1;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::Wake()
+{
+    if(m_wake_fds[1] >= 0)
+    {
+        // if the pipe is full a wake up is already pending
+        char c = 0;
+        ssize_t res = ::write(m_wake_fds[1], &c, 1);
+        (void) res;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::Poll(int ms_poll)
+{
+    if(!IsRunning())
+    {
+        return;
+    }
+
+    std::vector<struct pollfd> fds;
+    struct pollfd pfd;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+
+    pfd.fd = m_listen_fd;
+    fds.push_back(pfd);
+
+    for(size_t i = 0; i < m_pending.size(); ++i)
+    {
+        pfd.fd = m_pending[i].m_fd;
+        fds.push_back(pfd);
+    }
+
+    for(size_t i = 0; i < m_sockets.size(); ++i)
+    {
+        pfd.fd = m_sockets[i]->m_fd;
+        if(m_sockets[i]->HasQueuedData())
+        {
+            pfd.events = POLLIN | POLLOUT;
+        }
+        fds.push_back(pfd);
+        pfd.events = POLLIN;
+    }
+
+    // the wake pipe always goes last
+    pfd.fd = m_wake_fds[0];
+    fds.push_back(pfd);
+
+    int res = ::poll(&fds[0], (nfds_t)fds.size(), ms_poll);
+    if(res <= 0)
+    {
+        return;
+    }
+
+    if(fds.back().revents & POLLIN)
+    {
+        char buff[64];
+        while(::read(m_wake_fds[0], buff, sizeof(buff)) > 0)
+        {}
+    }
+
+    // websocket traffic (close, ping, ...) and queued sends
+    size_t sock_offset = 1 + m_pending.size();
+    for(size_t i = 0; i < m_sockets.size(); ++i)
+    {
+        short revents = fds[sock_offset + i].revents;
+        if(revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            m_sockets[i]->Recv();
+        }
+
+        if(revents & POLLOUT)
+        {
+            m_sockets[i]->Flush();
+        }
+    }
+
+    // http requests that are in flight, this may move 
+    // a connection to m_sockets, so iterate in reverse
+    for(size_t i = m_pending.size(); i > 0; --i)
+    {
+        size_t idx = i - 1;
+        if(fds[1 + idx].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            if(ProcessRequest(m_pending[idx]))
+            {
+                m_pending.erase(m_pending.begin() + idx);
+            }
+        }
+    }
+
+    if(fds[0].revents & POLLIN)
+    {
+        Accept();
+    }
+
+    RemoveClosedSockets();
+}
+
+//-----------------------------------------------------------------------------
+WebSocket *
+WebServer::Connection(int ms_poll,
+                      int ms_timeout)
+{
+    int ms_waited = 0;
+    while(true)
+    {
+        Poll(ms_poll);
+
+        for(size_t i = 0; i < m_sockets.size(); ++i)
+        {
+            if(m_sockets[i]->IsConnected())
+            {
+                return m_sockets[i];
+            }
+        }
+
+        ms_waited += ms_poll;
+        if(ms_waited >= ms_timeout)
+        {
+            return NULL;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::Connections(std::vector<WebSocket*> &sockets)
+{
+    sockets.clear();
+    for(size_t i = 0; i < m_sockets.size(); ++i)
+    {
+        if(m_sockets[i]->IsConnected())
+        {
+            sockets.push_back(m_sockets[i]);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::Accept()
+{
+    while(true)
+    {
+        int fd = ::accept(m_listen_fd, NULL, NULL);
+        if(fd < 0)
+        {
+            // EAGAIN: no more pending connections
+            return;
+        }
+
+        // http replies use blocking writes, reads are only 
+        // issued after poll() reports data
+        set_blocking(fd, true);
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        HTTPConnection conn;
+        conn.m_fd = fd;
+        m_pending.push_back(conn);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebServer::ProcessRequest(HTTPConnection &conn)
+{
+    char buff[2048];
+    ssize_t res = ::recv(conn.m_fd, buff, sizeof(buff), 0);
+
+    if(res <= 0)
+    {
+        ::close(conn.m_fd);
+        return true;
+    }
+
+    conn.m_request.append(buff, (size_t)res);
+
+    size_t header_end = conn.m_request.find("\r\n\r\n");
+    if(header_end == std::string::npos)
+    {
+        if(conn.m_request.size() > MAX_HTTP_REQUEST_BYTES)
+        {
+            send_http_status(conn.m_fd, 400, "Bad Request");
+            ::close(conn.m_fd);
+            return true;
+        }
+        // wait for the rest of the header
+        return false;
+    }
+
+    std::istringstream iss(conn.m_request.substr(0, header_end));
+    std::string line;
+    std::getline(iss, line);
+
+    std::istringstream req_line(line);
+    std::string method, uri;
+    req_line >> method >> uri;
+
+    std::string upgrade = "";
+    std::string ws_key  = "";
+
+    while(std::getline(iss, line))
+    {
+        size_t sep = line.find(':');
+        if(sep == std::string::npos)
+        {
+            continue;
+        }
+        std::string key = to_lower(trim(line.substr(0, sep)));
+        std::string val = trim(line.substr(sep + 1));
+
+        if(key == "upgrade")
+        {
+            upgrade = to_lower(val);
+        }
+        else if(key == "sec-websocket-key")
+        {
+            ws_key = val;
+        }
+    }
+
+    if(method != "GET")
+    {
+        send_http_status(conn.m_fd, 405, "Method Not Allowed");
+        ::close(conn.m_fd);
+    }
+    else if(upgrade == "websocket" && ws_key != "")
+    {
+        // the fd is now owned by the new websocket
+        UpgradeToWebSocket(conn.m_fd, ws_key);
+    }
+    else
+    {
+        ServeFile(conn.m_fd, uri);
+        ::close(conn.m_fd);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::ServeFile(int fd,
+                     const std::string &uri)
+{
+    std::string path = uri.substr(0, uri.find('?'));
+
+    if(path == "" || path == "/")
+    {
+        path = "/index.html";
+    }
+
+    // don't allow requests to escape the document root
+    if(path.find("..") != std::string::npos)
+    {
+        send_http_status(fd, 403, "Forbidden");
+        return;
+    }
+
+    std::string file_path = m_doc_root + path;
+    std::ifstream ifs(file_path.c_str(), std::ios::binary);
+
+    if(!ifs.is_open())
+    {
+        send_http_status(fd, 404, "Not Found");
+        return;
+    }
+
+    std::ostringstream contents;
+    contents << ifs.rdbuf();
+    std::string body = contents.str();
+
+    std::ostringstream oss;
+    oss << "HTTP/1.1 200 OK\r\n"
+        << "Content-Type: "   << mime_type(path) << "\r\n"
+        << "Content-Length: " << body.size() << "\r\n"
+        << "Connection: close\r\n\r\n";
+    std::string header = oss.str();
+
+    send_all(fd, header.data(), header.size());
+    send_all(fd, body.data(), body.size());
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::UpgradeToWebSocket(int fd,
+                              const std::string &key)
+{
+    unsigned char digest[20];
+    sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", digest);
+
+    std::ostringstream oss;
+    oss << "HTTP/1.1 101 Switching Protocols\r\n"
+        << "Upgrade: websocket\r\n"
+        << "Connection: Upgrade\r\n"
+        << "Sec-WebSocket-Accept: " << base64(digest,20) << "\r\n\r\n";
+    std::string res = oss.str();
+
+    if(!send_all(fd, res.data(), res.size()))
+    {
+        ::close(fd);
+        return;
+    }
+
+    // websocket writes are queued, so they never block the server
+    set_blocking(fd, false);
+    m_sockets.push_back(new WebSocket(fd));
+}
+
+//-----------------------------------------------------------------------------
+void
+WebServer::RemoveClosedSockets()
+{
+    std::vector<WebSocket*> active;
+    for(size_t i = 0; i < m_sockets.size(); ++i)
+    {
+        if(m_sockets[i]->IsConnected())
+        {
+            active.push_back(m_sockets[i]);
+        }
+        else
+        {
+            delete m_sockets[i];
+        }
+    }
+    m_sockets = active;
+}
+
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+
@@ -0,0 +1,273 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_web_server.hpp
+///
+//-----------------------------------------------------------------------------
+#ifndef STRAWMAN_WEB_SERVER_HPP
+#define STRAWMAN_WEB_SERVER_HPP
+
+#include <deque>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+class WebServer;
+
+//-----------------------------------------------------------------------------
+/// An immutable, reference counted websocket message.
+///
+/// The complete wire bytes (frame header + payload) are built once, so the
+/// same message can be queued on any number of sockets without copying or
+/// re-encoding it. Reference counts are not atomic: messages are only used
+/// by the thread that services the WebServer.
+//-----------------------------------------------------------------------------
+class WebMessage
+{
+public:
+    friend class WebSocket;
+
+    // the new message starts with a reference count of one
+    static WebMessage   *Text(const std::string &msg);
+    static WebMessage   *Binary(const void *data,
+                                size_t num_bytes);
+    // prefix + data as a single binary message
+    static WebMessage   *Binary(const void *prefix,
+                                size_t prefix_bytes,
+                                const void *data,
+                                size_t num_bytes);
+
+    void                 Retain();
+    // deletes the message when the last reference is released
+    void                 Release();
+
+    // wire bytes
+    const unsigned char *Data() const;
+    size_t               Size() const;
+
+private:
+                 WebMessage(unsigned char opcode,
+                            const void *prefix,
+                            size_t prefix_bytes,
+                            const void *data,
+                            size_t num_bytes);
+                ~WebMessage();
+
+    int                         m_ref_count;
+    std::vector<unsigned char>  m_bytes;
+};
+
+//-----------------------------------------------------------------------------
+/// A websocket client connected to our WebServer.
+///
+/// Unlike conduit::relay::web::WebSocket, this supports binary frames, 
+/// so we can send encoded images without a base64 / json round trip.
+///
+/// Sends never block: messages are queued and written as the client 
+/// accepts them, when the WebServer is polled. Each socket has its own 
+/// bounded queue, when it is full the oldest message that has not started
+/// sending is dropped, so a slow client only slows itself down.
+///
+/// Text messages from the client are kept (up to a small limit) until 
+/// they are read with NextMessage().
+//-----------------------------------------------------------------------------
+class WebSocket
+{
+public:
+    friend class WebServer;
+
+    bool    SendText(const std::string &msg);
+    bool    SendBinary(const void *data, size_t num_bytes);
+    // queues a shared message, the socket holds its own reference
+    bool    Send(WebMessage *msg);
+
+    // pops the oldest text message received from the client, 
+    // returns false if there are none
+    bool    NextMessage(std::string &msg);
+
+    bool    IsConnected() const;
+
+    // our client only sends small control messages, a frame that 
+    // claims a larger payload closes the connection
+    static const size_t MAX_RECV_PAYLOAD_BYTES = 16384;
+
+    enum FrameStatus
+    {
+        FRAME_OK,
+        FRAME_INCOMPLETE,
+        FRAME_TOO_LARGE
+    };
+
+    struct Frame
+    {
+        unsigned char m_opcode;
+        bool          m_fin;
+        // unmasked
+        std::string   m_payload;
+    };
+
+    // parses the frame at the front of buffer. With FRAME_OK, 
+    // frame_bytes is the number of buffer bytes the frame used.
+    static FrameStatus ParseFrame(const std::string &buffer,
+                                  Frame &frame,
+                                  size_t &frame_bytes);
+
+    // backpressure
+    void    SetMaxQueuedMessages(size_t max_queued);
+    size_t  QueuedMessages() const;
+    // true if a message queued now would not push out an older one
+    bool    CanSend() const;
+
+    // smoothed rate (bytes/sec) this client has been draining data,
+    // counting only time spent waiting on it. 0 if it never made us wait.
+    double  Throughput() const;
+
+private:
+            WebSocket(int fd);
+           ~WebSocket();
+
+    // reads pending bytes from the client and processes any complete frames
+    void    Recv();
+    // writes as much queued data as the client will take
+    void    Flush();
+    bool    HasQueuedData() const;
+    void    Close();
+
+    int                       m_fd;
+    bool                      m_connected;
+    std::string               m_recv_buffer;
+    // text messages from the client that haven't been read yet
+    std::deque<std::string>   m_recv_messages;
+
+    std::deque<WebMessage*>   m_send_queue;
+    size_t                    m_max_queued;
+    // bytes of the front message already written
+    size_t                    m_send_offset;
+    // when the front message started waiting on the client, 0 if not
+    double                    m_send_start;
+    double                    m_sent_bytes;
+    double                    m_sent_seconds;
+};
+
+//-----------------------------------------------------------------------------
+/// Minimal embedded http server that serves the strawman web client and
+/// upgrades websocket requests.
+///
+/// All work happens in Poll(), so the caller controls which thread 
+/// services the clients. Sockets are non-blocking, Poll() also flushes
+/// their send queues as clients accept more data.
+//-----------------------------------------------------------------------------
+class WebServer
+{
+public:
+                WebServer();
+               ~WebServer();
+
+    void        SetDocumentRoot(const std::string &path);
+    void        SetPort(int port);
+
+    // binds + listens, returns false if the port could not be opened
+    bool        Serve();
+    void        Shutdown();
+    bool        IsRunning() const;
+
+    // services pending http requests and websocket traffic, 
+    // waits at most ms_poll milliseconds for activity
+    void        Poll(int ms_poll);
+
+    // interrupts a Poll() that is waiting for activity. 
+    // unlike the other methods, this is safe to call from any thread.
+    void        Wake();
+
+    // returns the first connected websocket, polling every ms_poll
+    // milliseconds for at most ms_timeout milliseconds.
+    // returns NULL if no client connected.
+    WebSocket  *Connection(int ms_poll,
+                           int ms_timeout);
+
+    // all currently connected websockets
+    void        Connections(std::vector<WebSocket*> &sockets);
+
+private:
+    struct HTTPConnection
+    {
+        int         m_fd;
+        std::string m_request;
+    };
+
+    void        Accept();
+    // returns true when the connection has been handled
+    bool        ProcessRequest(HTTPConnection &conn);
+    void        ServeFile(int fd,
+                          const std::string &uri);
+    void        UpgradeToWebSocket(int fd,
+                                   const std::string &key);
+    void        RemoveClosedSockets();
+
+    std::string                  m_doc_root;
+    int                          m_port;
+    int                          m_listen_fd;
+    int                          m_wake_fds[2];
+    std::vector<HTTPConnection>  m_pending;
+    std::vector<WebSocket*>      m_sockets;
+};
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
+
+
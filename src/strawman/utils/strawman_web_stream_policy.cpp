@@ -0,0 +1,366 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_web_stream_policy.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "strawman_web_stream_policy.hpp"
+
+#include <strawman_logging.hpp>
+
+// standard includes
+#include <algorithm>
+
+using namespace conduit;
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+// -- begin strawman::<anon> --
+//-----------------------------------------------------------------------------
+namespace
+{
+
+// used to size the per frame budget when the frame rate is unlimited
+const double NOMINAL_FPS          = 30.0;
+// weight of the newest sample in the smoothed offer interval
+const double SMOOTHING            = 0.2;
+// quality is raised after this many frames that fit the budget with 
+// headroom. failed attempts double the wait, up to the max.
+const int    UPGRADE_FRAMES       = 10;
+const int    MAX_UPGRADE_FRAMES   = 320;
+const double UPGRADE_HEADROOM     = 0.5;
+const int    MAX_DOWNSCALE        = 8;
+
+};
+//-----------------------------------------------------------------------------
+// -- end strawman::<anon> --
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+WebStreamPolicy::WebStreamPolicy()
+:m_prefer_raw(false),
+ m_max_fps(30.0),
+ m_max_bandwidth(0.0),
+ m_level(0),
+ m_frames_at_level(0),
+ m_good_frames(0),
+ m_upgrade_frames(UPGRADE_FRAMES),
+ m_probing(false),
+ m_last_frame_time(0.0),
+ m_last_offer_time(0.0),
+ m_offer_interval(0.0),
+ m_throughput(0.0)
+{
+    BuildLevels();
+}
+
+//-----------------------------------------------------------------------------
+WebStreamPolicy::~WebStreamPolicy()
+{}
+
+//-----------------------------------------------------------------------------
+void
+WebStreamPolicy::SetOptions(const Node &options)
+{
+    bool prefer_raw = m_prefer_raw;
+
+    if(options.has_path("web/format"))
+    {
+        std::string format = options["web/format"].as_string();
+        if(format == "raw")
+        {
+            prefer_raw = true;
+        }
+        else if(format == "png")
+        {
+            prefer_raw = false;
+        }
+        else
+        {
+            STRAWMAN_WARN("Unknown web/format \"" << format << "\","
+                          << " expected \"png\" or \"raw\"");
+        }
+    }
+
+    if(options.has_path("web/max_fps"))
+    {
+        m_max_fps = options["web/max_fps"].to_float64();
+    }
+
+    if(options.has_path("web/max_bandwidth"))
+    {
+        // MB/s -> bytes/s
+        m_max_bandwidth = options["web/max_bandwidth"].to_float64() * 1.0e6;
+    }
+
+    if(prefer_raw != m_prefer_raw)
+    {
+        m_prefer_raw = prefer_raw;
+        BuildLevels();
+        Reset();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+WebStreamPolicy::BuildLevels()
+{
+    m_levels.clear();
+
+    Level level;
+    if(m_prefer_raw)
+    {
+        level.m_raw       = true;
+        level.m_downscale = 1;
+        m_levels.push_back(level);
+    }
+
+    level.m_raw = false;
+    for(int ds = 1; ds <= MAX_DOWNSCALE; ds *= 2)
+    {
+        level.m_downscale = ds;
+        m_levels.push_back(level);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+WebStreamPolicy::FrameOffered(double now)
+{
+    if(m_last_offer_time > 0.0)
+    {
+        double interval = now - m_last_offer_time;
+        if(m_offer_interval <= 0.0)
+        {
+            m_offer_interval = interval;
+        }
+        else
+        {
+            m_offer_interval = (1.0 - SMOOTHING) * m_offer_interval +
+                               SMOOTHING * interval;
+        }
+    }
+
+    m_last_offer_time = now;
+}
+
+//-----------------------------------------------------------------------------
+double
+WebStreamPolicy::NextFrameTime() const
+{
+    if(m_max_fps <= 0.0)
+    {
+        return m_last_frame_time;
+    }
+
+    return m_last_frame_time + 1.0 / m_max_fps;
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebStreamPolicy::FrameDue(double now) const
+{
+    return now >= NextFrameTime();
+}
+
+//-----------------------------------------------------------------------------
+bool
+WebStreamPolicy::UseRaw() const
+{
+    return m_levels[m_level].m_raw;
+}
+
+//-----------------------------------------------------------------------------
+int
+WebStreamPolicy::Downscale() const
+{
+    return m_levels[m_level].m_downscale;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebStreamPolicy::SetThroughput(double throughput)
+{
+    m_throughput = throughput;
+}
+
+//-----------------------------------------------------------------------------
+double
+WebStreamPolicy::Throughput() const
+{
+    return m_throughput;
+}
+
+//-----------------------------------------------------------------------------
+void
+WebStreamPolicy::Reset()
+{
+    SetLevel(0);
+    m_good_frames    = 0;
+    m_upgrade_frames = UPGRADE_FRAMES;
+    m_probing        = false;
+    m_throughput     = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+double
+WebStreamPolicy::FrameInterval() const
+{
+    double fps = m_max_fps > 0.0 ? m_max_fps : NOMINAL_FPS;
+    double interval = 1.0 / fps;
+
+    // no reason to degrade frames the simulation can't produce
+    // any faster anyway
+    if(m_offer_interval > interval)
+    {
+        interval = m_offer_interval;
+    }
+
+    return interval;
+}
+
+//-----------------------------------------------------------------------------
+double
+WebStreamPolicy::FrameBudget() const
+{
+    double rate = m_max_bandwidth;
+
+    if(m_throughput > 0.0 && (rate <= 0.0 || m_throughput < rate))
+    {
+        rate = m_throughput;
+    }
+
+    // no limit and nothing measured yet
+    if(rate <= 0.0)
+    {
+        return -1.0;
+    }
+
+    return rate * FrameInterval();
+}
+
+//-----------------------------------------------------------------------------
+void
+WebStreamPolicy::FrameSent(double now,
+                           size_t num_bytes,
+                           double encode_seconds)
+{
+    m_last_frame_time = now;
+
+    double budget   = FrameBudget();
+    double interval = FrameInterval();
+
+    bool over_budget = (budget >= 0.0 && (double) num_bytes > budget) ||
+                       encode_seconds > interval;
+
+    bool fits = (budget < 0.0 || (double) num_bytes < budget * UPGRADE_HEADROOM) &&
+                encode_seconds < interval * UPGRADE_HEADROOM;
+
+    m_frames_at_level++;
+
+    if(over_budget)
+    {
+        // a probe that failed right away, wait longer before the next one
+        if(m_probing)
+        {
+            m_upgrade_frames = std::min(m_upgrade_frames * 2,
+                                        MAX_UPGRADE_FRAMES);
+        }
+
+        // drop quality right away, a backed up client only gets worse
+        if(m_level + 1 < (int) m_levels.size())
+        {
+            SetLevel(m_level + 1);
+        }
+        m_probing     = false;
+        m_good_frames = 0;
+        return;
+    }
+
+    if(m_probing && m_frames_at_level >= UPGRADE_FRAMES)
+    {
+        // the higher quality held up
+        m_probing        = false;
+        m_upgrade_frames = UPGRADE_FRAMES;
+    }
+
+    if(!fits || m_level == 0)
+    {
+        m_good_frames = 0;
+        return;
+    }
+
+    // we can't predict the next level's cost well (png size, client
+    // buffering) so after enough comfortable frames we simply try it
+    m_good_frames++;
+    if(m_good_frames >= m_upgrade_frames)
+    {
+        SetLevel(m_level - 1);
+        m_probing     = true;
+        m_good_frames = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+WebStreamPolicy::SetLevel(int level)
+{
+    m_level           = level;
+    m_frames_at_level = 0;
+}
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
@@ -0,0 +1,153 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: strawman_web_stream_policy.hpp
+///
+//-----------------------------------------------------------------------------
+#ifndef STRAWMAN_WEB_STREAM_POLICY_HPP
+#define STRAWMAN_WEB_STREAM_POLICY_HPP
+
+#include <vector>
+
+#include <conduit.hpp>
+
+//-----------------------------------------------------------------------------
+// -- begin strawman:: --
+//-----------------------------------------------------------------------------
+namespace strawman
+{
+
+//-----------------------------------------------------------------------------
+/// Decides when a streamed image should be sent and at what quality.
+///
+/// Frames are limited to web/max_fps. The quality is picked from a ladder
+/// that starts at the requested web/format and full resolution, then
+/// switches raw pixels to png and halves the resolution (down to 1/8) 
+/// while the frames do not fit the per frame byte budget, or take longer
+/// than a frame interval to encode. The frame interval is the longer of
+/// 1/max_fps and the interval at which the simulation offers frames. The
+/// byte budget is the smaller of web/max_bandwidth and the measured client
+/// throughput, times the frame interval. After several frames fit 
+/// comfortably, the next level up is tried again. Attempts that fail 
+/// right away double the wait before the next one.
+///
+/// Options:
+///   web/format        : "png" (default) or "raw"
+///   web/max_fps       : frames per second, <= 0 is unlimited (default 30)
+///   web/max_bandwidth : target in MB/s, <= 0 is unlimited (default 0)
+//-----------------------------------------------------------------------------
+class WebStreamPolicy
+{
+public:
+             WebStreamPolicy();
+            ~WebStreamPolicy();
+
+    void     SetOptions(const conduit::Node &options);
+
+    // records that the simulation produced (or could have produced) 
+    // a frame at time `now`
+    void     FrameOffered(double now);
+
+    // true if a frame sent at time `now` (seconds) respects max_fps
+    bool     FrameDue(double now) const;
+    // earliest time the next frame may be sent
+    double   NextFrameTime() const;
+
+    // quality to use for the next frame
+    bool     UseRaw() const;
+    int      Downscale() const;
+
+    // records a sent frame and adapts the quality
+    void     FrameSent(double now,
+                       size_t num_bytes,
+                       double encode_seconds);
+
+    // forget measurements, used when the set of clients changes
+    void     Reset();
+
+    // client throughput in bytes/sec, 0 if unknown
+    void     SetThroughput(double throughput);
+    double   Throughput() const;
+
+private:
+    struct Level
+    {
+        bool m_raw;
+        int  m_downscale;
+    };
+
+    void     BuildLevels();
+    double   FrameBudget() const;
+    double   FrameInterval() const;
+    void     SetLevel(int level);
+
+    bool                 m_prefer_raw;
+    double               m_max_fps;
+    double               m_max_bandwidth;
+
+    std::vector<Level>   m_levels;
+    int                  m_level;
+    int                  m_frames_at_level;
+    int                  m_good_frames;
+    int                  m_upgrade_frames;
+    bool                 m_probing;
+    double               m_last_frame_time;
+    double               m_last_offer_time;
+    double               m_offer_interval;
+    double               m_throughput;
+};
+
+//-----------------------------------------------------------------------------
+};
+//-----------------------------------------------------------------------------
+// -- end strawman:: --
+//-----------------------------------------------------------------------------
+
+#endif
+//-----------------------------------------------------------------------------
+// -- end header ifdef guard
+//-----------------------------------------------------------------------------
+
@@ -43,32 +43,246 @@
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 
 
+//-----------------------------------------------------------------------------
+// Image frames arrive as binary messages with a 40 byte little endian header
+// (see strawman_web_interface.hpp):
+//   magic "SMIF", header size, format (0 = png, 1 = rgba8), width, height,
+//   reserved, cycle (int64), time (float64)
+//-----------------------------------------------------------------------------
+var STRAWMAN_PNG_IMAGE  = 0;
+var STRAWMAN_RGBA_IMAGE = 1;
+
+//-----------------------------------------------------------------------------
+function strawman_parse_frame_header(buffer)
+{
+    var view = new DataView(buffer);
+    
+    if(buffer.byteLength < 40 ||
+       String.fromCharCode(view.getUint8(0),
+                           view.getUint8(1),
+                           view.getUint8(2),
+                           view.getUint8(3)) != "SMIF")
+    {
+        return null;
+    }
+    
+    return { header_bytes: view.getUint32(4,true),
+             format:       view.getUint32(8,true),
+             width:        view.getUint32(12,true),
+             height:       view.getUint32(16,true),
+             // js numbers can't hold a full int64, but they can hold any
+             // cycle a simulation will reach
+             cycle:        view.getUint32(24,true) + 
+                           view.getInt32(28,true) * 4294967296,
+             time:         view.getFloat64(32,true)};
+}
+
+//-----------------------------------------------------------------------------
+function strawman_draw_frame(image, width, height)
+{
+    var canvas = document.getElementById("render_canvas");
+    if(canvas.width != width || canvas.height != height)
+    {
+        canvas.width  = width;
+        canvas.height = height;
+    }
+    
+    var ctx = canvas.getContext("2d");
+    if(image instanceof ImageData)
+    {
+        ctx.putImageData(image,0,0);
+    }
+    else
+    {
+        ctx.drawImage(image,0,0);
+    }
+    $("#render_display").show();
+}
+
+//-----------------------------------------------------------------------------
+function strawman_display_frame(buffer)
+{
+    var header = strawman_parse_frame_header(buffer);
+    
+    if(header == null)
+    {
+        console.log("Ignoring binary message without a strawman frame header");
+        return;
+    }
+
+    $("#frame_info").html("<b>cycle:</b> " + header.cycle + 
+                          " <b>size:</b> " + header.width + "x" + header.height);
+
+    if(header.format == STRAWMAN_RGBA_IMAGE)
+    {
+        var pixels = new Uint8ClampedArray(buffer,
+                                           header.header_bytes,
+                                           header.width * header.height * 4);
+        strawman_draw_frame(new ImageData(pixels, header.width, header.height),
+                            header.width,
+                            header.height);
+    }
+    else if(header.format == STRAWMAN_PNG_IMAGE)
+    {
+        var blob = new Blob([new Uint8Array(buffer,header.header_bytes)],
+                            {type: "image/png"});
+
+        if(window.createImageBitmap)
+        {
+            createImageBitmap(blob).then(function(bitmap)
+            {
+                strawman_draw_frame(bitmap, bitmap.width, bitmap.height);
+                bitmap.close();
+            });
+        }
+        else
+        {
+            var url = URL.createObjectURL(blob);
+            var img = new Image();
+            img.onload = function()
+            {
+                strawman_draw_frame(img, img.width, img.height);
+                URL.revokeObjectURL(url);
+            }
+            img.src = url;
+        }
+    }
+    else
+    {
+        console.log("Unknown strawman image format: " + header.format);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Camera steering: drag to orbit, shift + drag (or right drag) to pan, 
+// wheel to zoom and double click to reset. The view is sent relative to 
+// the camera picked by the simulation's actions, strawman applies the 
+// newest one the next time it renders.
+//-----------------------------------------------------------------------------
+var strawman_camera = { azimuth: 0.0, elevation: 0.0, zoom: 1.0, xpan: 0.0, ypan: 0.0 };
+var strawman_camera_pending = false;
+
+//-----------------------------------------------------------------------------
+function strawman_send_camera()
+{
+    // send at most one update per animation frame, the 
+    // server only keeps the newest one anyway
+    if(strawman_camera_pending)
+    {
+        return;
+    }
+    strawman_camera_pending = true;
+
+    window.requestAnimationFrame(function()
+    {
+        strawman_camera_pending = false;
+        if(typeof connection === "undefined" ||
+           connection.readyState != WebSocket.OPEN)
+        {
+            return;
+        }
+        connection.send(JSON.stringify({type: "camera", 
+                                        data: strawman_camera}));
+    });
+}
+
+//-----------------------------------------------------------------------------
+function strawman_camera_controls()
+{
+    var canvas = document.getElementById("render_canvas");
+    var drag   = null;
+
+    canvas.addEventListener("contextmenu", function(evt)
+    {
+        evt.preventDefault();
+    });
+
+    canvas.addEventListener("mousedown", function(evt)
+    {
+        drag = { x: evt.clientX,
+                 y: evt.clientY,
+                 pan: evt.shiftKey || evt.button == 2 };
+        evt.preventDefault();
+    });
+
+    window.addEventListener("mouseup", function(evt)
+    {
+        drag = null;
+    });
+
+    window.addEventListener("mousemove", function(evt)
+    {
+        if(drag == null)
+        {
+            return;
+        }
+
+        var dx = evt.clientX - drag.x;
+        var dy = evt.clientY - drag.y;
+        drag.x = evt.clientX;
+        drag.y = evt.clientY;
+
+        if(drag.pan)
+        {
+            // pan is in normalized screen space, which spans 2 units
+            strawman_camera.xpan += 2.0 * dx / canvas.clientWidth;
+            strawman_camera.ypan -= 2.0 * dy / canvas.clientHeight;
+        }
+        else
+        {
+            strawman_camera.azimuth   -= 0.5 * dx;
+            strawman_camera.elevation += 0.5 * dy;
+            strawman_camera.elevation  = Math.max(-89.0, 
+                                          Math.min(89.0, strawman_camera.elevation));
+        }
+        strawman_send_camera();
+    });
+
+    canvas.addEventListener("wheel", function(evt)
+    {
+        strawman_camera.zoom *= (evt.deltaY < 0) ? 1.1 : 1.0 / 1.1;
+        strawman_send_camera();
+        evt.preventDefault();
+    });
+
+    canvas.addEventListener("dblclick", function(evt)
+    {
+        strawman_camera = { azimuth: 0.0, elevation: 0.0, zoom: 1.0, xpan: 0.0, ypan: 0.0 };
+        strawman_send_camera();
+    });
+}
+
+//-----------------------------------------------------------------------------
 function strawman_websocket_client()
 {
     var wsproto = (location.protocol === 'https:') ? 'wss:' : 'ws:';
     connection = new WebSocket(wsproto + '//' + window.location.host + '/websocket');
+    // deliver binary messages as ArrayBuffers so we can use DataView
+    connection.binaryType = "arraybuffer";
     
-    connection.onmessage = function (json) 
+    connection.onmessage = function (evt) 
     {
         $("#status_label").html('<span class="label label-success">Connected</span>')
+        $("#connection_info").html('<span class="label label-success">Connected</span>');
+
+        if(evt.data instanceof ArrayBuffer)
+        {
+            strawman_display_frame(evt.data);
+            return;
+        }
+
         var msg;
         try
         {
-            msg=JSON.parse(json.data);
+            msg=JSON.parse(evt.data);
         }
         catch(e)
         {
             console.log(e);
+            return;
         }
 
-        if(msg.type == "image")
-        {
-            $("#render_display").html("<img src='" + msg.data + "' width=500 height=500/>");
-            $("#render_display").show();
-
-            $("#connection_info").html('<span class="label label-success">Connected</span>');
-        }
-        else if(msg.type == "status")
+        if(msg.type == "status")
         {
             $("#status").html("<b>[Simulation State]</b><br><b>time:</b> " + msg.data.time.toFixed(6)  + " <br> <b>cycle:</b> " + msg.data.cycle);
 
@@ -98,12 +312,14 @@ function strawman_websocket_client()
         connection.close();
         $("#connection_info").html('<span class="label label-warning">Not Connected</span>');
         // this allows infinite reconnect ...
-        strawman_websocket_client();
+        strawman_camera_controls();
+strawman_websocket_client();
     }
 
     
 }
 
+strawman_camera_controls();
 strawman_websocket_client();
 
 
@@ -0,0 +1,308 @@
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+// Copyright (c) 2015-2017, Lawrence Livermore National Security, LLC.
+// 
+// Produced at the Lawrence Livermore National Laboratory
+// 
+// LLNL-CODE-716457
+// 
+// All rights reserved.
+// 
+// This file is part of Strawman. 
+// 
+// For details, see: http://software.llnl.gov/strawman/.
+// 
+// Please also read strawman/LICENSE
+// 
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+// 
+// * Redistributions of source code must retain the above copyright notice, 
+//   this list of conditions and the disclaimer below.
+// 
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the disclaimer (as noted below) in the
+//   documentation and/or other materials provided with the distribution.
+// 
+// * Neither the name of the LLNS/LLNL nor the names of its contributors may
+//   be used to endorse or promote products derived from this software without
+//   specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL LAWRENCE LIVERMORE NATIONAL SECURITY,
+// LLC, THE U.S. DEPARTMENT OF ENERGY OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+// POSSIBILITY OF SUCH DAMAGE.
+// 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+//-----------------------------------------------------------------------------
+///
+/// file: t_strawman_block_timer.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <strawman_block_timer.hpp>
+#include <strawman_memory_tracker.hpp>
+#include <strawman_perf_counters.hpp>
+
+#include <conduit.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "t_config.hpp"
+
+
+using namespace std;
+using namespace conduit;
+using namespace strawman;
+
+//-----------------------------------------------------------------------------
+void
+timed_inner()
+{
+    STRAWMAN_BLOCK_TIMER(INNER);
+    usleep(1000);
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_block_timer, nested_scopes)
+{
+    EXPECT_EQ(BlockTimer::InternName("OUTER"), 
+              BlockTimer::InternName("OUTER"));
+
+    for(int i = 0; i < 3; ++i)
+    {
+        STRAWMAN_BLOCK_TIMER(OUTER);
+        timed_inner();
+        timed_inner();
+    }
+
+    // the c api path, by name
+    BlockTimer::StartTimer("OUTER");
+    BlockTimer::StopTimer("OUTER");
+
+    Node &timings = BlockTimer::Finalize();
+    timings.print();
+
+    EXPECT_EQ(timings["children/OUTER/count"].to_uint32(), 4u);
+    EXPECT_EQ(timings["children/OUTER/children/INNER/count"].to_uint32(), 6u);
+    // times are averaged per call
+    EXPECT_GE(timings["children/OUTER/children/INNER/mean"].to_float64(),
+              0.001);
+    // a single rank has no spread
+    EXPECT_EQ(timings["children/OUTER/ranks"].to_int(), 1);
+    EXPECT_EQ(timings["children/OUTER/stddev"].to_float64(), 0.0);
+    EXPECT_EQ(timings["children/OUTER/max_rank"].to_int(), 0);
+    // INNER only ran inside OUTER
+    EXPECT_FALSE(timings.has_path("children/INNER"));
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_block_timer, mismatched_stops)
+{
+    EXPECT_NE(BlockTimer::InternName("OPEN"), 
+              BlockTimer::InternName("CLOSED"));
+
+    // closing OPEN also closes the timer started inside it, 
+    // which is dropped
+    BlockTimer::StartTimer("OPEN");
+    BlockTimer::StartTimer("LEAKED");
+    BlockTimer::StopTimer("OPEN");
+    // not running, ignored
+    BlockTimer::StopTimer("CLOSED");
+
+    // the stack is balanced again
+    STRAWMAN_TIMER_START(AFTER_MISMATCH);
+    timed_inner();
+    STRAWMAN_TIMER_STOP(AFTER_MISMATCH);
+
+    Node &timings = BlockTimer::Finalize();
+    EXPECT_EQ(timings["children/OPEN/count"].to_uint32(), 1u);
+    EXPECT_FALSE(timings.has_path("children/OPEN/children/LEAKED"));
+    EXPECT_FALSE(timings.has_path("children/CLOSED"));
+    EXPECT_EQ(timings["children/AFTER_MISMATCH/count"].to_uint32(), 1u);
+    EXPECT_EQ(timings["children/AFTER_MISMATCH/children/INNER/count"].to_uint32(),
+              1u);
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_block_timer, memory_tracking)
+{
+    const size_t num_bytes = 4 * 1024 * 1024;
+    void *buffer = NULL;
+    {
+        STRAWMAN_BLOCK_TIMER(TRACKED_ALLOC);
+        buffer = MemoryTracker::Allocate(num_bytes);
+        memset(buffer, 1, num_bytes);
+    }
+    EXPECT_GE(MemoryTracker::TrackedBytes(), num_bytes);
+
+    Node &timings = BlockTimer::Finalize();
+    // in MB, per call
+    EXPECT_NEAR(timings["children/TRACKED_ALLOC/tracked_delta"].to_float64(),
+                4.0,
+                1e-9);
+    EXPECT_GT(timings["children/TRACKED_ALLOC/mem_peak"].to_float64(), 0.0);
+
+    MemoryTracker::Free(buffer);
+    EXPECT_GE(MemoryTracker::TrackedPeakBytes(), num_bytes);
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_block_timer, hardware_counters)
+{
+    PerfCounters::Enable();
+    for(int i = 0; i < 2; ++i)
+    {
+        STRAWMAN_BLOCK_TIMER(COUNTED);
+        timed_inner();
+    }
+    PerfCounters::Disable();
+
+    // without perf events we still get the timings
+    Node &timings = BlockTimer::Finalize();
+    EXPECT_EQ(timings["children/COUNTED/count"].to_uint32(), 2u);
+    if(timings.has_path("children/COUNTED/counters/instructions"))
+    {
+        EXPECT_GT(timings["children/COUNTED/counters/instructions"].to_float64(),
+                  0.0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void *
+timed_worker(void *)
+{
+    for(int i = 0; i < 10; ++i)
+    {
+        STRAWMAN_BLOCK_TIMER(WORKER);
+        timed_inner();
+    }
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_block_timer, threads)
+{
+    const int num_threads = 4;
+    pthread_t threads[num_threads];
+    for(int i = 0; i < num_threads; ++i)
+    {
+        pthread_create(&threads[i], NULL, timed_worker, NULL);
+    }
+    for(int i = 0; i < num_threads; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    Node &timings = BlockTimer::Finalize();
+    // each worker has its own stack, the scopes merge by path
+    EXPECT_EQ(timings["children/WORKER/count"].to_uint32(), 40u);
+    EXPECT_EQ(timings["children/WORKER/children/INNER/count"].to_uint32(),
+              40u);
+    EXPECT_EQ(timings["children/WORKER/threads"].to_int(), num_threads);
+    EXPECT_GE(timings["children/WORKER/thread_imbalance"].to_float64(), 1.0);
+}
+
+//-----------------------------------------------------------------------------
+void *
+scope_worker(void *)
+{
+    // new scopes keep adding records while the main thread reads totals
+    char name[32];
+    for(int i = 0; i < 200; ++i)
+    {
+        snprintf(name, sizeof(name), "SCOPE_%d", i);
+        BlockTimer::StartTimer(name);
+        BlockTimer::StopTimer(name);
+    }
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_block_timer, totals_while_timing)
+{
+    const int num_threads = 4;
+    pthread_t threads[num_threads];
+    for(int i = 0; i < num_threads; ++i)
+    {
+        pthread_create(&threads[i], NULL, scope_worker, NULL);
+    }
+
+    std::map<std::string, double> totals;
+    for(int i = 0; i < 100; ++i)
+    {
+        BlockTimer::ScopeTotals(totals);
+    }
+
+    for(int i = 0; i < num_threads; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    BlockTimer::ScopeTotals(totals);
+    EXPECT_EQ(totals.count("SCOPE_0"), 1u);
+    EXPECT_EQ(totals.count("SCOPE_199"), 1u);
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_block_timer, write_trace)
+{
+    const int capacity = 8;
+    BlockTimer::EnableTrace(capacity);
+    EXPECT_TRUE(BlockTimer::TraceEnabled());
+
+    // more events than the ring holds, only the last ones are written
+    for(int i = 0; i < 3 * capacity; ++i)
+    {
+        STRAWMAN_BLOCK_TIMER(TRACED);
+    }
+
+    string trace_file = conduit::utils::join_file_path(STRAWMAN_T_BIN_DIR,
+                                                       "tout_block_timer_trace.json");
+    if(conduit::utils::is_file(trace_file))
+    {
+        conduit::utils::remove_file(trace_file);
+    }
+
+    BlockTimer::WriteTrace(trace_file);
+    BlockTimer::DisableTrace();
+    EXPECT_FALSE(BlockTimer::TraceEnabled());
+
+    ASSERT_TRUE(conduit::utils::is_file(trace_file));
+
+    ifstream ifs(trace_file.c_str());
+    stringstream json;
+    json << ifs.rdbuf();
+
+    Node trace;
+    Generator(json.str(), "json").walk(trace);
+
+    // the process_name metadata plus one complete event per slot
+    ASSERT_TRUE(trace.dtype().is_list());
+    ASSERT_EQ(trace.number_of_children(), capacity + 1);
+    EXPECT_EQ(trace.child(0)["ph"].as_string(), "M");
+
+    for(int i = 1; i < capacity + 1; ++i)
+    {
+        const Node &event = trace.child(i);
+        EXPECT_EQ(event["ph"].as_string(), "X");
+        EXPECT_EQ(event["name"].as_string(), "TRACED");
+        EXPECT_GE(event["ts"].to_float64(), 0.0);
+        EXPECT_GE(event["dur"].to_float64(), 0.0);
+    }
+}
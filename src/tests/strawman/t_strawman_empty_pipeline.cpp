@@ -53,6 +53,7 @@
 #include <strawman.hpp>
 
 #include <iostream>
+#include <fstream>
 #include <math.h>
 #include <sstream>
 
@@ -98,3 +99,171 @@ TEST(strawman_empty_pipeline, test_empty_pipeline)
     sman.Close();
 }
 
+
+//-----------------------------------------------------------------------------
+TEST(strawman_empty_pipeline, test_empty_pipeline_metrics)
+{
+    Node data;
+    conduit::blueprint::mesh::examples::braid("quads",10,10,0,data);
+
+    Node actions;
+    Node &hello = actions.append();
+    hello["action"]   = "hello!";
+
+    string output_path = prepare_output_dir();
+    string output_file = conduit::utils::join_file_path(output_path,
+                                                        "tout_metrics.jsonl");
+
+    Node open_opts;
+    open_opts["pipeline/type"]          = "empty";
+    open_opts["metrics/enabled"]        = "true";
+    open_opts["metrics/file"]           = output_file;
+    open_opts["metrics/history"]        = 2;
+    open_opts["metrics/flush_interval"] = 3;
+
+    Strawman sman;
+    sman.Open(open_opts);
+    for(int cycle = 0; cycle < 5; ++cycle)
+    {
+        data["state/cycle"] = cycle * 10;
+        sman.Publish(data);
+        Metrics::Add("test_bytes", 100);
+        sman.Execute(actions);
+    }
+
+    Node info;
+    sman.Info(info);
+    info["metrics/last"].print();
+    EXPECT_EQ(info["metrics/last/cycle"].to_int64(), 40);
+    EXPECT_EQ(info["metrics/last/execute"].to_int(), 4);
+    // counters start over with each snapshot
+    EXPECT_EQ(info["metrics/last/counters/test_bytes"].to_float64(), 100.0);
+    sman.Close();
+
+    // the history is shorter than the flush interval, nothing is lost
+    ifstream ifs(output_file.c_str());
+    string line;
+    int lines = 0;
+    while(getline(ifs, line))
+    {
+        lines++;
+    }
+    EXPECT_EQ(lines, 5);
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_empty_pipeline, test_empty_pipeline_action_plan)
+{
+    Node data;
+    conduit::blueprint::mesh::examples::braid("quads",10,10,0,data);
+
+    Node actions;
+    Node &hello = actions.append();
+    hello["action"]   = "hello!";
+
+    Node open_opts;
+    open_opts["pipeline/type"] = "empty";
+
+    Strawman sman;
+    sman.Open(open_opts);
+    Node info;
+    for(int cycle = 0; cycle < 3; ++cycle)
+    {
+        data["state/cycle"] = cycle;
+        sman.Publish(data);
+        sman.Execute(actions);
+    }
+    // the same actions every cycle are compiled once
+    sman.Info(info);
+    EXPECT_EQ(info["action_plan/compiles"].to_int(), 1);
+    EXPECT_EQ(info["action_plan/steps"].to_int(), 1);
+
+    Node &again = actions.append();
+    again["action"]   = "hello again!";
+    sman.Execute(actions);
+    sman.Info(info);
+    EXPECT_EQ(info["action_plan/compiles"].to_int(), 2);
+    EXPECT_EQ(info["action_plan/steps"].to_int(), 2);
+    sman.Close();
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_empty_pipeline, test_empty_pipeline_triggers)
+{
+    Node data;
+    conduit::blueprint::mesh::examples::braid("quads",10,10,0,data);
+
+    Node actions;
+    Node &hello = actions.append();
+    hello["action"] = "hello!";
+    hello["trigger/cycle_stride"] = 3;
+
+    Node &threshold = actions.append();
+    threshold["action"] = "hello threshold!";
+    threshold["trigger/field"] = "braid";
+    threshold["trigger/above"] = 1e30;
+
+    Node open_opts;
+    open_opts["pipeline/type"] = "empty";
+
+    Strawman sman;
+    sman.Open(open_opts);
+    for(int cycle = 0; cycle < 9; ++cycle)
+    {
+        data["state/cycle"] = cycle;
+        {
+            // only the arrays have to outlive Publish, not the node 
+            // that describes them
+            Node published;
+            published.set_external(data);
+            sman.Publish(published);
+        }
+        sman.Execute(actions);
+    }
+
+    // the stride fires on cycles 0, 3 and 6, the threshold never does
+    Node info;
+    sman.Info(info);
+    EXPECT_EQ(info["triggers/skipped"].to_int(), 6);
+    sman.Close();
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_empty_pipeline, test_empty_pipeline_triggers_action_plan)
+{
+    Node data;
+    conduit::blueprint::mesh::examples::braid("quads",10,10,0,data);
+
+    Node actions;
+    Node &every_2 = actions.append();
+    every_2["action"] = "hello every 2!";
+    every_2["trigger/cycle_stride"] = 2;
+
+    Node &every_3 = actions.append();
+    every_3["action"] = "hello every 3!";
+    every_3["trigger/cycle_stride"] = 3;
+
+    Node &always = actions.append();
+    always["action"] = "hello!";
+
+    Node open_opts;
+    open_opts["pipeline/type"] = "empty";
+
+    Strawman sman;
+    sman.Open(open_opts);
+    for(int cycle = 0; cycle < 6; ++cycle)
+    {
+        data["state/cycle"] = cycle;
+        sman.Publish(data);
+        sman.Execute(actions);
+    }
+
+    // a different set of actions fires on each cycle, the plan for all
+    // of them is still only compiled once
+    Node info;
+    sman.Info(info);
+    EXPECT_EQ(info["action_plan/compiles"].to_int(), 1);
+    EXPECT_EQ(info["action_plan/steps"].to_int(), 3);
+    EXPECT_EQ(info["triggers/skipped"].to_int(), 0);
+    sman.Close();
+}
@@ -51,11 +51,13 @@
 #include "gtest/gtest.h"
 
 #include <strawman.hpp>
+#include <strawman_replay.hpp>
 #include <iostream>
 #include <math.h>
 
 
 #include <mpi.h>
+#include <conduit_relay.hpp>
 
 #include "t_config.hpp"
 #include "t_strawman_test_utils.hpp"
@@ -127,6 +129,317 @@ TEST(strawman_test_3d, test_3d_parallel_render_default_pipeline)
     
 }
 
+//-----------------------------------------------------------------------------
+TEST(strawman_test_3d, test_3d_parallel_save_aggregated)
+{
+    int par_rank;
+    int par_size;
+    MPI_Comm comm = MPI_COMM_WORLD;
+    MPI_Comm_rank(comm, &par_rank);
+    MPI_Comm_size(comm, &par_size);
+
+    Node data;
+    create_3d_example_dataset(data, par_rank, par_size);
+
+    string output_path = "";
+    if(par_rank == 0)
+    {
+        output_path = prepare_output_dir();
+    }
+    else
+    {
+        output_path = output_dir();
+    }
+    
+    output_path = conduit::utils::join_file_path(output_path,
+                                                 "test_mpi_save_hdf5_agg");
+
+    // all domains go to a single file
+    Node actions;
+    Node &save = actions.append();
+    save["action"]      = "save";
+    save["output_path"] = output_path;
+    save["num_files"]   = 1;
+    
+    Strawman sman;
+    Node opts;
+    opts["mpi_comm"] = MPI_Comm_c2f(comm);
+    opts["pipeline/type"] = "blueprint_hdf5";
+    sman.Open(opts);
+    sman.Publish(data);
+    sman.Execute(actions);
+    sman.Close();
+
+    MPI_Barrier(comm);
+
+    string output_dir = output_path + ".cycle_000000";
+    EXPECT_TRUE(conduit::utils::is_file(output_path + ".cycle_000000.root"));
+    EXPECT_TRUE(conduit::utils::is_file(
+        conduit::utils::join_file_path(output_dir, "file_000000.hdf5")));
+    EXPECT_FALSE(conduit::utils::is_file(
+        conduit::utils::join_file_path(output_dir, "domain_000000.hdf5")));
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_3d, test_3d_parallel_save_shared_file)
+{
+    int par_rank;
+    int par_size;
+    MPI_Comm comm = MPI_COMM_WORLD;
+    MPI_Comm_rank(comm, &par_rank);
+    MPI_Comm_size(comm, &par_size);
+
+    Node data;
+    create_3d_example_dataset(data, par_rank, par_size);
+
+    string output_path = "";
+    if(par_rank == 0)
+    {
+        output_path = prepare_output_dir();
+    }
+    else
+    {
+        output_path = output_dir();
+    }
+    
+    output_path = conduit::utils::join_file_path(output_path,
+                                                 "test_mpi_save_hdf5_shared");
+
+    Node actions;
+    Node &save = actions.append();
+    save["action"]      = "save";
+    save["output_path"] = output_path;
+    save["shared_file"] = "true";
+    
+    Strawman sman;
+    Node opts;
+    opts["mpi_comm"] = MPI_Comm_c2f(comm);
+    opts["pipeline/type"] = "blueprint_hdf5";
+    sman.Open(opts);
+    sman.Publish(data);
+    sman.Execute(actions);
+    sman.Close();
+
+    MPI_Barrier(comm);
+
+    string output_dir = output_path + ".cycle_000000";
+    string shared_file = conduit::utils::join_file_path(output_dir,
+                                                        "file_000000.hdf5");
+    EXPECT_TRUE(conduit::utils::is_file(output_path + ".cycle_000000.root"));
+    EXPECT_TRUE(conduit::utils::is_file(shared_file));
+
+    if(par_size > 1)
+    {
+        // our domain's tree reads back like any other hdf5 file
+        char tree_name[64];
+        snprintf(tree_name, sizeof(tree_name), "domain_%06d", par_rank);
+
+        Node n_load, n_diff;
+        conduit::relay::io::load(shared_file, n_load);
+        EXPECT_FALSE(n_load[tree_name]["fields"].diff(data["fields"], n_diff));
+    }
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_3d, test_3d_parallel_save_index)
+{
+    int par_rank;
+    int par_size;
+    MPI_Comm comm = MPI_COMM_WORLD;
+    MPI_Comm_rank(comm, &par_rank);
+    MPI_Comm_size(comm, &par_size);
+
+    Node data;
+    create_3d_example_dataset(data, par_rank, par_size);
+
+    // a field only the last domain has
+    if(par_rank == par_size - 1)
+    {
+        data["fields/last_only"].set(data["fields/radial"]);
+    }
+
+    string output_path = "";
+    if(par_rank == 0)
+    {
+        output_path = prepare_output_dir();
+    }
+    else
+    {
+        output_path = output_dir();
+    }
+    
+    output_path = conduit::utils::join_file_path(output_path,
+                                                 "test_mpi_save_hdf5_index");
+
+    Node actions;
+    Node &save = actions.append();
+    save["action"]      = "save";
+    save["output_path"] = output_path;
+    
+    Strawman sman;
+    Node opts;
+    opts["mpi_comm"] = MPI_Comm_c2f(comm);
+    opts["pipeline/type"] = "blueprint_hdf5";
+    sman.Open(opts);
+    sman.Publish(data);
+    sman.Execute(actions);
+    sman.Close();
+
+    MPI_Barrier(comm);
+
+    if(par_rank == 0)
+    {
+        Node root;
+        conduit::relay::io::load(output_path + ".cycle_000000.root", 
+                                 "hdf5",
+                                 root);
+        root.print();
+        Node &bp_idx = root["blueprint_index/mesh"];
+        EXPECT_TRUE(bp_idx.has_path("fields/braid"));
+        EXPECT_TRUE(bp_idx.has_path("fields/last_only"));
+        EXPECT_EQ(bp_idx["state/number_of_domains"].to_int(), par_size);
+
+        Node &summary = root["domain_summary"];
+        EXPECT_EQ(summary["domain_id"].dtype().number_of_elements(), 
+                  (index_t) par_size);
+        EXPECT_EQ(summary["coordsets/coords/bounds"].dtype().number_of_elements(),
+                  (index_t) (6 * par_size));
+        EXPECT_EQ(summary["fields/braid/range"].dtype().number_of_elements(),
+                  (index_t) (2 * par_size));
+        // only the last domain has a range for last_only
+        float64 *range = summary["fields/last_only/range"].value();
+        EXPECT_TRUE(range[0] != range[0] || par_size == 1);
+        EXPECT_TRUE(range[2 * (par_size - 1)] <= range[2 * (par_size - 1) + 1]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// our domain of the 3d example, with values that differ from cycle to cycle
+//-----------------------------------------------------------------------------
+void
+create_replay_cycle(int cycle, int par_rank, int par_size, Node &data)
+{
+    data.reset();
+    create_3d_example_dataset(data, par_rank, par_size);
+    data["state/cycle"] = (uint64) cycle;
+
+    float64 *vals = data["fields/braid/values"].as_float64_ptr();
+    index_t num_vals = data["fields/braid/values"].dtype().number_of_elements();
+    for(index_t i = 0; i < num_vals; ++i)
+    {
+        vals[i] += (float64) cycle;
+    }
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_3d, test_3d_parallel_replay)
+{
+    int par_rank;
+    int par_size;
+    MPI_Comm comm = MPI_COMM_WORLD;
+    MPI_Comm_rank(comm, &par_rank);
+    MPI_Comm_size(comm, &par_size);
+
+    const int num_cycles = 3;
+
+    // file per domain, and all domains aggregated into one file
+    const char *modes[2] = {"domain", "aggregated"};
+
+    for(int m = 0; m < 2; ++m)
+    {
+        string mode = modes[m];
+        string output_path = "";
+        if(par_rank == 0)
+        {
+            output_path = prepare_output_dir();
+        }
+        else
+        {
+            output_path = output_dir();
+        }
+
+        output_path = conduit::utils::join_file_path(output_path,
+                                                     "test_mpi_replay_" + mode);
+
+        Node actions;
+        Node &save = actions.append();
+        save["action"]      = "save";
+        save["output_path"] = output_path;
+        if(mode == "aggregated")
+        {
+            save["num_files"] = 1;
+        }
+
+        Node opts;
+        opts["mpi_comm"] = MPI_Comm_c2f(comm);
+        opts["pipeline/type"] = "blueprint_hdf5";
+
+        Node data;
+        Strawman sman;
+        sman.Open(opts);
+        for(int c = 0; c < num_cycles; ++c)
+        {
+            create_replay_cycle(c, par_rank, par_size, data);
+            sman.Publish(data);
+            sman.Execute(actions);
+        }
+        sman.Close();
+
+        MPI_Barrier(comm);
+
+        // replay the cycles into file per domain saves we can compare
+        string replay_path = output_path + "_replay";
+
+        Node replay_opts;
+        for(int c = 0; c < num_cycles; ++c)
+        {
+            char root_file[64];
+            snprintf(root_file, sizeof(root_file), ".cycle_%06d.root", c);
+            replay_opts["root_files"].append() = output_path + root_file;
+        }
+        replay_opts["mpi_comm"] = MPI_Comm_c2f(comm);
+        replay_opts["strawman_options/pipeline/type"] = "blueprint_hdf5";
+        Node &resave = replay_opts["actions"].append();
+        resave["action"]      = "save";
+        resave["output_path"] = replay_path;
+
+        Replay replay;
+        replay.Run(replay_opts);
+
+        MPI_Barrier(comm);
+
+        const Node &timings = replay.Timings();
+        EXPECT_TRUE(timings.has_path("total/load"));
+        EXPECT_EQ(timings["cycles"].number_of_children(), (index_t) num_cycles);
+
+        for(int c = 0; c < num_cycles; ++c)
+        {
+            const Node &cycle = timings["cycles"][c];
+            EXPECT_TRUE(cycle.has_child("load"));
+            EXPECT_TRUE(cycle.has_child("publish"));
+            EXPECT_TRUE(cycle.has_child("execute"));
+
+            char cycle_dir[64];
+            snprintf(cycle_dir, sizeof(cycle_dir), ".cycle_%06d", c);
+            char domain_file[64];
+            snprintf(domain_file, sizeof(domain_file), 
+                     "domain_%06d.hdf5", par_rank);
+
+            Node n_load, n_diff;
+            conduit::relay::io::load(
+                conduit::utils::join_file_path(replay_path + cycle_dir,
+                                               domain_file),
+                n_load);
+
+            create_replay_cycle(c, par_rank, par_size, data);
+            EXPECT_EQ(n_load["state/cycle"].to_int(), c);
+            EXPECT_EQ(n_load["state/domain_id"].to_int(), par_rank);
+            EXPECT_FALSE(n_load["coordsets"].diff(data["coordsets"], n_diff));
+            EXPECT_FALSE(n_load["fields"].diff(data["fields"], n_diff));
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {
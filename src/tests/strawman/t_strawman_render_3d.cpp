@@ -351,6 +351,70 @@ TEST(strawman_render_3d, test_render_3d_render_vtkm_serial_backend)
 
 
 
+//-----------------------------------------------------------------------------
+TEST(strawman_render_3d, test_render_3d_render_vtkm_budget)
+{
+    Node n;
+    strawman::about(n);
+    // only run this test if strawman was built with vtkm support
+    if(n["pipelines/vtkm/status"].as_string() == "disabled")
+    {
+        STRAWMAN_INFO("VTKm support disabled, skipping 3D VTKm budget test");
+        return;
+    }
+
+    Node data;
+    conduit::blueprint::mesh::examples::braid("hexs",
+                                              EXAMPLE_MESH_SIDE_DIM,
+                                              EXAMPLE_MESH_SIDE_DIM,
+                                              EXAMPLE_MESH_SIDE_DIM,
+                                              data);
+
+    string output_path = prepare_output_dir();
+    string output_file = conduit::utils::join_file_path(output_path, "tout_render_3d_vtkm_budget");
+    string metrics_file = conduit::utils::join_file_path(output_path, "tout_render_3d_vtkm_budget.jsonl");
+
+    remove_test_image(output_file);
+
+    Node actions;
+    Node &plot = actions.append();
+    plot["action"]     = "add_plot";
+    plot["field_name"] = "braid";
+
+    Node &opts = plot["render_options"];
+    opts["width"]  = 500;
+    opts["height"] = 500;
+    opts["file_name"] = output_file;
+
+    actions.append()["action"] = "draw_plots";
+
+    // a budget no render can meet drives the quality to min_scale
+    Node open_opts;
+    open_opts["pipeline/type"]    = "vtkm";
+    open_opts["pipeline/backend"] = "serial";
+    open_opts["budget/seconds"]   = 1e-6;
+    open_opts["budget/min_scale"] = 0.25;
+    open_opts["metrics/enabled"]  = "true";
+    open_opts["metrics/file"]     = metrics_file;
+
+    Strawman sman;
+    sman.Open(open_opts);
+    for(int cycle = 0; cycle < 3; ++cycle)
+    {
+        data["state/cycle"] = cycle;
+        sman.Publish(data);
+        sman.Execute(actions);
+    }
+
+    Node info;
+    sman.Info(info);
+    EXPECT_NEAR(info["metrics/last/counters/budget_scale"].to_float64(), 0.25, 1e-6);
+    sman.Close();
+
+    EXPECT_TRUE(check_test_image(output_file));
+}
+
+
 //-----------------------------------------------------------------------------
 TEST(strawman_render_3d, test_render_3d_render_vtkm_tbb_backend)
 {
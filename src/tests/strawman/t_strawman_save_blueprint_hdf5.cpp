@@ -51,12 +51,17 @@
 #include "gtest/gtest.h"
 
 #include <strawman.hpp>
+#include <strawman_raw_file.hpp>
+#include <strawman_lossy_codec.hpp>
+#include <strawman_replay.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <math.h>
 #include <sstream>
 
 #include <conduit_blueprint.hpp>
+#include <conduit_relay.hpp>
 
 #include "t_config.hpp"
 #include "t_strawman_test_utils.hpp"
@@ -106,3 +111,394 @@ TEST(strawman_test_2d_hdf5, test_2d_serial_hdf5_pipeline)
 
 }
 
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_2d_hdf5, test_2d_serial_hdf5_pipeline_async)
+{
+    Node data, verify_info;
+    conduit::blueprint::mesh::examples::braid("quads",100,100,0,data);
+    data["state/domain_id"] = (uint64) 0;
+    data["state/cycle"]     = (uint64) 0;
+    
+    EXPECT_TRUE(conduit::blueprint::mesh::verify(data,verify_info));
+
+    string output_path = prepare_output_dir();
+    output_path = conduit::utils::join_file_path(output_path,
+                                                 "test_save_hdf5_async");
+
+    Node actions;
+    Node &save = actions.append();
+    save["action"]      = "save";
+    save["output_path"] = output_path;
+    save["async"]       = "true";
+    actions.append()["action"] = "wait_for_saves";
+    actions.print();
+
+    Node open_opts;
+    open_opts["pipeline/type"] = "blueprint_hdf5";
+    
+    Strawman sman;
+    sman.Open(open_opts);
+    sman.Publish(data);
+    sman.Execute(actions);
+
+    Node info;
+    sman.Info(info);
+    info.print();
+    EXPECT_EQ(info["saves/pending"].to_int(), 0);
+    EXPECT_EQ(info["saves/completed"].to_int(), 1);
+    EXPECT_EQ(info["saves/failed"].to_int(), 0);
+
+    sman.Close();
+
+    string root_file = output_path + ".cycle_000000.root";
+    EXPECT_TRUE(conduit::utils::is_file(root_file));
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_2d_hdf5, test_2d_serial_hdf5_pipeline_link_unchanged)
+{
+    Node data, verify_info;
+    conduit::blueprint::mesh::examples::braid("quads",100,100,0,data);
+    data["state/domain_id"] = (uint64) 0;
+    data["state/cycle"]     = (uint64) 0;
+    
+    EXPECT_TRUE(conduit::blueprint::mesh::verify(data,verify_info));
+
+    string output_path = prepare_output_dir();
+    output_path = conduit::utils::join_file_path(output_path,
+                                                 "test_save_hdf5_link");
+
+    Node actions;
+    Node &save = actions.append();
+    save["action"]         = "save";
+    save["output_path"]    = output_path;
+    save["link_unchanged"] = "true";
+
+    Node open_opts;
+    open_opts["pipeline/type"] = "blueprint_hdf5";
+    
+    Strawman sman;
+    sman.Open(open_opts);
+    sman.Publish(data);
+    sman.Execute(actions);
+
+    // only the state changes, the mesh is linked to the first save
+    data["state/cycle"] = (uint64) 1;
+    sman.Publish(data);
+    sman.Execute(actions);
+    sman.Close();
+
+    string domain_file = conduit::utils::join_file_path(
+                            output_path + ".cycle_000001",
+                            "domain_000000.hdf5");
+
+    Node n_load, n_diff;
+    conduit::relay::io::load(domain_file, n_load);
+    EXPECT_FALSE(n_load["coordsets"].diff(data["coordsets"], n_diff));
+    EXPECT_FALSE(n_load["topologies"].diff(data["topologies"], n_diff));
+    EXPECT_EQ(n_load["state/cycle"].to_uint64(), (uint64) 1);
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_2d_hdf5, test_2d_serial_hdf5_pipeline_raw)
+{
+    Node data, verify_info;
+    conduit::blueprint::mesh::examples::braid("quads",100,100,0,data);
+    data["state/domain_id"] = (uint64) 0;
+    data["state/cycle"]     = (uint64) 0;
+    
+    EXPECT_TRUE(conduit::blueprint::mesh::verify(data,verify_info));
+
+    string output_path = prepare_output_dir();
+    output_path = conduit::utils::join_file_path(output_path,
+                                                 "test_save_hdf5_raw");
+
+    Node actions;
+    Node &save = actions.append();
+    save["action"]      = "save";
+    save["output_path"] = output_path;
+    save["protocol"]    = "raw";
+
+    Node open_opts;
+    open_opts["pipeline/type"] = "blueprint_hdf5";
+    
+    Strawman sman;
+    sman.Open(open_opts);
+    sman.Publish(data);
+    sman.Execute(actions);
+    sman.Close();
+
+    Node root;
+    conduit::relay::io::load(output_path + ".cycle_000000.root", 
+                             "hdf5",
+                             root);
+    EXPECT_EQ(root["protocol/name"].as_string(), "strawman_raw");
+
+    string domain_file = conduit::utils::join_file_path(
+                            output_path + ".cycle_000000",
+                            "domain_000000.raw");
+
+    // the arrays of the reloaded tree live in the mapped file
+    RawFile raw_file;
+    raw_file.Open(domain_file);
+    Node &n_load = raw_file.Data();
+    Node n_diff;
+    EXPECT_FALSE(n_load.diff(data, n_diff));
+    EXPECT_TRUE(conduit::blueprint::mesh::verify(n_load,verify_info));
+    raw_file.Close();
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_2d_hdf5, test_2d_serial_hdf5_pipeline_compression)
+{
+    Node data, verify_info;
+    conduit::blueprint::mesh::examples::braid("quads",100,100,0,data);
+    data["state/domain_id"] = (uint64) 0;
+    data["state/cycle"]     = (uint64) 0;
+    
+    EXPECT_TRUE(conduit::blueprint::mesh::verify(data,verify_info));
+
+    string output_path = prepare_output_dir();
+    output_path = conduit::utils::join_file_path(output_path,
+                                                 "test_save_hdf5_compression");
+
+    Node actions;
+    Node &save = actions.append();
+    save["action"]      = "save";
+    save["output_path"] = output_path;
+    save["compression/gzip"]       = 6;
+    save["compression/shuffle"]    = "true";
+    save["compression/chunk_size"] = 1024;
+    save["compression/topology"]   = "false";
+    actions.print();
+
+    Node open_opts;
+    open_opts["pipeline/type"] = "blueprint_hdf5";
+    
+    Strawman sman;
+    sman.Open(open_opts);
+    sman.Publish(data);
+    sman.Execute(actions);
+
+    Node info;
+    sman.Info(info);
+    info.print();
+    EXPECT_TRUE(info.has_path("saves/last_write/fields/braid/values/ratio"));
+    EXPECT_FALSE(info.has_path("saves/last_write/topologies"));
+    sman.Close();
+
+    string domain_file = conduit::utils::join_file_path(
+                            output_path + ".cycle_000000",
+                            "domain_000000.hdf5");
+
+    // compression is transparent to readers
+    Node n_load, n_diff;
+    conduit::relay::io::load(domain_file, n_load);
+    EXPECT_FALSE(n_load["fields"].diff(data["fields"], n_diff));
+    EXPECT_FALSE(n_load["topologies"].diff(data["topologies"], n_diff));
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_2d_hdf5, test_2d_serial_hdf5_pipeline_lossy)
+{
+    Node data, verify_info;
+    conduit::blueprint::mesh::examples::braid("quads",100,100,0,data);
+    data["state/domain_id"] = (uint64) 0;
+    data["state/cycle"]     = (uint64) 0;
+    
+    EXPECT_TRUE(conduit::blueprint::mesh::verify(data,verify_info));
+
+    string output_path = prepare_output_dir();
+    output_path = conduit::utils::join_file_path(output_path,
+                                                 "test_save_hdf5_lossy");
+
+    float64 error_bound = 1e-3;
+
+    Node actions;
+    Node &save = actions.append();
+    save["action"]      = "save";
+    save["output_path"] = output_path;
+    save["compression/lossy/error_bound"] = error_bound;
+    save["compression/lossy/fields"]      = "braid";
+
+    Node open_opts;
+    open_opts["pipeline/type"] = "blueprint_hdf5";
+    
+    Strawman sman;
+    sman.Open(open_opts);
+    sman.Publish(data);
+    sman.Execute(actions);
+
+    Node info;
+    sman.Info(info);
+    info.print();
+    EXPECT_TRUE(info.has_path("saves/lossy/braid/ratio"));
+    EXPECT_LE(info["saves/lossy/braid/max_error"].to_float64(), error_bound);
+    sman.Close();
+
+    string domain_file = conduit::utils::join_file_path(
+                            output_path + ".cycle_000000",
+                            "domain_000000.hdf5");
+
+    Node n_load;
+    conduit::relay::io::load(domain_file, n_load);
+    EXPECT_TRUE(lossy_is_encoded(n_load["fields/braid/values"]));
+    // only the selected field is encoded
+    EXPECT_FALSE(lossy_is_encoded(n_load["fields/radial/values"]));
+
+    lossy_decode_fields(n_load);
+    EXPECT_TRUE(conduit::blueprint::mesh::verify(n_load,verify_info));
+
+    const float64 *orig    = data["fields/braid/values"].as_float64_ptr();
+    const float64 *decoded = n_load["fields/braid/values"].as_float64_ptr();
+    index_t num_vals = data["fields/braid/values"].dtype().number_of_elements();
+    float64 max_error = 0.0;
+    for(index_t i = 0; i < num_vals; ++i)
+    {
+        max_error = std::max(max_error, fabs(orig[i] - decoded[i]));
+    }
+    EXPECT_LE(max_error, error_bound);
+}
+
+//-----------------------------------------------------------------------------
+// the braid example, with values that differ from cycle to cycle
+//-----------------------------------------------------------------------------
+void
+create_replay_cycle(int cycle, Node &data)
+{
+    data.reset();
+    conduit::blueprint::mesh::examples::braid("quads",50,50,0,data);
+    data["state/domain_id"] = (uint64) 0;
+    data["state/cycle"]     = (uint64) cycle;
+
+    float64 *vals = data["fields/braid/values"].as_float64_ptr();
+    index_t num_vals = data["fields/braid/values"].dtype().number_of_elements();
+    for(index_t i = 0; i < num_vals; ++i)
+    {
+        vals[i] += (float64) cycle;
+    }
+}
+
+//-----------------------------------------------------------------------------
+float64
+max_abs_diff(const Node &a, const Node &b)
+{
+    const float64 *a_vals = a.as_float64_ptr();
+    const float64 *b_vals = b.as_float64_ptr();
+    index_t num_vals = a.dtype().number_of_elements();
+    EXPECT_EQ(num_vals, b.dtype().number_of_elements());
+
+    float64 res = 0.0;
+    for(index_t i = 0; i < num_vals; ++i)
+    {
+        res = std::max(res, fabs(a_vals[i] - b_vals[i]));
+    }
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_test_2d_hdf5, test_2d_serial_hdf5_replay)
+{
+    const int num_cycles = 3;
+    const float64 error_bound = 1e-3;
+
+    // file per domain, raw and lossy saves
+    const char *modes[3] = {"domain", "raw", "lossy"};
+
+    for(int m = 0; m < 3; ++m)
+    {
+        string mode = modes[m];
+        string output_path = prepare_output_dir();
+        output_path = conduit::utils::join_file_path(output_path,
+                                                     "test_replay_" + mode);
+
+        Node actions;
+        Node &save = actions.append();
+        save["action"]      = "save";
+        save["output_path"] = output_path;
+        if(mode == "raw")
+        {
+            save["protocol"] = "raw";
+        }
+        else if(mode == "lossy")
+        {
+            save["compression/lossy/error_bound"] = error_bound;
+            save["compression/lossy/fields"]      = "braid";
+        }
+
+        Node open_opts;
+        open_opts["pipeline/type"] = "blueprint_hdf5";
+
+        Node data;
+        Strawman sman;
+        sman.Open(open_opts);
+        for(int c = 0; c < num_cycles; ++c)
+        {
+            create_replay_cycle(c, data);
+            sman.Publish(data);
+            sman.Execute(actions);
+        }
+        sman.Close();
+
+        // replay the cycles into plain saves we can compare
+        string replay_path = output_path + "_replay";
+
+        Node replay_opts;
+        for(int c = 0; c < num_cycles; ++c)
+        {
+            char root_file[64];
+            snprintf(root_file, sizeof(root_file), ".cycle_%06d.root", c);
+            replay_opts["root_files"].append() = output_path + root_file;
+        }
+        replay_opts["strawman_options/pipeline/type"] = "blueprint_hdf5";
+        Node &resave = replay_opts["actions"].append();
+        resave["action"]      = "save";
+        resave["output_path"] = replay_path;
+
+        Replay replay;
+        replay.Run(replay_opts);
+
+        const Node &timings = replay.Timings();
+        timings.print();
+        EXPECT_TRUE(timings.has_child("open"));
+        EXPECT_TRUE(timings.has_child("close"));
+        EXPECT_TRUE(timings.has_path("total/execute"));
+        EXPECT_EQ(timings["cycles"].number_of_children(), (index_t) num_cycles);
+
+        for(int c = 0; c < num_cycles; ++c)
+        {
+            const Node &cycle = timings["cycles"][c];
+            EXPECT_TRUE(cycle.has_child("load"));
+            EXPECT_TRUE(cycle.has_child("publish"));
+            EXPECT_TRUE(cycle.has_child("execute"));
+            EXPECT_GE(cycle["load"].to_float64(), 0.0);
+
+            char cycle_dir[64];
+            snprintf(cycle_dir, sizeof(cycle_dir), ".cycle_%06d", c);
+            string domain_file = conduit::utils::join_file_path(
+                                    replay_path + cycle_dir,
+                                    "domain_000000.hdf5");
+
+            Node n_load, n_diff;
+            conduit::relay::io::load(domain_file, n_load);
+
+            create_replay_cycle(c, data);
+            EXPECT_EQ(n_load["state/cycle"].to_int(), c);
+            EXPECT_FALSE(n_load["coordsets"].diff(data["coordsets"], n_diff));
+            EXPECT_FALSE(n_load["fields/radial"].diff(data["fields/radial"], 
+                                                      n_diff));
+
+            float64 max_error = max_abs_diff(n_load["fields/braid/values"],
+                                             data["fields/braid/values"]);
+            if(mode == "lossy")
+            {
+                EXPECT_LE(max_error, error_bound);
+            }
+            else
+            {
+                EXPECT_EQ(max_error, 0.0);
+            }
+        }
+    }
+}
@@ -52,6 +52,8 @@
 #include "gtest/gtest.h"
 
 #include <strawman.hpp>
+#include <strawman_web_server.hpp>
+#include <strawman_web_stream_policy.hpp>
 
 #include <iostream>
 #include <math.h>
@@ -133,6 +135,299 @@ TEST(strawman_web, test_strawman_web_launch)
 }
 
 
+//-----------------------------------------------------------------------------
+// builds a single websocket frame, using the given length encoding:
+// 0 (7-bit), 126 (16-bit) or 127 (64-bit)
+//-----------------------------------------------------------------------------
+std::string
+ws_frame(unsigned char opcode,
+         const std::string &payload,
+         int len_code,
+         bool masked,
+         unsigned long long len)
+{
+    std::string res;
+    res.push_back((char)(0x80 | opcode));
+
+    unsigned char mask_bit = masked ? 0x80 : 0x00;
+    if(len_code == 126)
+    {
+        res.push_back((char)(mask_bit | 126));
+        res.push_back((char)((len >> 8) & 0xFF));
+        res.push_back((char)(len & 0xFF));
+    }
+    else if(len_code == 127)
+    {
+        res.push_back((char)(mask_bit | 127));
+        for(int i = 7; i >= 0; --i)
+        {
+            res.push_back((char)((len >> (8*i)) & 0xFF));
+        }
+    }
+    else
+    {
+        res.push_back((char)(mask_bit | (unsigned char)len));
+    }
+
+    const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    if(masked)
+    {
+        res.append((const char*)mask, 4);
+    }
+
+    for(size_t i = 0; i < payload.size(); ++i)
+    {
+        unsigned char c = (unsigned char)payload[i];
+        res.push_back((char)(masked ? (c ^ mask[i % 4]) : c));
+    }
+
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_web, test_strawman_web_socket_frames)
+{
+    WebSocket::Frame frame;
+    size_t frame_bytes = 0;
+
+    std::string msg = "{\"type\":\"camera\"}";
+    std::string large(300, 'x');
+
+    // 7-bit length, unmasked and masked
+    std::string buff = ws_frame(0x1, msg, 0, false, msg.size());
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_OK);
+    EXPECT_EQ(frame.m_opcode, 0x1);
+    EXPECT_TRUE(frame.m_fin);
+    EXPECT_EQ(frame.m_payload, msg);
+    EXPECT_EQ(frame_bytes, buff.size());
+
+    buff = ws_frame(0x1, msg, 0, true, msg.size());
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_OK);
+    EXPECT_EQ(frame.m_payload, msg);
+    EXPECT_EQ(frame_bytes, buff.size());
+
+    // 16-bit length
+    buff = ws_frame(0x1, large, 126, true, large.size());
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_OK);
+    EXPECT_EQ(frame.m_payload, large);
+    EXPECT_EQ(frame_bytes, buff.size());
+
+    // 64-bit length
+    buff = ws_frame(0x1, large, 127, false, large.size());
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_OK);
+    EXPECT_EQ(frame.m_payload, large);
+    EXPECT_EQ(frame_bytes, buff.size());
+
+    // a second frame behind the first is left alone
+    std::string two = ws_frame(0x9, "", 0, true, 0) + 
+                      ws_frame(0x1, msg, 0, true, msg.size());
+    EXPECT_EQ(WebSocket::ParseFrame(two, frame, frame_bytes),
+              WebSocket::FRAME_OK);
+    EXPECT_EQ(frame.m_opcode, 0x9);
+    EXPECT_EQ(frame_bytes, 6u);
+    EXPECT_EQ(WebSocket::ParseFrame(two.substr(frame_bytes),
+                                    frame,
+                                    frame_bytes),
+              WebSocket::FRAME_OK);
+    EXPECT_EQ(frame.m_payload, msg);
+
+    // truncated frames, at every length
+    buff = ws_frame(0x1, large, 127, true, large.size());
+    for(size_t i = 0; i < buff.size(); ++i)
+    {
+        EXPECT_EQ(WebSocket::ParseFrame(buff.substr(0, i), 
+                                        frame, 
+                                        frame_bytes),
+                  WebSocket::FRAME_INCOMPLETE);
+    }
+
+    // oversized frames are rejected from the header alone
+    const size_t max_bytes = WebSocket::MAX_RECV_PAYLOAD_BYTES;
+    buff = ws_frame(0x1, "", 126, true, 0xFFFF);
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_TOO_LARGE);
+
+    buff = ws_frame(0x1, "", 127, false, max_bytes + 1);
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_TOO_LARGE);
+
+    // lengths that would wrap offset + len
+    buff = ws_frame(0x1, "", 127, true, 0xFFFFFFFFFFFFFFFFull);
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_TOO_LARGE);
+
+    buff = ws_frame(0x1, "", 127, false, 0x8000000000000000ull);
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_TOO_LARGE);
+
+    // right at the limit is fine
+    std::string limit(max_bytes, 'y');
+    buff = ws_frame(0x2, limit, 127, true, limit.size());
+    EXPECT_EQ(WebSocket::ParseFrame(buff, frame, frame_bytes),
+              WebSocket::FRAME_OK);
+    EXPECT_EQ(frame.m_payload, limit);
+}
+
+//-----------------------------------------------------------------------------
+// offers and sends count frames of num_bytes, one every 1/10 s
+//-----------------------------------------------------------------------------
+void
+send_frames(WebStreamPolicy &policy,
+            double &now,
+            int count,
+            size_t num_bytes)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        now += 0.1;
+        policy.FrameOffered(now);
+        policy.FrameSent(now, num_bytes, 0.001);
+    }
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_web, test_strawman_web_stream_policy_max_fps)
+{
+    WebStreamPolicy policy;
+
+    Node opts;
+    opts["web/max_fps"] = 10.0;
+    policy.SetOptions(opts);
+
+    // nothing was sent yet
+    EXPECT_TRUE(policy.FrameDue(1.0));
+
+    policy.FrameSent(1.0, 1000, 0.001);
+    EXPECT_NEAR(policy.NextFrameTime(), 1.1, 1.0e-9);
+    EXPECT_FALSE(policy.FrameDue(1.0));
+    EXPECT_FALSE(policy.FrameDue(1.05));
+    EXPECT_TRUE(policy.FrameDue(1.11));
+
+    // unlimited
+    opts["web/max_fps"] = 0.0;
+    policy.SetOptions(opts);
+    EXPECT_TRUE(policy.FrameDue(1.0));
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_web, test_strawman_web_stream_policy_downgrade)
+{
+    WebStreamPolicy policy;
+
+    // 1 MB/s at 10 fps leaves 100 KB per frame
+    Node opts;
+    opts["web/format"]        = "raw";
+    opts["web/max_fps"]       = 10.0;
+    opts["web/max_bandwidth"] = 1.0;
+    policy.SetOptions(opts);
+
+    EXPECT_TRUE(policy.UseRaw());
+    EXPECT_EQ(policy.Downscale(), 1);
+
+    double now = 1.0;
+    send_frames(policy, now, 1, 50000);
+    EXPECT_TRUE(policy.UseRaw());
+
+    // each frame over budget drops one level right away:
+    // raw -> png -> png at 1/2, 1/4 and 1/8 resolution
+    send_frames(policy, now, 1, 200000);
+    EXPECT_FALSE(policy.UseRaw());
+    EXPECT_EQ(policy.Downscale(), 1);
+
+    int downscales[3] = {2, 4, 8};
+    for(int i = 0; i < 3; ++i)
+    {
+        send_frames(policy, now, 1, 200000);
+        EXPECT_FALSE(policy.UseRaw());
+        EXPECT_EQ(policy.Downscale(), downscales[i]);
+    }
+
+    // the lowest level is as low as it goes
+    send_frames(policy, now, 1, 200000);
+    EXPECT_EQ(policy.Downscale(), 8);
+
+    // slow encodes count as over budget too
+    policy.Reset();
+    EXPECT_TRUE(policy.UseRaw());
+    now += 0.1;
+    policy.FrameOffered(now);
+    policy.FrameSent(now, 1000, 0.5);
+    EXPECT_FALSE(policy.UseRaw());
+
+    // the budget follows the rate the simulation offers frames at,
+    // at one frame per second the same frame fits
+    policy.Reset();
+    for(int i = 0; i < 5; ++i)
+    {
+        now += 1.0;
+        policy.FrameOffered(now);
+        policy.FrameSent(now, 200000, 0.001);
+    }
+    EXPECT_TRUE(policy.UseRaw());
+
+    // a measured client throughput below max_bandwidth lowers the budget
+    policy.Reset();
+    policy.SetThroughput(100000.0);
+    now += 1.0;
+    policy.FrameOffered(now);
+    policy.FrameSent(now, 200000, 0.001);
+    EXPECT_FALSE(policy.UseRaw());
+}
+
+//-----------------------------------------------------------------------------
+TEST(strawman_web, test_strawman_web_stream_policy_upgrade)
+{
+    WebStreamPolicy policy;
+
+    Node opts;
+    opts["web/format"]        = "raw";
+    opts["web/max_fps"]       = 10.0;
+    opts["web/max_bandwidth"] = 1.0;
+    policy.SetOptions(opts);
+
+    double now = 1.0;
+    send_frames(policy, now, 1, 200000);
+    EXPECT_FALSE(policy.UseRaw());
+
+    // frames that fit with headroom try the next level up after 10 
+    // frames, each probe that fails right away doubles the wait, up 
+    // to 320 frames (MAX_UPGRADE_FRAMES)
+    int waits[7] = {10, 20, 40, 80, 160, 320, 320};
+    for(int i = 0; i < 7; ++i)
+    {
+        send_frames(policy, now, waits[i] - 1, 1000);
+        EXPECT_FALSE(policy.UseRaw());
+
+        send_frames(policy, now, 1, 1000);
+        EXPECT_TRUE(policy.UseRaw());
+
+        send_frames(policy, now, 1, 200000);
+        EXPECT_FALSE(policy.UseRaw());
+    }
+
+    // a probe that holds up resets the wait
+    send_frames(policy, now, 320, 1000);
+    EXPECT_TRUE(policy.UseRaw());
+    send_frames(policy, now, 10, 1000);
+    EXPECT_TRUE(policy.UseRaw());
+
+    send_frames(policy, now, 1, 200000);
+    EXPECT_FALSE(policy.UseRaw());
+    send_frames(policy, now, 10, 1000);
+    EXPECT_TRUE(policy.UseRaw());
+
+    // frames that fit, but without headroom, don't count
+    send_frames(policy, now, 1, 200000);
+    EXPECT_FALSE(policy.UseRaw());
+    send_frames(policy, now, 100, 80000);
+    EXPECT_FALSE(policy.UseRaw());
+}
+
+
 //-----------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {